@@ -0,0 +1,70 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t wakeups = 20000;
+
+//! Register `fds` file descriptors, of which one becomes readable at a time, and time the wakeups
+void main_loop(const EventLoop::Backend backend, const size_t fds) {
+    int active_pipe[2];
+    int idle_pipe[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(active_pipe)));
+    SystemCall("pipe", ::pipe(static_cast<int *>(idle_pipe)));
+    FileDescriptor active_read{active_pipe[0]}, active_write{active_pipe[1]};
+    FileDescriptor idle_read{idle_pipe[0]}, idle_write{idle_pipe[1]};
+
+    EventLoop loop{backend};
+    loop.add_rule(active_read, Direction::In, [&] { active_read.read(1); });
+
+    // the idle fds are separate descriptors for one pipe that is never written to
+    vector<FileDescriptor> idle;
+    idle.reserve(fds - 1);
+    for (size_t i = 0; i + 1 < fds; i++) {
+        idle.emplace_back(SystemCall("dup", ::dup(idle_read.fd_num())));
+        loop.add_rule(idle.back(), Direction::In, [] {});
+    }
+
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < wakeups; i++) {
+        active_write.write("x");
+        if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+            throw runtime_error("unexpected result from wait_next_event");
+        }
+    }
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+
+    cout << fixed << setprecision(2);
+    const string name = backend == EventLoop::Backend::Poll    ? "poll"
+                        : backend == EventLoop::Backend::Epoll ? "epoll"
+                                                               : "io_uring";
+    cout << left << setw(8) << name << right << " with " << setw(5) << fds
+         << " fds: " << setw(9) << static_cast<double>(duration) / wakeups / 1000 << " us per wakeup\n";
+}
+
+int main() {
+    try {
+        for (const size_t fds : {10, 100, 10000}) {
+            main_loop(EventLoop::Backend::Poll, fds);
+            main_loop(EventLoop::Backend::Epoll, fds);
+            if (EventLoop{EventLoop::Backend::IoUring}.backend() == EventLoop::Backend::IoUring) {
+                main_loop(EventLoop::Backend::IoUring, fds);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
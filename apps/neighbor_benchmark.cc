@@ -0,0 +1,83 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "network_interface.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t sends = 1000000;
+static constexpr size_t ticks = 10000;
+
+static const EthernetAddress local_ethernet{0x02, 0, 0, 0, 0, 1};
+static constexpr uint32_t local_ip = 0x0a000001;  // 10.0.0.1; the neighbors are 10.1.0.0 and up
+
+//! An ARP reply from neighbor `n`, which teaches the interface its Ethernet address
+static EthernetFrame arp_reply(const uint32_t n) {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = {0x02, 1, uint8_t(n >> 24), uint8_t(n >> 16), uint8_t(n >> 8), uint8_t(n)};
+    arp.sender_ip_address = 0x0a010000 + n;
+    arp.target_ethernet_address = local_ethernet;
+    arp.target_ip_address = local_ip;
+
+    EthernetFrame frame;
+    frame.header().type = EthernetHeader::TYPE_ARP;
+    frame.header().src = arp.sender_ethernet_address;
+    frame.header().dst = local_ethernet;
+    frame.payload() = BufferList{arp.serialize()};
+    return frame;
+}
+
+//! Time sending datagrams to, and ticking with, `neighbors` neighbors in the ARP cache
+void main_loop(const uint32_t neighbors) {
+    NetworkInterface iface{local_ethernet, Address::from_ipv4_numeric(local_ip)};
+    for (uint32_t n = 0; n < neighbors; n++) {
+        iface.recv_frame(arp_reply(n));
+    }
+
+    vector<Address> next_hops;
+    for (uint32_t n = 0; n < neighbors; n++) {
+        next_hops.push_back(Address::from_ipv4_numeric(0x0a010000 + n));
+    }
+    InternetDatagram dgram;
+    dgram.header().src = local_ip;
+    dgram.header().len = dgram.header().hlen * 4;
+
+    auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < sends; i++) {
+        dgram.header().dst = 0x0a010000 + i % neighbors;
+        iface.send_datagram(dgram, next_hops[i % neighbors]);
+        iface.frames_out().pop();
+    }
+    const auto send_duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+
+    first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < ticks; i++) {
+        iface.tick(1);
+    }
+    const auto tick_duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+
+    cout << fixed << setprecision(1);
+    cout << setw(6) << neighbors << " neighbors: " << setw(7) << static_cast<double>(send_duration) / sends
+         << " ns per send, " << setw(9) << static_cast<double>(tick_duration) / ticks << " ns per tick\n";
+}
+
+int main() {
+    try {
+        for (const uint32_t neighbors : {16, 1024, 16384, 65536}) {
+            main_loop(neighbors);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
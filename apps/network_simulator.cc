@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <list>
+#include <queue>
 #include <unordered_map>
 
 using namespace std;
@@ -35,12 +36,13 @@ EthernetAddress random_router_ethernet_address() {
 
 uint32_t ip(const string &str) { return Address{str}.ipv4_numeric(); }
 
-template <typename T>
-void clear(T &queue1, T &queue2) {
-    while (not queue1.empty()) {
-        queue1.pop();
-        queue2.pop();
+//! Take the frames an interface has sent so far (it may send more as they are delivered)
+queue<EthernetFrame> take(SpscQueue<EthernetFrame> &frames_out) {
+    queue<EthernetFrame> taken;
+    for (; not frames_out.empty(); frames_out.pop()) {
+        taken.push(move(frames_out.front()));
     }
+    return taken;
 }
 
 string summary(const EthernetFrame &frame) {
@@ -159,13 +161,10 @@ class Network {
                          AsyncNetworkInterface &x,
                          const string &y_name,
                          AsyncNetworkInterface &y) {
-        auto x_frames = x.frames_out(), y_frames = y.frames_out();
+        auto x_frames = take(x.frames_out()), y_frames = take(y.frames_out());
 
         deliver(x_name, x_frames, y_name, y);
         deliver(y_name, y_frames, x_name, x);
-
-        clear(x_frames, x.frames_out());
-        clear(y_frames, y.frames_out());
     }
 
     void exchange_frames(const string &x_name,
@@ -174,7 +173,7 @@ class Network {
                          AsyncNetworkInterface &y,
                          const string &z_name,
                          AsyncNetworkInterface &z) {
-        auto x_frames = x.frames_out(), y_frames = y.frames_out(), z_frames = z.frames_out();
+        auto x_frames = take(x.frames_out()), y_frames = take(y.frames_out()), z_frames = take(z.frames_out());
 
         deliver(x_name, x_frames, y_name, y);
         deliver(x_name, x_frames, z_name, z);
@@ -184,10 +183,6 @@ class Network {
 
         deliver(z_name, z_frames, x_name, x);
         deliver(z_name, z_frames, y_name, y);
-
-        clear(x_frames, x.frames_out());
-        clear(y_frames, y.frames_out());
-        clear(z_frames, z.frames_out());
     }
 
     void deliver(const string &src_name,
@@ -213,13 +208,13 @@ class Network {
         , uun3_id(_router.add_interface({random_router_ethernet_address(), {"198.178.229.1"}}))
         , hs4_id(_router.add_interface({random_router_ethernet_address(), {"143.195.0.2"}}))
         , mit5_id(_router.add_interface({random_router_ethernet_address(), {"128.30.76.255"}})) {
-        _hosts.insert({"applesauce", {"applesauce", {"10.0.0.2"}, {"10.0.0.1"}}});
-        _hosts.insert({"default_router", {"default_router", {"171.67.76.1"}, {"0"}}});
+        _hosts.emplace("applesauce", Host{"applesauce", {"10.0.0.2"}, {"10.0.0.1"}});
+        _hosts.emplace("default_router", Host{"default_router", {"171.67.76.1"}, {"0"}});
         ;
-        _hosts.insert({"cherrypie", {"cherrypie", {"192.168.0.2"}, {"192.168.0.1"}}});
-        _hosts.insert({"hs_router", {"hs_router", {"143.195.0.1"}, {"0"}}});
-        _hosts.insert({"dm42", {"dm42", {"198.178.229.42"}, {"198.178.229.1"}}});
-        _hosts.insert({"dm43", {"dm43", {"198.178.229.43"}, {"198.178.229.1"}}});
+        _hosts.emplace("cherrypie", Host{"cherrypie", {"192.168.0.2"}, {"192.168.0.1"}});
+        _hosts.emplace("hs_router", Host{"hs_router", {"143.195.0.1"}, {"0"}});
+        _hosts.emplace("dm42", Host{"dm42", {"198.178.229.42"}, {"198.178.229.1"}});
+        _hosts.emplace("dm43", Host{"dm43", {"198.178.229.43"}, {"198.178.229.1"}});
 
         _router.add_route(ip("0.0.0.0"), 0, host("default_router").address(), default_id);
         _router.add_route(ip("10.0.0.0"), 8, {}, eth0_id);
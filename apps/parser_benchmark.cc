@@ -0,0 +1,85 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+#include "tcp_header.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t passes = 2000;
+
+//! The frames of a capture file of Ethernet frames (the classic pcap format, in this host's byte order)
+static vector<Buffer> read_capture(const string &filename) {
+    ifstream file{filename, ios::binary};
+    const string capture{istreambuf_iterator<char>{file}, istreambuf_iterator<char>{}};
+    const auto word = [&](const size_t offset) {
+        uint32_t value = 0;
+        capture.copy(reinterpret_cast<char *>(&value), sizeof(value), offset);
+        return value;
+    };
+    if (capture.size() < 24 or word(0) != 0xa1b2c3d4 or word(20) != 1) {
+        throw runtime_error(filename + " is not a capture of Ethernet frames");
+    }
+
+    vector<Buffer> frames;
+    for (size_t offset = 24; offset + 16 <= capture.size();) {
+        const size_t length = word(offset + 8);
+        offset += 16;
+        frames.emplace_back(capture.substr(offset, length));
+        offset += length;
+    }
+    return frames;
+}
+
+//! Parse the headers of every frame in the capture `passes` times over, and report the time per frame
+int main(int argc, char **argv) {
+    try {
+        const string filename = argc > 1 ? argv[1] : "tests/ipv4_parser.data";
+        const vector<Buffer> frames = read_capture(filename);
+
+        size_t ipv4 = 0, tcp = 0, arp = 0;
+        const auto first_time = high_resolution_clock::now();
+        for (size_t pass = 0; pass < passes; pass++) {
+            for (const auto &frame : frames) {
+                NetParser p{frame};
+                EthernetHeader ethernet;
+                if (ethernet.parse(p) != ParseResult::NoError) {
+                    continue;
+                }
+                if (ethernet.type == EthernetHeader::TYPE_ARP) {
+                    ARPMessage message;
+                    arp += message.parse(p.buffer()) == ParseResult::NoError;
+                } else if (ethernet.type == EthernetHeader::TYPE_IPv4) {
+                    IPv4Header ip;
+                    if (ip.parse(p) != ParseResult::NoError) {
+                        continue;
+                    }
+                    ipv4++;
+                    TCPHeader header;
+                    tcp += ip.proto == IPv4Header::PROTO_TCP and header.parse(p) == ParseResult::NoError;
+                }
+            }
+        }
+        const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+
+        cout << fixed << setprecision(1);
+        cout << frames.size() << " frames (" << ipv4 / passes << " IPv4, " << tcp / passes << " TCP, "
+             << arp / passes << " ARP): " << double(duration) / (passes * frames.size()) << " ns per frame\n";
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "router.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t interfaces = 8;
+static constexpr size_t datagrams = 400000;
+static constexpr size_t in_flight = 4096;
+static constexpr size_t payload_size = 512;
+
+//! The router's address on network 10.0.`i`.0/24, and that of the host it reaches there
+static uint32_t router_ip(const size_t i) { return 0x0a000001 + (i << 8); }
+static uint32_t host_ip(const size_t i) { return 0x0a000002 + (i << 8); }
+static EthernetAddress router_ethernet(const size_t i) { return {0x02, 0, 0, 0, 1, uint8_t(i)}; }
+static EthernetAddress host_ethernet(const size_t i) { return {0x02, 0, 0, 0, 2, uint8_t(i)}; }
+
+//! An ARP reply from the host on network `i`, which teaches the router its Ethernet address
+static EthernetFrame arp_reply(const size_t i) {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = host_ethernet(i);
+    arp.sender_ip_address = host_ip(i);
+    arp.target_ethernet_address = router_ethernet(i);
+    arp.target_ip_address = router_ip(i);
+
+    EthernetFrame frame;
+    frame.header().type = EthernetHeader::TYPE_ARP;
+    frame.header().src = arp.sender_ethernet_address;
+    frame.header().dst = arp.target_ethernet_address;
+    frame.payload() = BufferList{arp.serialize()};
+    return frame;
+}
+
+//! A frame from the host on network `i` to the one on the next network, through the router
+static EthernetFrame crossing_frame(const size_t i) {
+    InternetDatagram dgram;
+    dgram.header().src = host_ip(i);
+    dgram.header().dst = host_ip((i + 1) % interfaces);
+    dgram.payload() = string(payload_size, 'x');
+    dgram.header().len = dgram.header().hlen * 4 + payload_size;
+
+    EthernetFrame frame;
+    frame.header().type = EthernetHeader::TYPE_IPv4;
+    frame.header().src = host_ethernet(i);
+    frame.header().dst = router_ethernet(i);
+    frame.payload() = BufferList{Buffer{dgram.serialize().concatenate()}};
+    return frame;
+}
+
+//! Forward datagrams between the hosts of `interfaces` networks, each to the next network, with `workers`
+//! threads routing in parallel (or route() on this thread, for none), and report the datagrams forwarded
+//! per second. This thread plays the hosts, delivering frames to the router and draining what it sends.
+void main_loop(const size_t workers) {
+    Router router;
+    for (size_t i = 0; i < interfaces; i++) {
+        router.add_interface({router_ethernet(i), Address::from_ipv4_numeric(router_ip(i))});
+        router.add_route(router_ip(i) & 0xffffff00, 24, {}, i);
+        router.interface(i).recv_frame(arp_reply(i));
+    }
+    vector<EthernetFrame> frames;
+    for (size_t i = 0; i < interfaces; i++) {
+        frames.push_back(crossing_frame(i));
+    }
+
+    if (workers > 0) {
+        router.start(workers);
+    }
+    size_t sent = 0, forwarded = 0;
+    const auto first_time = high_resolution_clock::now();
+    while (forwarded < datagrams) {
+        for (; sent < datagrams and sent - forwarded < in_flight; sent++) {
+            const size_t i = sent % interfaces;
+            if (workers > 0) {
+                router.deliver_frame(i, EthernetFrame{frames[i]});
+            } else {
+                router.interface(i).recv_frame(frames[i]);
+            }
+        }
+        if (workers == 0) {
+            router.route();
+        }
+        for (size_t i = 0; i < interfaces; i++) {
+            for (auto &frames_out = router.interface(i).frames_out(); not frames_out.empty(); frames_out.pop()) {
+                forwarded++;
+            }
+        }
+    }
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    router.stop();
+
+    cout << fixed << setprecision(2);
+    if (workers == 0) {
+        cout << "route() on one thread: ";
+    } else {
+        cout << setw(9) << workers << " workers: ";
+    }
+    cout << setw(12) << forwarded * 1e9 / duration << " datagrams/s\n";
+}
+
+int main() {
+    try {
+        for (const size_t workers : {0, 1, 2, 4, 8}) {
+            main_loop(workers);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -11,7 +11,8 @@ using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+size_t move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+    const size_t count = x.segments_out().size();
     while (not x.segments_out().empty()) {
         segments.emplace_back(move(x.segments_out().front()));
         x.segments_out().pop();
@@ -26,10 +27,13 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
         }
     }
     segments.clear();
+    return count;
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const uint16_t ack_delay, const uint16_t mss = TCPConfig::MAX_PAYLOAD_SIZE) {
     TCPConfig config;
+    config.ack_delay = ack_delay;
+    config.mss = mss;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -42,6 +46,8 @@ void main_loop(const bool reorder) {
     y.end_input_stream();
 
     bool x_closed = false;
+    size_t acks_sent = 0;
+    size_t segments_sent = 0;
 
     string string_received;
     string_received.reserve(len);
@@ -66,8 +72,8 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
-        move_segments(y, x, segments, false);
+        segments_sent += move_segments(x, y, segments, reorder);
+        acks_sent += move_segments(y, x, segments, false);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
@@ -95,8 +101,18 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    string variant;
+    const bool jumbo = mss > TCPConfig::MAX_PAYLOAD_SIZE;
+    const pair<bool, const char *> variants[] = {
+        {reorder, "reordering"}, {ack_delay > 0, "delayed ACKs"}, {jumbo, "jumbo MSS"}};
+    for (const auto &[on, name] : variants) {
+        if (on) {
+            variant += (variant.empty() ? " with " : ", ") + string(name);
+        }
+    }
+    cout << "CPU-limited throughput" << left << setw(34) << variant << ": " << right << gigabits_per_second
+         << " Gbit/s (" << segments_sent << " segments from sender, " << acks_sent << " from receiver, "
+         << y.acks_saved() << " ACKs saved)\n";
 
     while (x.active() or y.active()) {
         loop();
@@ -105,8 +121,11 @@ void main_loop(const bool reorder) {
 
 int main() {
     try {
-        main_loop(false);
-        main_loop(true);
+        main_loop(false, 0);
+        main_loop(true, 0);
+        main_loop(false, 40);
+        main_loop(true, 40);
+        main_loop(false, 0, TCPConfig::mss_for_mtu(TCPConfig::JUMBO_MTU));
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
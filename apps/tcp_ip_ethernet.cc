@@ -1,4 +1,5 @@
 #include "bidirectional_stream_copy.hh"
+#include "packet_ring.hh"
 #include "tcp_config.hh"
 #include "tcp_sponge_socket.hh"
 #include "tun.hh"
@@ -7,7 +8,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 
@@ -31,7 +34,14 @@ static void show_usage(const char *argv0, const char *msg) {
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
-         << "   -d <tapdev>     Connect to tap <tapdev>                         " << TAP_DFLT << "\n\n"
+         << "   -d <tapdev>     Connect to tap <tapdev>                         " << TAP_DFLT << "\n"
+         << "   -m <mtu>        Size segments for a link MTU of <mtu>           " << TCPConfig::ETHERNET_MTU << "\n"
+         << "                   (e.g. " << TCPConfig::JUMBO_MTU << "; start the tap with TAP_MTU=<mtu>)\n"
+         << "   -M <mss>        Send segments of up to <mss> bytes, in IP       (sized for the MTU)\n"
+         << "                   fragments if they don't fit the MTU\n"
+         << "   -o              Offload TCP checksums and segmentation to tap   (no offload)\n"
+         << "   -r <intf>       Use the packet rings of interface <intf>        (use the tap)\n"
+         << "                   (e.g. one end of a veth pair) instead of a tap\n\n"
 
          << "   -h              Show this message.\n\n";
 
@@ -48,10 +58,14 @@ static void check_argc(int argc, char **argv, int curr, const char *err) {
     }
 }
 
-static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, char **argv) {
+static tuple<TCPConfig, FdAdapterConfig, Address, string, size_t, bool, string> get_config(int argc, char **argv) {
     TCPConfig c_fsm{};
     FdAdapterConfig c_filt{};
     string tapdev = TAP_DFLT;
+    size_t mtu = TCPConfig::ETHERNET_MTU;
+    size_t mss = 0;
+    bool offload = false;
+    string ring_interface;
 
     int curr = 1;
 
@@ -90,6 +104,35 @@ static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, c
             tapdev = argv[curr + 1];
             curr += 2;
 
+        } else if (strncmp("-m", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -m requires one argument.");
+            mtu = strtol(argv[curr + 1], nullptr, 0);
+            if (mtu < 576 or mtu > 65535) {
+                show_usage(argv[0], "ERROR: MTU must be between 576 and 65535.");
+                exit(1);
+            }
+            c_fsm.mss = TCPConfig::mss_for_mtu(mtu);
+            curr += 2;
+
+        } else if (strncmp("-M", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -M requires one argument.");
+            mss = strtol(argv[curr + 1], nullptr, 0);
+            if (mss < 1 or mss > TCPConfig::mss_for_mtu(65535)) {
+                show_usage(argv[0], "ERROR: MSS must be between 1 and 65495.");
+                exit(1);
+            }
+            curr += 2;
+
+        } else if (strncmp("-o", argv[curr], 3) == 0) {
+            offload = true;
+            c_fsm.tso_size = TCPConfig::MAX_TSO_SIZE;
+            curr += 1;
+
+        } else if (strncmp("-r", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -r requires one argument.");
+            ring_interface = argv[curr + 1];
+            curr += 2;
+
         } else if (strncmp("-h", argv[curr], 3) == 0) {
             show_usage(argv[0], nullptr);
             exit(0);
@@ -100,13 +143,17 @@ static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, c
         }
     }
 
+    if (mss != 0) {
+        c_fsm.mss = mss;
+    }
+
     // parse positional command-line arguments
     c_filt.destination = {argv[curr], argv[curr + 1]};
     c_filt.source = {source_address, source_port};
 
     Address next_hop{next_hop_address, "0"};
 
-    return make_tuple(c_fsm, c_filt, next_hop, tapdev);
+    return make_tuple(c_fsm, c_filt, next_hop, tapdev, mtu, offload, ring_interface);
 }
 
 int main(int argc, char **argv) {
@@ -124,15 +171,27 @@ int main(int argc, char **argv) {
         local_ethernet_address.at(0) |= 0x02;  // "10" in last two binary digits marks a private Ethernet address
         local_ethernet_address.at(0) &= 0xfe;
 
-        auto [c_fsm, c_filt, next_hop, tap_dev_name] = get_config(argc, argv);
+        auto [c_fsm, c_filt, next_hop, tap_dev_name, mtu, offload, ring_interface] = get_config(argc, argv);
 
-        TCPOverIPv4OverEthernetSpongeSocket tcp_socket(TCPOverIPv4OverEthernetAdapter(
-            TCPOverIPv4OverEthernetAdapter(TapFD(tap_dev_name), local_ethernet_address, c_filt.source, next_hop)));
+        const auto run = [&, c_fsm = c_fsm, c_filt = c_filt](auto &tcp_socket) {
+            tcp_socket.connect(c_fsm, c_filt);
 
-        tcp_socket.connect(c_fsm, c_filt);
+            bidirectional_stream_copy(tcp_socket);
+            tcp_socket.wait_until_closed();
+        };
 
-        bidirectional_stream_copy(tcp_socket);
-        tcp_socket.wait_until_closed();
+        if (not ring_interface.empty()) {
+            if (offload) {
+                throw runtime_error("-o is for a tap, not for packet rings");
+            }
+            TCPOverIPv4OverPacketRingSpongeSocket tcp_socket(TCPOverIPv4OverPacketRingAdapter(
+                make_unique<PacketRing>(ring_interface), local_ethernet_address, c_filt.source, next_hop, mtu));
+            run(tcp_socket);
+        } else {
+            TCPOverIPv4OverEthernetSpongeSocket tcp_socket(TCPOverIPv4OverEthernetAdapter(
+                TapFD(tap_dev_name, false, offload), local_ethernet_address, c_filt.source, next_hop, mtu));
+            run(tcp_socket);
+        }
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
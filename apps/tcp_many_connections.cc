@@ -0,0 +1,101 @@
+#include "tcp_connection_manager.hh"
+#include "util.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr uint16_t server_port = 80;
+
+//! Open `connections` connections at once from one thread to a server in another, each sending
+//! `bytes_per_connection` bytes and closing; both ends are a TCPConnectionManager on one UDP socket
+void main_loop(const TCPConnectionManager::IO io, const size_t connections, const size_t bytes_per_connection) {
+    TCPConfig config;
+    // a loopback round trip takes microseconds; a short timeout also keeps TIME_WAIT (10 timeouts) to a second
+    config.rt_timeout = 100;
+    TCPConnectionManager server{config, Address{"127.0.0.1", 0}, io};
+    TCPConnectionManager client{config, Address{"127.0.0.1", 0}, io};
+    const Address server_address = server.local_address();
+    server.listen(server_port, connections);
+    server.set_accept_handler([&](const uint16_t port) {
+        while (server.accept(port)) {
+        }
+    });
+
+    atomic<size_t> server_done{0};
+    size_t bytes_received = 0;
+    server.set_handler([&](const TCPConnectionManager::FourTuple &, TCPConnection &tcp) {
+        auto &inbound = tcp.inbound_stream();
+        bytes_received += inbound.read(inbound.buffer_size()).size();
+        if (inbound.eof() and tcp.state() == TCPState::State::CLOSE_WAIT) {
+            tcp.end_input_stream();
+        }
+        if (not tcp.active()) {
+            server_done++;
+        }
+    });
+
+    const string chunk(bytes_per_connection, 'x');
+
+    const auto first_time = high_resolution_clock::now();
+
+    thread server_thread([&] { server.run([&] { return server_done < connections; }); });
+
+    for (size_t i = 0; i < connections; i++) {
+        const auto key = client.connect(server_address, server_port);
+        TCPConnection &tcp = *client.connection(key);
+        if (tcp.write(chunk) != chunk.size()) {
+            throw runtime_error("bytes_per_connection must fit in the send buffer");
+        }
+        tcp.end_input_stream();
+        client.flush(key);
+    }
+    // the run is over once the server has closed every connection
+    client.run([&] { return server_done < connections; });
+    server_thread.join();
+
+    const auto final_time = high_resolution_clock::now();
+
+    // let the client's connections finish lingering in TIME_WAIT
+    client.run([&] { return client.size() > 0; });
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    if (bytes_received != connections * bytes_per_connection) {
+        throw runtime_error("expected " + to_string(connections * bytes_per_connection) + " bytes but received " +
+                            to_string(bytes_received));
+    }
+
+    cout << fixed << setprecision(2);
+    cout << (io == TCPConnectionManager::IO::Syscalls ? "syscalls: " : "io_uring: ");
+    cout << connections << " connections of " << bytes_per_connection << " bytes on one thread each way: "
+         << duration / 1e6 << " ms, " << connections * 1e9 / duration << " connections/s, "
+         << 8e9 * bytes_received / duration / 1e6 << " Mbit/s\n";
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        if (argc > 3) {
+            cerr << "Usage: " << argv[0] << " [connections] [bytes per connection]\n";
+            return EXIT_FAILURE;
+        }
+        const size_t connections = argc > 1 ? stoul(argv[1]) : 2000;
+        const size_t bytes_per_connection = argc > 2 ? stoul(argv[2]) : 4096;
+        main_loop(TCPConnectionManager::IO::Syscalls, connections, bytes_per_connection);
+        if (DatagramRing::available()) {
+            main_loop(TCPConnectionManager::IO::IoUring, connections, bytes_per_connection);
+        } else {
+            cout << "io_uring: not available\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include "tcp_connection.hh"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+constexpr size_t len = 4 * 1024 * 1024;
+constexpr size_t write_size = 16;
+constexpr size_t writes_per_rtt = 32;
+constexpr size_t writes_per_flush = 256;
+
+enum class Mode { Plain, Nagle, Cork };
+
+//! Deliver every segment that `x` has queued to `y`; returns the number of data-bearing segments
+size_t move_segments(TCPConnection &x, TCPConnection &y) {
+    size_t data_segments = 0;
+    while (not x.segments_out().empty()) {
+        if (x.segments_out().front().payload().size() > 0) {
+            data_segments++;
+        }
+        y.segment_received(move(x.segments_out().front()));
+        x.segments_out().pop();
+    }
+    return data_segments;
+}
+
+void main_loop(const Mode mode) {
+    TCPConfig config;
+    config.nagle = (mode == Mode::Nagle);
+    TCPConnection x{config}, y{config};
+
+    x.connect();
+    y.end_input_stream();
+    if (mode == Mode::Cork) {
+        x.cork();
+    }
+
+    size_t data_segments = 0;
+    size_t bytes_received = 0;
+    size_t bytes_written = 0;
+
+    auto exchange = [&] {
+        data_segments += move_segments(x, y);
+        move_segments(y, x);
+        bytes_received += y.inbound_stream().read(y.inbound_stream().buffer_size()).size();
+    };
+
+    // the application writes a little at a time; a round trip takes as long as `writes_per_rtt` writes
+    for (size_t i = 0; bytes_written < len; i++) {
+        while (x.remaining_outbound_capacity() < write_size) {
+            exchange();
+            x.tick(1);
+            y.tick(1);
+        }
+        bytes_written += x.write(string(write_size, 'x'));
+        if (mode == Mode::Cork and i % writes_per_flush == writes_per_flush - 1) {
+            // an application using TCP_CORK flushes at message boundaries
+            x.uncork();
+            x.cork();
+        }
+        if (i % writes_per_rtt == writes_per_rtt - 1) {
+            exchange();
+        }
+    }
+    x.uncork();
+    x.end_input_stream();
+
+    while (not y.inbound_stream().eof()) {
+        exchange();
+        x.tick(1);
+        y.tick(1);
+    }
+
+    if (bytes_received != len) {
+        throw runtime_error("sent " + to_string(len) + " bytes but received " + to_string(bytes_received));
+    }
+
+    const char *name = mode == Mode::Plain ? "no batching" : mode == Mode::Nagle ? "Nagle      " : "cork       ";
+    cout << fixed << setprecision(2);
+    cout << write_size << "-byte writes, " << name << ": " << data_segments << " data segments, "
+         << data_segments * 1024.0 / len << " segments/KB\n";
+
+    while (x.active() or y.active()) {
+        exchange();
+        x.tick(1000);
+        y.tick(1000);
+    }
+}
+
+int main() {
+    try {
+        main_loop(Mode::Plain);
+        main_loop(Mode::Nagle);
+        main_loop(Mode::Cork);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#include "eventloop.hh"
+#include "queue_workers.hh"
+#include "socket.hh"
+#include "tun.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <linux/if.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr const char *devname = "mq144";
+static constexpr const char *host_ip = "169.254.144.1";
+static constexpr const char *far_ip = "169.254.144.2";  // reached through the device, answered by the workers
+
+static constexpr size_t flows = 64;
+static constexpr size_t in_flight = 8;  // per flow
+static constexpr size_t echoes = 200000;
+static constexpr size_t payload_size = 1000;
+
+//! Give the (new) device the host's address and bring it up
+static void configure_device() {
+    UDPSocket config;
+    struct ifreq req {};
+    strncpy(static_cast<char *>(req.ifr_name), devname, IFNAMSIZ - 1);
+
+    auto &address = *reinterpret_cast<sockaddr_in *>(&req.ifr_addr);
+    address.sin_family = AF_INET;
+    inet_pton(AF_INET, host_ip, &address.sin_addr);
+    SystemCall("ioctl SIOCSIFADDR", ioctl(config.fd_num(), SIOCSIFADDR, &req));
+    inet_pton(AF_INET, "255.255.255.0", &address.sin_addr);
+    SystemCall("ioctl SIOCSIFNETMASK", ioctl(config.fd_num(), SIOCSIFNETMASK, &req));
+
+    SystemCall("ioctl SIOCGIFFLAGS", ioctl(config.fd_num(), SIOCGIFFLAGS, &req));
+    req.ifr_flags |= IFF_UP | IFF_RUNNING;
+    SystemCall("ioctl SIOCSIFFLAGS", ioctl(config.fd_num(), SIOCSIFFLAGS, &req));
+}
+
+//! Answer a UDP datagram by swapping its addresses and ports (which leaves both checksums right)
+static void echo(const size_t, FileDescriptor &queue, string &&datagram) {
+    if (datagram.size() < 28 or (uint8_t(datagram[0]) >> 4) != 4 or datagram[9] != 17) {
+        return;  // e.g. IPv6 router solicitations when the device comes up
+    }
+    const size_t header_length = (datagram[0] & 0xf) * 4;
+    swap_ranges(datagram.begin() + 12, datagram.begin() + 16, datagram.begin() + 16);
+    swap_ranges(datagram.begin() + header_length, datagram.begin() + header_length + 2,
+                datagram.begin() + header_length + 2);
+    queue.write(datagram);
+}
+
+//! Echo UDP datagrams of `flows` flows through a TUN device with `queues` queues, each serviced by
+//! QueueWorkers on its own thread, and report the echoes per second. The host end uses as many threads.
+void main_loop(const size_t queues) {
+    vector<FileDescriptor> device;
+    for (size_t i = 0; i < queues; i++) {
+        device.emplace_back(TunFD{devname, true});  // the first creates the device, which goes away with the last
+    }
+    configure_device();
+    QueueWorkers workers{move(device), echo};
+    workers.start();
+
+    atomic<size_t> echoed{0};
+    const auto first_time = high_resolution_clock::now();
+    vector<thread> host_threads;
+    for (size_t t = 0; t < queues; t++) {
+        host_threads.emplace_back([&, t] {
+            const string payload(payload_size, 'x');
+            vector<UDPSocket> sockets(flows / queues);
+            EventLoop loop{EventLoop::Backend::Epoll};
+            size_t received = 0;
+            for (auto &sock : sockets) {
+                sock.bind(Address{host_ip, 0});
+                sock.connect(Address{far_ip, uint16_t(9000 + t)});
+                for (size_t i = 0; i < in_flight; i++) {
+                    sock.send(payload);
+                }
+                loop.add_rule(sock, Direction::In, [&] {
+                    sock.recv();
+                    received++;
+                    sock.send(payload);
+                });
+            }
+            const size_t target = echoes / queues;
+            const auto deadline = steady_clock::now() + seconds(10);  // in case the device drops too much
+            while (received < target and steady_clock::now() < deadline) {
+                loop.wait_next_event(10);
+            }
+            echoed += received;
+        });
+    }
+    for (auto &host_thread : host_threads) {
+        host_thread.join();
+    }
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    workers.stop();
+
+    cout << fixed << setprecision(2);
+    cout << setw(2) << queues << " queues: " << setw(10) << echoed * 1e9 / duration << " echoes/s, " << setw(5)
+         << 100.0 * workers.handoffs() / max<uint64_t>(workers.frames(), 1) << "% of frames handed to another queue\n";
+}
+
+int main() {
+    try {
+        // more queues than cores can't be faster, as the workers and the host threads then share cores
+        cout << thread::hardware_concurrency() << " cores\n";
+        for (const size_t queues : {1, 2, 4, 8}) {
+            main_loop(queues);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << " (creating a TUN device needs CAP_NET_ADMIN)\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
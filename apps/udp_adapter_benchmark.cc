@@ -0,0 +1,111 @@
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_sponge_socket.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t len = 64 * 1024 * 1024;
+
+//! How the TCPOverUDPSocketAdapter at each end does its I/O
+enum class Mode { Batches, Offload, IoUring };
+
+static string name_of(const Mode mode) {
+    switch (mode) {
+        case Mode::Batches:
+            return "recvmmsg/sendmmsg";
+        case Mode::Offload:
+            return "UDP GSO/GRO";
+        case Mode::IoUring:
+            return "io_uring";
+    }
+    return "?";
+}
+
+//! Set up an adapter on `sock` to do its I/O as `mode` says; returns `false` if the kernel can't
+static bool set_mode(TCPOverUDPSocketAdapter &adapter, const Mode mode) {
+    switch (mode) {
+        case Mode::Batches:
+            return true;
+        case Mode::Offload:
+            return adapter.enable_offload();
+        case Mode::IoUring:
+            return adapter.enable_io_uring();
+    }
+    return false;
+}
+
+//! Copy `len` bytes over loopback from one TCPOverUDPSpongeSocket to another, whose adapters do their
+//! I/O as `mode` says, and report the throughput
+void main_loop(const Mode mode) {
+    UDPSocket server_sock, client_sock;
+    server_sock.bind(Address{"127.0.0.1", 0});
+    server_sock.set_receive_buffer_size(16 * 1024 * 1024);
+    client_sock.set_receive_buffer_size(16 * 1024 * 1024);
+    const Address server_address = server_sock.local_address();
+
+    TCPOverUDPSocketAdapter server_adapter{move(server_sock)}, client_adapter{move(client_sock)};
+    if (not set_mode(server_adapter, mode) or not set_mode(client_adapter, mode)) {
+        cout << setw(18) << name_of(mode) << ": not available\n";
+        return;
+    }
+    TCPOverUDPSpongeSocket server{move(server_adapter)}, client{move(client_adapter)};
+
+    // the connection closes quickly once the data is through, so each run lingers for a moment only
+    TCPConfig config;
+    config.rt_timeout = 100;
+
+    thread accepter([&] {
+        FdAdapterConfig server_config;
+        server_config.source = server_address;
+        server.listen_and_accept(config, server_config);
+    });
+    FdAdapterConfig client_config;
+    client_config.destination = server_address;
+    client.connect(config, client_config);
+    accepter.join();
+
+    const auto first_time = high_resolution_clock::now();
+    thread writer([&] {
+        const string chunk(65536, 'x');
+        for (size_t sent = 0; sent < len; sent += chunk.size()) {
+            client.write(chunk);
+        }
+        client.shutdown(SHUT_WR);
+    });
+
+    size_t received = 0;
+    while (not server.eof()) {
+        received += server.read().size();
+    }
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    writer.join();
+
+    cout << fixed << setprecision(2);
+    cout << setw(18) << name_of(mode) << ": " << setw(8) << received * 8.0 / duration << " Gbit/s ("
+         << received / 1024 / 1024 << " MiB in " << duration / 1e9 << " s)\n";
+
+    server.wait_until_closed();
+    client.wait_until_closed();
+}
+
+int main() {
+    try {
+        for (const auto mode : {Mode::Batches, Mode::Offload, Mode::IoUring}) {
+            main_loop(mode);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "socket.hh"
+#include "util.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t datagrams = 200000;
+static constexpr size_t payload_size = 1000;  // about the size of a full TCP segment
+static constexpr size_t mtu = 2048;
+
+//! Send `datagrams` datagrams over loopback, `batch` per system call at each end (1 means sendto
+//! and recvfrom), and report the packets per second received and the system calls per packet.
+//! With `offload`, each batch is one send with UDP GSO, received with UDP GRO.
+void main_loop(const size_t batch, const bool offload = false) {
+    UDPSocket receiver, sender;
+    receiver.bind(Address{"127.0.0.1", 0});
+    sender.bind(Address{"127.0.0.1", 0});
+    receiver.set_receive_buffer_size(16 * 1024 * 1024);
+    const Address destination = receiver.local_address();
+    if (offload and not(sender.gso_supported() and receiver.enable_gro())) {
+        cout << "UDP GSO/GRO: not available\n";
+        return;
+    }
+    // a coalesced datagram can be as big as the send it came from
+    const size_t recv_mtu = offload ? 65536 : mtu;
+
+    const string payload(payload_size, 'x');
+    const string last = "last";
+
+    // the receiver counts datagrams until it gets one saying there are no more
+    atomic<bool> done{false};
+    size_t received = 0;
+    size_t recv_calls = 0;
+    thread receiver_thread([&] {
+        vector<UDPSocket::received_datagram> batch_in(1, {{nullptr, 0}, ""});
+        while (not done) {
+            size_t count = 1;
+            if (batch == 1) {
+                receiver.recv(batch_in[0], mtu);
+            } else {
+                count = receiver.recv_many(batch_in, batch, recv_mtu);
+            }
+            recv_calls++;
+            for (size_t i = 0; i < count; i++) {
+                if (batch_in[i].payload == last) {
+                    done = true;
+                    break;
+                }
+                received++;
+            }
+        }
+    });
+
+    const auto first_time = high_resolution_clock::now();
+    size_t send_calls = 0;
+    const vector<BufferViewList> payloads(batch, payload);
+    for (size_t sent = 0; sent < datagrams; sent += batch) {
+        if (batch == 1) {
+            sender.sendto(destination, payload);
+            send_calls++;
+        } else if (offload) {
+            send_calls += sender.send_segmented(destination, payloads);
+        } else {
+            send_calls += sender.send_many(destination, payloads);
+        }
+    }
+    // the receiver may drop some, so repeat the end until it gets through
+    while (not done) {
+        sender.sendto(destination, last);
+        this_thread::sleep_for(milliseconds(1));
+    }
+    receiver_thread.join();
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+
+    cout << fixed << setprecision(2);
+    cout << (offload ? "GSO/GRO " : "batches ") << "of " << setw(3) << batch << ": " << setw(10)
+         << received * 1e9 / duration << " packets/s received (" << setw(5) << 100.0 * received / datagrams << "%), " << setw(5)
+         << static_cast<double>(send_calls) / datagrams << " syscalls/packet sent, " << setw(5)
+         << static_cast<double>(recv_calls) / received << " syscalls/packet received\n";
+}
+
+int main() {
+    try {
+        for (const size_t batch : {1, 8, 32, 64}) {
+            main_loop(batch);
+        }
+        for (const size_t batch : {8, 32, 64}) {
+            main_loop(batch, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -18,6 +18,8 @@ add_test(NAME t_send_retx            COMMAND send_retx)
 add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
+add_test(NAME t_send_retx_queue      COMMAND retransmission_queue)
+add_test(NAME t_timer_wheel          COMMAND timer_wheel)
 
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
@@ -53,12 +55,32 @@ add_test(NAME t_connect              COMMAND fsm_connect_relaxed)
 add_test(NAME ec_listen              COMMAND fsm_listen)
 add_test(NAME t_listen               COMMAND fsm_listen_relaxed)
 add_test(NAME t_winsize              COMMAND fsm_winsize)
+add_test(NAME t_timestamps           COMMAND fsm_timestamps)
+add_test(NAME t_ack_delay            COMMAND fsm_ack_delay)
+add_test(NAME t_nagle                COMMAND fsm_nagle)
+add_test(NAME t_window_update        COMMAND fsm_window_update)
+add_test(NAME t_mss                  COMMAND fsm_mss)
 add_test(NAME ec_retx                COMMAND fsm_retx)
 add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
 add_test(NAME t_loopback             COMMAND fsm_loopback)
 add_test(NAME t_loopback_win         COMMAND fsm_loopback_win)
 add_test(NAME t_reorder              COMMAND fsm_reorder)
+add_test(NAME t_conn_manager         COMMAND tcp_connection_manager)
+add_test(NAME t_datagram_ring        COMMAND datagram_ring)
+add_test(NAME t_eventloop_backends   COMMAND eventloop_backends)
+add_test(NAME t_udp_batch            COMMAND udp_batch)
+add_test(NAME t_queue_workers        COMMAND queue_workers)
+add_test(NAME t_tcp_offload          COMMAND tcp_offload)
+add_test(NAME t_neighbor_table       COMMAND neighbor_table)
+add_test(NAME t_net_interface_copies  COMMAND net_interface_copies)
+add_test(NAME t_net_interface_pending COMMAND net_interface_pending)
+add_test(NAME t_spsc_queue           COMMAND spsc_queue)
+add_test(NAME t_router_workers       COMMAND router_workers)
+add_test(NAME t_header_layout        COMMAND header_layout)
+add_test(NAME t_tcp_lazy_unwrap      COMMAND tcp_lazy_unwrap)
+add_test(NAME t_ip_fragments         COMMAND ip_fragments)
+add_test(NAME t_layer_stats          COMMAND layer_stats)
 
 add_test(NAME t_address_dt           COMMAND address_dt)
 add_test(NAME t_parser_dt            COMMAND parser_dt)
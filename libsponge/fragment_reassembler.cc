@@ -0,0 +1,164 @@
+#include "fragment_reassembler.hh"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+//! Largest payload of a datagram (its length field is 16 bits) after a header of `hlen` words
+static size_t max_payload(const IPv4Header &header) { return 65535 - 4 * header.hlen; }
+
+FragmentReassembler::Partial FragmentReassembler::_take(const map<Key, Partial>::iterator iter) {
+    Partial partial = move(iter->second);
+    _bytes -= partial.payload.size();
+    _partials.erase(iter);
+    return partial;
+}
+
+bool FragmentReassembler::_live(const pair<uint64_t, Key> &deadline) const {
+    const auto iter = _partials.find(deadline.second);
+    return iter != _partials.end() and iter->second.deadline == deadline.first;
+}
+
+void FragmentReassembler::_evict_oldest() {
+    for (; not _deadlines.empty(); _deadlines.pop_front()) {
+        if (_live(_deadlines.front())) {
+            _take(_partials.find(_deadlines.front().second));
+            _drops.evicted++;
+            _deadlines.pop_front();
+            return;
+        }
+    }
+}
+
+void FragmentReassembler::_compact_deadlines() {
+    const auto stale = [&](const pair<uint64_t, Key> &deadline) { return not _live(deadline); };
+    _deadlines.erase(remove_if(_deadlines.begin(), _deadlines.end(), stale), _deadlines.end());
+}
+
+//! \param[in] fragment the fragment
+//! \param[in] now the time it arrived
+//! \details A fragment that overlaps ones already received overwrites their bytes. One that doesn't fit
+//! the datagram (past the end the last fragment gave it, or past the largest datagram there can be) is
+//! dropped, and so is the rest of a datagram whose fragments disagree about where it ends.
+optional<InternetDatagram> FragmentReassembler::add(const InternetDatagram &fragment, const uint64_t now) {
+    const IPv4Header &header = fragment.header();
+    const size_t start = size_t{header.offset} * 8;
+    const size_t end = start + fragment.payload().size();
+    if (end > max_payload(header) or (header.mf and (end == start or (end - start) % 8 != 0))) {
+        _drops.malformed++;
+        return {};
+    }
+
+    const Key key{header.src, header.dst, header.id, header.proto};
+    auto iter = _partials.find(key);
+    if (iter == _partials.end()) {
+        if (_partials.size() >= MAX_DATAGRAMS) {
+            _evict_oldest();
+        }
+        if (_deadlines.size() > MAX_DATAGRAMS + 2 * _partials.size()) {
+            _compact_deadlines();
+        }
+        iter = _partials.emplace(key, Partial{}).first;
+        iter->second.deadline = now + TIMEOUT;
+        _deadlines.emplace_back(iter->second.deadline, key);
+    }
+    Partial &partial = iter->second;
+
+    // the last fragment says where the datagram ends, and nothing may lie past that
+    const size_t received_end = partial.received.empty() ? 0 : prev(partial.received.end())->second;
+    const bool disagrees = header.mf ? partial.length.has_value() and end > partial.length.value()
+                                     : (partial.length.has_value() and end != partial.length.value()) or
+                                           received_end > end;
+    if (disagrees) {
+        _take(iter);
+        _drops.malformed++;
+        return {};
+    }
+    if (not header.mf) {
+        partial.length = end;
+    }
+    if (start == 0) {
+        partial.header = header;
+        partial.have_first = true;
+    }
+
+    // copy the payload into place
+    if (partial.payload.size() < end) {
+        _bytes += end - partial.payload.size();
+        partial.payload.resize(end);
+    }
+    size_t at = start;
+    for (const auto &buffer : fragment.payload().buffers()) {
+        partial.payload.replace(at, buffer.size(), buffer.str());
+        at += buffer.size();
+    }
+
+    // merge [start, end) with the runs it touches
+    if (end > start) {
+        size_t first = start, last = end;
+        auto run = partial.received.upper_bound(start);
+        if (run != partial.received.begin() and prev(run)->second >= start) {
+            run = prev(run);
+            first = run->first;
+        }
+        for (; run != partial.received.end() and run->first <= last; run = partial.received.erase(run)) {
+            last = max(last, run->second);
+        }
+        partial.received.emplace(first, last);
+    }
+
+    while (_bytes > MAX_BYTES) {
+        _evict_oldest();
+    }
+    iter = _partials.find(key);
+    if (iter == _partials.end()) {
+        return {};
+    }
+
+    // is it whole?
+    const Partial &whole = iter->second;
+    if (not whole.have_first or not whole.length.has_value()) {
+        return {};
+    }
+    const size_t length = whole.length.value();
+    const bool covered = whole.received.empty() ? length == 0
+                                                : whole.received.begin()->first == 0 and
+                                                      whole.received.begin()->second == length;
+    if (not covered) {
+        return {};
+    }
+    if (length > max_payload(whole.header)) {
+        _take(iter);
+        _drops.malformed++;
+        return {};
+    }
+
+    Partial done = _take(iter);
+    InternetDatagram dgram;
+    dgram.header() = done.header;
+    dgram.header().mf = false;
+    dgram.header().offset = 0;
+    dgram.header().len = 4 * done.header.hlen + length;
+    dgram.payload() = move(done.payload);
+    return dgram;
+}
+
+size_t FragmentReassembler::expire(const uint64_t now) {
+    size_t expired = 0;
+    for (; not _deadlines.empty() and _deadlines.front().first <= now; _deadlines.pop_front()) {
+        if (_live(_deadlines.front())) {
+            _take(_partials.find(_deadlines.front().second));
+            _drops.timed_out++;
+            expired++;
+        }
+    }
+    return expired;
+}
+
+optional<uint64_t> FragmentReassembler::next_expiry() const {
+    if (_partials.empty()) {
+        return {};
+    }
+    return _deadlines.front().first;
+}
@@ -0,0 +1,100 @@
+#ifndef SPONGE_LIBSPONGE_FRAGMENT_REASSEMBLER_HH
+#define SPONGE_LIBSPONGE_FRAGMENT_REASSEMBLER_HH
+
+#include "ipv4_datagram.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+
+//! \brief Puts [IPv4](\ref rfc::rfc791) datagrams back together from their fragments
+//! \details Fragments are grouped by source, destination, identification and protocol, and their payloads
+//! copied into place as they arrive, in any order. A datagram is handed back once it has its first and last
+//! fragments and every byte between. Time is in milliseconds on a clock the owner chooses: a datagram still
+//! incomplete TIMEOUT after its first fragment arrived is given up on, and so is the oldest one whenever
+//! more than MAX_DATAGRAMS are incomplete or they hold more than MAX_BYTES.
+class FragmentReassembler {
+  public:
+    //! Source, destination, identification and protocol of a fragment's datagram
+    using Key = std::tuple<uint32_t, uint32_t, uint16_t, uint8_t>;
+
+    //! Milliseconds a datagram may wait for the rest of its fragments
+    static constexpr uint64_t TIMEOUT = 30000;
+
+    //! Most datagrams being put back together at once
+    static constexpr size_t MAX_DATAGRAMS = 64;
+
+    //! Most bytes of payload held by the datagrams being put back together
+    static constexpr size_t MAX_BYTES = 1 << 22;
+
+    //! Fragments, and incomplete datagrams, dropped by reason
+    struct Drops {
+        uint64_t timed_out{0};  //!< datagrams still incomplete after TIMEOUT
+        uint64_t evicted{0};    //!< the oldest datagrams, to make room for more
+        uint64_t malformed{0};  //!< fragments past the largest datagram, or inconsistent with the others
+    };
+
+  private:
+    //! A datagram being put back together
+    struct Partial {
+        IPv4Header header{};                  //!< of the first fragment, once it has arrived
+        bool have_first{false};               //!< has the fragment at offset 0 arrived?
+        std::optional<size_t> length{};       //!< payload length, once the last fragment has arrived
+        std::string payload{};                //!< the bytes received, each at its offset
+        std::map<size_t, size_t> received{};  //!< start -> end of the runs of bytes received, apart
+        uint64_t deadline{0};                 //!< when to give up on it
+    };
+
+    std::map<Key, Partial> _partials{};
+
+    //! (deadline, key) of each datagram, oldest first, including ones since completed or dropped
+    std::deque<std::pair<uint64_t, Key>> _deadlines{};
+
+    size_t _bytes{0};  //!< sum of the sizes of the payloads in `_partials`
+
+    Drops _drops{};
+
+    //! Forget the datagram at `iter`, and return what had been received of it
+    Partial _take(std::map<Key, Partial>::iterator iter);
+
+    //! Is `deadline` still that of a datagram being put back together?
+    bool _live(const std::pair<uint64_t, Key> &deadline) const;
+
+    //! Drop the oldest datagram
+    void _evict_oldest();
+
+    //! Drop the deadlines of datagrams no longer being put back together
+    void _compact_deadlines();
+
+  public:
+    //! \brief Take a fragment received at `now`
+    //! \returns the whole datagram, if this was the last of its fragments to arrive
+    std::optional<InternetDatagram> add(const InternetDatagram &fragment, const uint64_t now);
+
+    //! \brief Give up on every datagram incomplete at `now`
+    //! \returns the number given up on
+    size_t expire(const uint64_t now);
+
+    //! \brief When expire() next has something to do, or nothing if no datagram is incomplete
+    //! \note This may be the deadline of a datagram since completed, which is early but harmless.
+    std::optional<uint64_t> next_expiry() const;
+
+    //! \brief Datagrams being put back together
+    size_t pending() const { return _partials.size(); }
+
+    //! \brief Bytes of payload held for them
+    size_t bytes() const { return _bytes; }
+
+    //! \brief Fragments and datagrams dropped
+    const Drops &drops() const { return _drops; }
+
+    //! \brief Is the datagram with `header` a fragment, rather than a whole datagram?
+    static bool is_fragment(const IPv4Header &header) { return header.mf or header.offset != 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_FRAGMENT_REASSEMBLER_HH
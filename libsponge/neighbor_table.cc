@@ -0,0 +1,124 @@
+#include "neighbor_table.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+size_t NeighborTable::_home(const uint32_t ip) const {
+    // Fibonacci hashing: the top bits of the product depend on every bit of the address
+    const unsigned bits = __builtin_ctzll(_slots.size());
+    return (ip * uint64_t{0x9e3779b97f4a7c15}) >> (64 - bits);
+}
+
+size_t NeighborTable::_find(const uint32_t ip) const {
+    const size_t mask = _slots.size() - 1;
+    size_t index = _home(ip);
+    while (_slots[index].used and _slots[index].ip != ip) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+//! \details An entry may stay where it is only if its home slot is cyclically within (index, next];
+//! otherwise its probe passed through `index`, so it moves back to fill the hole.
+void NeighborTable::_remove_at(size_t index) {
+    const size_t mask = _slots.size() - 1;
+    _slots[index].used = false;
+    _size--;
+    for (size_t next = (index + 1) & mask; _slots[next].used; next = (next + 1) & mask) {
+        const size_t home = _home(_slots[next].ip);
+        const bool stays = index <= next ? (index < home and home <= next) : (index < home or home <= next);
+        if (not stays) {
+            _slots[index] = _slots[next];
+            _slots[next].used = false;
+            index = next;
+        }
+    }
+}
+
+void NeighborTable::_rehash(const size_t capacity) {
+    vector<Slot> old(capacity);
+    swap(old, _slots);
+    for (const auto &slot : old) {
+        if (slot.used) {
+            _slots[_find(slot.ip)] = slot;
+        }
+    }
+}
+
+void NeighborTable::_compact_deadlines() {
+    _deadlines.clear();
+    for (const auto &slot : _slots) {
+        if (slot.used) {
+            _deadlines.push_back({slot.expiry, slot.ip});
+        }
+    }
+    make_heap(_deadlines.begin(), _deadlines.end());
+}
+
+optional<EthernetAddress> NeighborTable::lookup(const uint32_t ip, const uint64_t now) {
+    const size_t index = _find(ip);
+    if (not _slots[index].used) {
+        return {};
+    }
+    if (_slots[index].expiry <= now) {
+        _remove_at(index);  // its deadline goes stale, and is dropped by expire()
+        return {};
+    }
+    return _slots[index].ethernet_address;
+}
+
+void NeighborTable::insert(const uint32_t ip, const EthernetAddress &ethernet_address, const uint64_t expiry) {
+    if (2 * (_size + 1) > _slots.size()) {
+        _rehash(2 * _slots.size());
+    }
+
+    Slot &slot = _slots[_find(ip)];
+    if (not slot.used) {
+        slot.used = true;
+        slot.ip = ip;
+        _size++;
+    }
+    slot.ethernet_address = ethernet_address;
+    slot.expiry = expiry;
+
+    // a renewed entry leaves its old deadline behind; don't let those pile up
+    if (_deadlines.size() >= 2 * _size + INITIAL_CAPACITY) {
+        _compact_deadlines();
+    } else {
+        _deadlines.push_back({expiry, ip});
+        push_heap(_deadlines.begin(), _deadlines.end());
+    }
+}
+
+bool NeighborTable::erase(const uint32_t ip) {
+    const size_t index = _find(ip);
+    if (not _slots[index].used) {
+        return false;
+    }
+    _remove_at(index);
+    return true;
+}
+
+size_t NeighborTable::expire(const uint64_t now) {
+    size_t removed = 0;
+    while (not _deadlines.empty() and _deadlines.front().expiry <= now) {
+        const Deadline deadline = _deadlines.front();
+        pop_heap(_deadlines.begin(), _deadlines.end());
+        _deadlines.pop_back();
+
+        const size_t index = _find(deadline.ip);
+        if (_slots[index].used and _slots[index].expiry == deadline.expiry) {
+            _remove_at(index);
+            removed++;
+        }
+    }
+    return removed;
+}
+
+optional<uint64_t> NeighborTable::next_expiry() const {
+    if (_size == 0) {
+        return {};
+    }
+    return _deadlines.front().expiry;
+}
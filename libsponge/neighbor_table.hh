@@ -0,0 +1,90 @@
+#ifndef SPONGE_LIBSPONGE_NEIGHBOR_TABLE_HH
+#define SPONGE_LIBSPONGE_NEIGHBOR_TABLE_HH
+
+#include "ethernet_header.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief An ARP cache: the Ethernet address of each neighbor's IPv4 address, until an expiry time
+//! \details Time is in milliseconds on a clock the owner chooses. The table is an open-addressing hash
+//! table with linear probing, at most half full, and deletes by shifting the entries after a removed one
+//! back (so it never fills up with tombstones). lookup() treats an entry past its expiry time as absent
+//! and removes it; expire() removes the rest in expiry order from a min-heap of expiry times, so neither
+//! walks the whole table.
+class NeighborTable {
+  private:
+    struct Slot {
+        uint32_t ip{0};
+        bool used{false};
+        EthernetAddress ethernet_address{};
+        uint64_t expiry{0};
+    };
+
+    //! An expiry time in the heap; stale once its entry has been removed or given a new expiry time
+    struct Deadline {
+        uint64_t expiry;
+        uint32_t ip;
+
+        //! orders the heap (std::push_heap et al. make a max-heap) by earliest expiry
+        bool operator<(const Deadline &other) const { return expiry > other.expiry; }
+    };
+
+    std::vector<Slot> _slots;  //!< a power of two of them
+    size_t _size{0};           //!< slots in use
+
+    std::vector<Deadline> _deadlines{};  //!< heap of expiry times, including stale ones
+
+    //! The slot where the probe for `ip` starts
+    size_t _home(const uint32_t ip) const;
+
+    //! The slot holding `ip`, or the empty slot where it would go
+    size_t _find(const uint32_t ip) const;
+
+    //! Empty slot `index`, and move entries that probed past it back into it
+    void _remove_at(size_t index);
+
+    //! Rebuild the table with `capacity` slots
+    void _rehash(const size_t capacity);
+
+    //! Rebuild the heap from the entries in the table, dropping stale deadlines
+    void _compact_deadlines();
+
+  public:
+    //! Slots in a new table
+    static constexpr size_t INITIAL_CAPACITY = 16;
+
+    //! An empty table
+    NeighborTable() : _slots(INITIAL_CAPACITY) {}
+
+    //! \brief The Ethernet address of `ip`, unless it isn't known or its entry expired by `now`
+    std::optional<EthernetAddress> lookup(const uint32_t ip, const uint64_t now);
+
+    //! \brief Learn (or update) the Ethernet address of `ip`, valid until `expiry`
+    void insert(const uint32_t ip, const EthernetAddress &ethernet_address, const uint64_t expiry);
+
+    //! \brief Forget `ip`
+    //! \returns `false` if it wasn't there
+    bool erase(const uint32_t ip);
+
+    //! \brief Remove every entry that expired by `now`
+    //! \returns the number removed
+    size_t expire(const uint64_t now);
+
+    //! \brief When expire() next has something to do, or nothing if the table is empty
+    //! \note This may be the expiry time of an entry since removed or renewed, which is early but harmless.
+    std::optional<uint64_t> next_expiry() const;
+
+    //! \brief Number of entries (including ones expired but not yet removed)
+    size_t size() const { return _size; }
+
+    //! \brief Are there no entries?
+    bool empty() const { return _size == 0; }
+
+    //! \brief Number of slots
+    size_t capacity() const { return _slots.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_NEIGHBOR_TABLE_HH
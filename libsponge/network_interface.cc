@@ -3,7 +3,10 @@
 #include "arp_message.hh"
 #include "ethernet_frame.hh"
 
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 // Dummy implementation of a network interface
 // Translates from {IP datagram, next hop address} to link-layer frame, and from link-layer frame to IP datagram
@@ -20,20 +23,24 @@ using namespace std;
 
 //! \param[in] ethernet_address Ethernet (what ARP calls "hardware") address of the interface
 //! \param[in] ip_address IP (what ARP calls "protocol") address of the interface
-NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address, const Address &ip_address)
-    : _ethernet_address(ethernet_address), _ip_address(ip_address) {
-    cerr << "DEBUG: Network interface has Ethernet address " << to_string(_ethernet_address) << " and IP address "
-         << ip_address.ip() << "\n";
+//! \param[in] mtu Largest IPv4 datagram the link carries
+NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address,
+                                   const Address &ip_address,
+                                   const size_t mtu)
+    : _ethernet_address(ethernet_address), _ip_address(ip_address), _mtu(mtu) {
+    if (_mtu < 68) {
+        throw runtime_error("NetworkInterface: an MTU of " + to_string(_mtu) + " is below the minimum of 68");
+    }
+}
+
+void NetworkInterface::queue_frame(EthernetFrame &&frame) {
+    _stats.frames_sent++;
+    _stats.bytes_sent += frame.payload().size();
+    _frames_out.push(move(frame));
 }
 
 optional<EthernetAddress> NetworkInterface::get_EthernetAdress(const uint32_t ip_addr) {
-    optional<EthernetAddress> ret = nullopt;
-    map<uint32_t, EthernetAddressEntry>::iterator iter;
-    iter = _cache.find(ip_addr);
-    if (iter != _cache.end()) {
-        ret = iter->second.MAC_address;
-    }
-    return ret;
+    return _cache.lookup(ip_addr, _now);
 }
 
 void NetworkInterface::send_ARP_request(const uint32_t ip_addr) {
@@ -47,7 +54,8 @@ void NetworkInterface::send_ARP_request(const uint32_t ip_addr) {
     arp.sender_ip_address = _ip_address.ipv4_numeric();
     arp.target_ip_address = ip_addr;
     frame.payload() = BufferList(arp.serialize());
-    _frames_out.push(frame);
+    _stats.arp_requests_sent++;
+    queue_frame(move(frame));
 }
 
 void NetworkInterface::send_ARP_reply(const uint32_t ip_addr, const EthernetAddress& MAC_addr) {
@@ -62,41 +70,70 @@ void NetworkInterface::send_ARP_reply(const uint32_t ip_addr, const EthernetAddr
     arp.target_ethernet_address = MAC_addr;
     arp.target_ip_address = ip_addr;
     frame.payload() = BufferList(arp.serialize());
-    _frames_out.push(frame);
-}
-
-optional<WaitingList> NetworkInterface::get_WaitingList(const uint32_t ip_addr) {
-    optional<WaitingList> ret = nullopt;
-    map<uint32_t, WaitingList>::iterator iter;
-    iter = _queue_map.find(ip_addr);
-    if (iter != _queue_map.end()) {
-        ret = iter->second;
-    }
-    return ret;
+    _stats.arp_replies_sent++;
+    queue_frame(move(frame));
 }
 
-void NetworkInterface::send_helper(const EthernetAddress MAC_addr, const InternetDatagram &dgram) {
+void NetworkInterface::send_helper(const EthernetAddress &MAC_addr, InternetDatagram &&dgram) {
     EthernetFrame frame;
     frame.header().type = EthernetHeader::TYPE_IPv4;
     frame.header().src = _ethernet_address;
     frame.header().dst = MAC_addr;
-    frame.payload() = dgram.serialize();
-    _frames_out.push(frame);
+    frame.payload() = move(dgram).serialize();
+    queue_frame(move(frame));
 }
 
-void NetworkInterface::queue_helper(const uint32_t ip_addr, const InternetDatagram &dgram) {
-    optional<WaitingList> wait_list = get_WaitingList(ip_addr);
-    bool send_ARP = false;
-    if (wait_list.has_value()) {
-        wait_list.value().waiting_datagram.push(dgram);        
-        send_ARP = wait_list.value().time_since_last_ARP_request_send >= NetworkInterface::MAX_RETX_WAITING_TIME;
-    } else {
-        WaitingList new_wait_list;
-        new_wait_list.waiting_datagram.push(dgram);
-        _queue_map[ip_addr] = new_wait_list; 
-        send_ARP = true;
+//! \details A neighbor's first datagram sends an ARP request, which tick() resends with backoff. A neighbor
+//! that never answers is remembered as unreachable for a while, and its datagrams dropped without asking
+//! again, so that a sweep of dead addresses costs neither unbounded memory nor an ARP storm.
+void NetworkInterface::queue_helper(const uint32_t ip_addr, InternetDatagram &&dgram) {
+    const auto unreachable = _unreachable.find(ip_addr);
+    if (unreachable != _unreachable.end()) {
+        if (unreachable->second > _now) {
+            _drops.unreachable++;
+            return;
+        }
+        _unreachable.erase(unreachable);
+    }
+
+    auto iter = _queue_map.find(ip_addr);
+    if (iter != _queue_map.end() && iter->second.waiting_datagram.size() >= MAX_PENDING_PER_NEIGHBOR) {
+        iter->second.waiting_datagram.pop();
+        _pending--;
+        _drops.neighbor_full++;
+    }
+    if (_pending >= MAX_PENDING) {
+        _drops.all_full++;
+        return;
+    }
+
+    if (iter == _queue_map.end()) {
+        iter = _queue_map.emplace(ip_addr, WaitingList{}).first;
+        retry_ARP_request(iter);
+    }
+    iter->second.waiting_datagram.push(move(dgram));
+    _pending++;
+}
+
+void NetworkInterface::retry_ARP_request(unordered_map<uint32_t, WaitingList>::iterator iter) {
+    const uint32_t ip_addr = iter->first;
+    WaitingList &waiting = iter->second;
+    if (waiting.ARP_requests_sent < MAX_ARP_REQUESTS) {
+        send_ARP_request(ip_addr);
+        waiting.next_ARP_request = _now + (MAX_RETX_WAITING_TIME << waiting.ARP_requests_sent);
+        waiting.ARP_requests_sent++;
+        _deadlines.emplace(waiting.next_ARP_request, ip_addr);
+        return;
+    }
+
+    // no answer: drop what is waiting, and don't ask again for a while
+    _pending -= waiting.waiting_datagram.size();
+    _drops.unreachable += waiting.waiting_datagram.size();
+    _queue_map.erase(iter);
+    if (_unreachable.size() < MAX_UNREACHABLE) {
+        _unreachable[ip_addr] = _now + UNREACHABLE_TIME;
+        _deadlines.emplace(_now + UNREACHABLE_TIME, ip_addr);
     }
-    if (send_ARP) send_ARP_request(ip_addr);
 }
 
 bool NetworkInterface::valid_frame(const EthernetFrame &frame) {
@@ -104,31 +141,21 @@ bool NetworkInterface::valid_frame(const EthernetFrame &frame) {
     return dst == _ethernet_address || dst == ETHERNET_BROADCAST; 
 }
 
-void NetworkInterface::cache_mapping(uint32_t ip_addr, EthernetAddress MAC_addr) {
-    map<uint32_t, EthernetAddressEntry>::iterator iter;
-    iter = _cache.find(ip_addr);
-    if (iter != _cache.end()) {
-        iter->second.caching_time = 0;
-        iter->second.MAC_address = MAC_addr;
-    } else {
-        EthernetAddressEntry entry;
-        entry.caching_time = 0;
-        entry.MAC_address = MAC_addr;
-        _cache[ip_addr] = entry;
-    }
+void NetworkInterface::cache_mapping(uint32_t ip_addr, const EthernetAddress &MAC_addr) {
+    _cache.insert(ip_addr, MAC_addr, _now + NetworkInterface::MAX_CACHE_TIME);
+    _unreachable.erase(ip_addr);
 }
 
-void NetworkInterface::clear_waitinglist(uint32_t ip_addr, EthernetAddress MAC_addr) {
-    map<uint32_t, WaitingList>::iterator iter;
-    iter = _queue_map.find(ip_addr);
-    if (iter != _queue_map.end()) {
-        while (!iter->second.waiting_datagram.empty()) {
-            InternetDatagram dgram = iter->second.waiting_datagram.front();
-            iter->second.waiting_datagram.pop();
-            send_helper(MAC_addr, dgram);
-        }
+void NetworkInterface::clear_waitinglist(uint32_t ip_addr, const EthernetAddress &MAC_addr) {
+    auto iter = _queue_map.find(ip_addr);
+    if (iter == _queue_map.end()) {
+        return;
+    }
+    _pending -= iter->second.waiting_datagram.size();
+    for (auto &waiting = iter->second.waiting_datagram; !waiting.empty(); waiting.pop()) {
+        send_helper(MAC_addr, move(waiting.front()));
     }
-    _queue_map.erase(ip_addr);
+    _queue_map.erase(iter);
 }
 
 
@@ -136,27 +163,77 @@ void NetworkInterface::clear_waitinglist(uint32_t ip_addr, EthernetAddress MAC_a
 //! \param[in] next_hop the IP address of the interface to send it to (typically a router or default gateway, but may also be another host if directly connected to the same network as the destination)
 //! (Note: the Address type can be converted to a uint32_t (raw 32-bit IP address) with the Address::ipv4_numeric() method.)
 void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Address &next_hop) {
-    const uint32_t next_hop_ip = next_hop.ipv4_numeric();
+    send_datagram(InternetDatagram{dgram}, next_hop);
+}
+
+void NetworkInterface::send_or_queue(const uint32_t next_hop_ip, InternetDatagram &&dgram) {
     optional<EthernetAddress> MAC_addr = get_EthernetAdress(next_hop_ip);
     if (MAC_addr.has_value()) {
-        send_helper(MAC_addr.value(), dgram);
+        _stats.arp_hits++;
+        send_helper(MAC_addr.value(), move(dgram));
     } else {
-        queue_helper(next_hop_ip, dgram);
+        _stats.arp_misses++;
+        queue_helper(next_hop_ip, move(dgram));
+    }
+}
+
+//! \param[in] dgram the IPv4 datagram to be sent, which is left empty
+//! \param[in] next_hop the IP address of the interface to send it to
+//! \details A datagram larger than the MTU is split into fragments, each with a copy of its header and
+//! a run of its payload a multiple of 8 bytes long (but the last). A fragment of a fragment keeps its
+//! place in the original datagram, and the "more fragments" flag of the last one.
+void NetworkInterface::send_datagram(InternetDatagram &&dgram, const Address &next_hop) {
+    const uint32_t next_hop_ip = next_hop.ipv4_numeric();
+    const IPv4Header &header = dgram.header();
+    _stats.datagrams_sent++;
+    if (header.len <= _mtu) {
+        send_or_queue(next_hop_ip, move(dgram));
+        return;
+    }
+    if (header.df) {
+        _stats.too_big++;
+        return;
+    }
+
+    const string payload = dgram.payload().concatenate();
+    const size_t fragment_size = (_mtu - 4 * header.hlen) / 8 * 8;
+    for (size_t start = 0; start < payload.size(); start += fragment_size) {
+        const size_t size = min(fragment_size, payload.size() - start);
+        InternetDatagram fragment;
+        fragment.header() = header;
+        fragment.header().len = 4 * header.hlen + size;
+        fragment.header().offset = header.offset + start / 8;
+        fragment.header().mf = header.mf or start + size < payload.size();
+        fragment.payload() = payload.substr(start, size);
+        _stats.fragments_sent++;
+        send_or_queue(next_hop_ip, move(fragment));
     }
 }
 
 //! \param[in] frame the incoming Ethernet frame
 optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &frame) {
     optional<InternetDatagram> ret = nullopt;
-    if (!valid_frame(frame)) return ret;
+    if (!valid_frame(frame)) {
+        _stats.frames_ignored++;
+        return ret;
+    }
+    _stats.frames_received++;
+    _stats.bytes_received += frame.payload().size();
     if (frame.header().type == EthernetHeader::TYPE_IPv4) {
-        InternetDatagram dgram;
-        if (dgram.parse(Buffer(frame.payload())) == ParseResult::NoError) {
-            ret = dgram;
+        // parse in place: the datagram's payload shares the frame's Buffer
+        if (ret.emplace().parse(Buffer(frame.payload())) != ParseResult::NoError) {
+            _stats.bad_datagrams++;
+            ret.reset();
+        } else if (FragmentReassembler::is_fragment(ret->header()) &&
+                   ret->header().dst == _ip_address.ipv4_numeric()) {
+            ret = _fragments.add(ret.value(), _now);
         }
+        _stats.datagrams_received += ret.has_value();
     } else {
         ARPMessage arp;
-        if (arp.parse(Buffer(frame.payload())) == ParseResult::NoError) {
+        if (arp.parse(Buffer(frame.payload())) != ParseResult::NoError) {
+            _stats.bad_arp++;
+        } else {
             cache_mapping(arp.sender_ip_address, arp.sender_ethernet_address);
             clear_waitinglist(arp.sender_ip_address, arp.sender_ethernet_address);
             if (arp.opcode == ARPMessage::OPCODE_REQUEST && arp.target_ip_address == _ip_address.ipv4_numeric()) 
@@ -166,25 +243,78 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
     return ret; 
 }
 
+NetworkInterface::Stats NetworkInterface::stats() const {
+    Stats stats = _stats;
+    stats.pending_drops = _drops;
+    stats.fragment_drops = _fragments.drops();
+    stats.pending = _pending;
+    stats.fragment_bytes = _fragments.bytes();
+    return stats;
+}
+
+NetworkInterface::Stats &NetworkInterface::Stats::operator+=(const Stats &other) {
+    frames_received += other.frames_received;
+    frames_ignored += other.frames_ignored;
+    frames_sent += other.frames_sent;
+    bytes_received += other.bytes_received;
+    bytes_sent += other.bytes_sent;
+    datagrams_received += other.datagrams_received;
+    datagrams_sent += other.datagrams_sent;
+    bad_datagrams += other.bad_datagrams;
+    bad_arp += other.bad_arp;
+    arp_hits += other.arp_hits;
+    arp_misses += other.arp_misses;
+    arp_requests_sent += other.arp_requests_sent;
+    arp_replies_sent += other.arp_replies_sent;
+    fragments_sent += other.fragments_sent;
+    too_big += other.too_big;
+    pending_drops.neighbor_full += other.pending_drops.neighbor_full;
+    pending_drops.all_full += other.pending_drops.all_full;
+    pending_drops.unreachable += other.pending_drops.unreachable;
+    pending += other.pending;
+    fragment_bytes += other.fragment_bytes;
+    fragment_drops.timed_out += other.fragment_drops.timed_out;
+    fragment_drops.evicted += other.fragment_drops.evicted;
+    fragment_drops.malformed += other.fragment_drops.malformed;
+    return *this;
+}
+
+optional<size_t> NetworkInterface::time_until_next_event() const {
+    optional<uint64_t> next = _cache.next_expiry();
+    const optional<uint64_t> fragments = _fragments.next_expiry();
+    if (fragments.has_value() && (!next.has_value() || fragments.value() < next.value())) {
+        next = fragments;
+    }
+    if (!_deadlines.empty() && (!next.has_value() || _deadlines.top().first < next.value())) {
+        next = _deadlines.top().first;
+    }
+    if (!next.has_value()) {
+        return {};
+    }
+    return next.value() > _now ? next.value() - _now : 0;
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
+//! \details Cache entries, ARP retries, unreachable neighbors and incomplete datagrams keep the times they
+//! are due, so a tick only touches the ones due in it.
 void NetworkInterface::tick(const size_t ms_since_last_tick) {
-    map<uint32_t, WaitingList>::iterator iter1; 
-    for (iter1 = _queue_map.begin(); iter1 != _queue_map.end(); iter1++) {
-        iter1->second.time_since_last_ARP_request_send += ms_since_last_tick;
-    }
+    _now += ms_since_last_tick;
+    _cache.expire(_now);
+    _fragments.expire(_now);
 
-    map<uint32_t, EthernetAddressEntry>::iterator iter2;
-    queue<uint32_t> deleted_ips;
-    for (iter2 = _cache.begin(); iter2 != _cache.end(); iter2++) {
-        iter2->second.caching_time += ms_since_last_tick;
-        if (iter2->second.caching_time >= NetworkInterface::MAX_CACHE_TIME) {
-            deleted_ips.push(iter2->first);
-        }
-    }
+    while (!_deadlines.empty() && _deadlines.top().first <= _now) {
+        const auto [deadline, ip_addr] = _deadlines.top();
+        _deadlines.pop();
 
-    while (!deleted_ips.empty()) {
-        uint32_t ip = deleted_ips.front();
-        deleted_ips.pop();
-        _cache.erase(ip);
+        // a deadline is stale if its waiting list or unreachable period has ended, or been replaced
+        const auto waiting = _queue_map.find(ip_addr);
+        if (waiting != _queue_map.end() && waiting->second.next_ARP_request == deadline) {
+            retry_ARP_request(waiting);
+            continue;
+        }
+        const auto unreachable = _unreachable.find(ip_addr);
+        if (unreachable != _unreachable.end() && unreachable->second == deadline) {
+            _unreachable.erase(unreachable);
+        }
     }
 }
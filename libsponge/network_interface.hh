@@ -3,19 +3,22 @@
 
 #include "../libsponge/tcp_helpers/ethernet_frame.hh"
 #include "../libsponge/tcp_helpers/tcp_over_ip.hh"
+#include "fragment_reassembler.hh"
+#include "neighbor_table.hh"
+#include "spsc_queue.hh"
 #include "tun.hh"
 
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include <queue>
-#include <map>
-
-typedef struct EthernetAddressEntry{
-    EthernetAddress MAC_address;
-    size_t caching_time;
-}EthernetAddressEntry;
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 typedef struct WaitingList{
-      size_t time_since_last_ARP_request_send = 0;
+      uint64_t next_ARP_request = 0;  //!< when to resend the ARP request, or give up
+      unsigned ARP_requests_sent = 0;
       std::queue<InternetDatagram> waiting_datagram{};
 }WaitingList;
 
@@ -48,10 +51,20 @@ class NetworkInterface {
     //! IP (known as internet-layer or network-layer) address of the interface
     Address _ip_address;
 
+    //! largest datagram sent in one frame; larger ones are sent in fragments
+    size_t _mtu;
+
     //! outbound queue of Ethernet frames that the NetworkInterface wants sent
-    std::queue<EthernetFrame> _frames_out{};
+    SpscQueue<EthernetFrame> _frames_out{};
+
+    //! milliseconds of tick() since construction
+    uint64_t _now{0};
+
+    //! the ARP cache, whose entries expire MAX_CACHE_TIME after they were learned
+    NeighborTable _cache{};
 
-    std::map<uint32_t, EthernetAddressEntry> _cache{};
+    //! fragments of datagrams for this interface, being put back together
+    FragmentReassembler _fragments{};
 
     std::optional<EthernetAddress> get_EthernetAdress(const uint32_t ip_addr);
 
@@ -59,29 +72,115 @@ class NetworkInterface {
 
     void send_ARP_reply(const uint32_t ip_addr, const EthernetAddress& MAC_addr);
 
-    std::map<uint32_t, WaitingList>_queue_map{};
+    std::unordered_map<uint32_t, WaitingList> _queue_map{};
 
-    std::optional<WaitingList>get_WaitingList(const uint32_t ip_addr);
+    //! datagrams in all the waiting lists
+    size_t _pending{0};
 
-    void send_helper(const EthernetAddress MAC_addr, const InternetDatagram &dgram);
+    //! when each neighbor that didn't answer ARP may be tried again
+    std::unordered_map<uint32_t, uint64_t> _unreachable{};
 
-    void queue_helper(const uint32_t ip_addr, const InternetDatagram &dgram);
+    //! heap of (time, address) for ARP retries and the end of unreachable periods, including stale ones
+    using Deadline = std::pair<uint64_t, uint32_t>;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> _deadlines{};
 
-    static constexpr size_t MAX_RETX_WAITING_TIME = 5000; 
+    //! Push a frame onto the outbound queue, and count it
+    void queue_frame(EthernetFrame &&frame);
 
-    static constexpr size_t MAX_CACHE_TIME = 30000;
+    void send_helper(const EthernetAddress &MAC_addr, InternetDatagram &&dgram);
+
+    void queue_helper(const uint32_t ip_addr, InternetDatagram &&dgram);
+
+    //! Send a datagram, or queue it for ARP, once it fits the MTU
+    void send_or_queue(const uint32_t next_hop_ip, InternetDatagram &&dgram);
+
+    //! Resend the ARP request for a waiting list, or give up on the neighbor after MAX_ARP_REQUESTS
+    void retry_ARP_request(std::unordered_map<uint32_t, WaitingList>::iterator iter);
 
     bool valid_frame(const EthernetFrame &frame);
 
-    void cache_mapping(uint32_t ip_addr, EthernetAddress MAC_addr);
+    void cache_mapping(uint32_t ip_addr, const EthernetAddress &MAC_addr);
+
+    void clear_waitinglist(uint32_t ip_addr, const EthernetAddress &MAC_addr);
+  public:
+    //! Milliseconds until the first ARP request is resent; each resend waits twice as long as the last
+    static constexpr size_t MAX_RETX_WAITING_TIME = 5000;
+
+    //! ARP requests sent for a neighbor before giving up on it (at 0, 5 and 15 s; giving up at 35 s)
+    static constexpr unsigned MAX_ARP_REQUESTS = 3;
+
+    //! Milliseconds a neighbor that didn't answer is unreachable: datagrams for it are dropped, without ARP
+    static constexpr size_t UNREACHABLE_TIME = 20000;
+
+    //! Milliseconds a learned Ethernet address is cached
+    static constexpr size_t MAX_CACHE_TIME = 30000;
+
+    //! Most datagrams waiting for any one neighbor; the oldest are dropped for newer ones
+    static constexpr size_t MAX_PENDING_PER_NEIGHBOR = 32;
+
+    //! Most datagrams waiting for all neighbors together; more are dropped
+    static constexpr size_t MAX_PENDING = 1024;
+
+    //! Most neighbors remembered as unreachable; more are forgotten at once
+    static constexpr size_t MAX_UNREACHABLE = 4096;
+
+    //! An MTU that no datagram exceeds, so that none is fragmented
+    static constexpr size_t NO_FRAGMENTS = 65535;
+
+    //! Datagrams dropped while waiting for ARP, by reason
+    struct PendingDrops {
+        uint64_t neighbor_full{0};  //!< the oldest waiting for a neighbor, to make room for a newer one
+        uint64_t all_full{0};       //!< already MAX_PENDING waiting
+        uint64_t unreachable{0};    //!< for a neighbor that didn't answer
+    };
+
+    //! \brief A snapshot of the interface's counters
+    //! \details The counters are kept by the thread that uses the interface, and read only by stats(), so
+    //! counting costs an increment of a field of the interface itself.
+    struct Stats {
+        uint64_t frames_received{0};     //!< for this interface, or broadcast
+        uint64_t frames_ignored{0};      //!< for other interfaces
+        uint64_t frames_sent{0};         //!< queued in frames_out()
+        uint64_t bytes_received{0};      //!< of the payloads of the frames received
+        uint64_t bytes_sent{0};          //!< of the payloads of the frames sent
+        uint64_t datagrams_received{0};  //!< returned by recv_frame(), once whole
+        uint64_t datagrams_sent{0};      //!< given to send_datagram()
+        uint64_t bad_datagrams{0};       //!< IPv4 frames whose datagram didn't parse
+        uint64_t bad_arp{0};             //!< ARP frames whose message didn't parse
+        uint64_t arp_hits{0};            //!< datagrams whose next hop's Ethernet address was known
+        uint64_t arp_misses{0};          //!< datagrams that had to wait for ARP
+        uint64_t arp_requests_sent{0};   //!< including the ones resent
+        uint64_t arp_replies_sent{0};    //!< to requests for this interface's address
+        uint64_t fragments_sent{0};      //!< of datagrams larger than the MTU
+        uint64_t too_big{0};             //!< datagrams larger than the MTU, but marked "don't fragment"
+        PendingDrops pending_drops{};    //!< see pending_drops()
+        size_t pending{0};               //!< datagrams waiting for ARP, at the time of the snapshot
+        size_t fragment_bytes{0};        //!< held for incomplete datagrams, at the time of the snapshot
+
+        //! fragments, and incomplete datagrams, dropped
+        FragmentReassembler::Drops fragment_drops{};
+
+        //! Add the counts of another interface (to sum those of a router)
+        Stats &operator+=(const Stats &other);
+    };
+
+  private:
+    PendingDrops _drops{};
+
+    //! the interface's own counters (the rest of a Stats is filled in by stats())
+    Stats _stats{};
 
-    void clear_waitinglist(uint32_t ip_addr, EthernetAddress MAC_addr);
   public:
     //! \brief Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer) addresses
-    NetworkInterface(const EthernetAddress &ethernet_address, const Address &ip_address);
+    //! \details Datagrams larger than `mtu` are sent in fragments that fit it.
+    NetworkInterface(const EthernetAddress &ethernet_address,
+                     const Address &ip_address,
+                     const size_t mtu = NO_FRAGMENTS);
 
     //! \brief Access queue of Ethernet frames awaiting transmission
-    std::queue<EthernetFrame> &frames_out() { return _frames_out; }
+    //! \details The NetworkInterface's other methods must be called from one thread at a time, but this queue
+    //! may be drained by another (say, one writing the frames to the device) at the same time.
+    SpscQueue<EthernetFrame> &frames_out() { return _frames_out; }
 
     //! \brief Sends an IPv4 datagram, encapsulated in an Ethernet frame (if it knows the Ethernet destination address).
 
@@ -89,15 +188,48 @@ class NetworkInterface {
     //! ("Sending" is accomplished by pushing the frame onto the frames_out queue.)
     void send_datagram(const InternetDatagram &dgram, const Address &next_hop);
 
+    //! \brief Sends an IPv4 datagram that the caller is done with
+    //! \details The datagram's payload moves into the frame (or the queue waiting for ARP) as it is,
+    //! so forwarding a datagram from recv_frame() to frames_out() never copies it, unless it must be
+    //! fragmented to fit the MTU. One too large that mustn't be fragmented is dropped.
+    void send_datagram(InternetDatagram &&dgram, const Address &next_hop);
+
     //! \brief Receives an Ethernet frame and responds appropriately.
 
-    //! If type is IPv4, returns the datagram.
+    //! If type is IPv4, returns the datagram. A fragment of a datagram for this interface's address is held
+    //! until the rest have arrived, and the whole datagram returned then; one for any other address (which
+    //! a router forwards) is returned as it is.
     //! If type is ARP request, learn a mapping from the "sender" fields, and send an ARP reply.
     //! If type is ARP reply, learn a mapping from the "target" fields.
     std::optional<InternetDatagram> recv_frame(const EthernetFrame &frame);
 
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until tick() next has something to do (expire a cached address, resend an ARP
+    //! request, or give up on a neighbor or on a datagram's fragments), or nothing if there is nothing to do
+    std::optional<size_t> time_until_next_event() const;
+
+    //! \brief Datagrams waiting for ARP
+    size_t pending() const { return _pending; }
+
+    //! \brief Neighbors remembered as unreachable
+    size_t unreachable() const { return _unreachable.size(); }
+
+    //! \brief Datagrams dropped while waiting for ARP
+    const PendingDrops &pending_drops() const { return _drops; }
+
+    //! \brief Largest datagram sent in one frame
+    size_t mtu() const { return _mtu; }
+
+    //! \brief Datagrams dropped as too large for the MTU, because they were marked "don't fragment"
+    uint64_t too_big() const { return _stats.too_big; }
+
+    //! \brief Fragments received, and the datagrams being put back together from them
+    const FragmentReassembler &fragments() const { return _fragments; }
+
+    //! \brief A snapshot of the interface's counters
+    Stats stats() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
@@ -0,0 +1,60 @@
+#include "retransmission_queue.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+//! \param[in] abs_seqno the absolute sequence number the segment was sent with
+//! \param[in] seg the segment (only its flags and payload are kept)
+void RetransmissionQueue::push(const uint64_t abs_seqno, const TCPSegment &seg) {
+    if (not _entries.empty() and abs_seqno < _entries.back().end()) {
+        throw runtime_error("RetransmissionQueue::push: segments out of order");
+    }
+    _entries.push_back({abs_seqno, seg.header().syn, seg.header().fin, seg.payload()});
+}
+
+//! \param[in] abs_ackno the absolute ackno from the peer
+void RetransmissionQueue::ack(const uint64_t abs_ackno) {
+    while (not _entries.empty() and _entries.front().end() <= abs_ackno) {
+        _entries.pop_front();
+    }
+    if (_entries.empty() or _entries.front().seqno >= abs_ackno) {
+        return;
+    }
+
+    // the ackno falls inside the front entry
+    Entry &front = _entries.front();
+    uint64_t acked = abs_ackno - front.seqno;
+    if (front.syn) {
+        front.syn = false;
+        front.seqno++;
+        acked--;
+    }
+    const size_t acked_payload = min(acked, static_cast<uint64_t>(front.payload.size()));
+    front.payload.remove_prefix(acked_payload);
+    front.seqno += acked_payload;
+}
+
+//! \param[in] abs_seqno the absolute sequence number to look for
+const RetransmissionQueue::Entry *RetransmissionQueue::find(const uint64_t abs_seqno) const {
+    const auto it =
+        upper_bound(_entries.begin(), _entries.end(), abs_seqno, [](const uint64_t seqno, const Entry &entry) {
+            return seqno < entry.end();
+        });
+    if (it == _entries.end() or abs_seqno < it->seqno) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+//! \param[in] entry the entry to resend
+//! \param[in] isn the initial sequence number of the connection
+TCPSegment RetransmissionQueue::segment(const Entry &entry, const WrappingInt32 isn) {
+    TCPSegment seg;
+    seg.header().seqno = wrap(entry.seqno, isn);
+    seg.header().syn = entry.syn;
+    seg.header().fin = entry.fin;
+    seg.payload() = entry.payload;
+    return seg;
+}
@@ -0,0 +1,55 @@
+#ifndef SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
+#define SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
+
+#include "buffer.hh"
+#include "tcp_segment.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <deque>
+
+//! \brief The segments a TCPSender has sent but the peer hasn't fully acknowledged
+//! \details Entries are kept in order of their absolute sequence numbers, so an ACK only
+//! ever touches the front and a lookup by sequence number is a binary search. Each entry
+//! holds the payload as a Buffer that shares storage with the segment that was sent, and
+//! an entry that is partially acknowledged is trimmed so only the unacknowledged tail is
+//! retransmitted.
+class RetransmissionQueue {
+  public:
+    //! One outstanding segment
+    struct Entry {
+        uint64_t seqno;  //!< absolute sequence number of the first unacknowledged byte (or SYN)
+        bool syn;        //!< does the entry still occupy a sequence number for SYN?
+        bool fin;        //!< does the entry occupy a sequence number for FIN?
+        Buffer payload;  //!< unacknowledged payload
+
+        //! absolute sequence number just past the entry
+        uint64_t end() const { return seqno + syn + payload.size() + fin; }
+    };
+
+  private:
+    std::deque<Entry> _entries{};
+
+  public:
+    //! \brief Remember a segment that was just sent with absolute sequence number `abs_seqno`
+    //! \note Segments must be pushed in sequence-number order.
+    void push(const uint64_t abs_seqno, const TCPSegment &seg);
+
+    //! \brief Forget everything before `abs_ackno`, trimming a partially acknowledged entry
+    void ack(const uint64_t abs_ackno);
+
+    //! \brief The entry whose sequence space contains `abs_seqno`, or `nullptr` if there isn't one
+    const Entry *find(const uint64_t abs_seqno) const;
+
+    //! \brief Rebuild the segment for an entry so it can be sent again
+    static TCPSegment segment(const Entry &entry, const WrappingInt32 isn);
+
+    //! \name Accessors
+    //!@{
+    bool empty() const { return _entries.empty(); }
+    size_t size() const { return _entries.size(); }
+    const Entry &front() const { return _entries.front(); }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
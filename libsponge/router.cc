@@ -1,8 +1,10 @@
 #include "router.hh"
 #include "poptrie.hh"
 
+#include <chrono>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
 using namespace std;
 
 // Dummy implementation of an IP router
@@ -65,19 +67,32 @@ std::unordered_map<uint32_t, RouteEntry>::iterator Router::new_find(const uint32
     }
     return _new_routing_tables[0].end();
 }
-//! \param[in] dgram The datagram to be routed
-void Router::route_one_datagram(InternetDatagram &dgram) {
-    if (dgram.header().ttl <= 1) return;
-    uint32_t destination = dgram.header().dst;
-    auto match_idx = new_find(destination);
-    if (match_idx == _new_routing_tables[0].end()) return;
+const RouteEntry *Router::route_for(InternetDatagram &dgram, RouteCounts &counts) {
+    if (dgram.header().ttl <= 1) {
+        counts.ttl_expired++;
+        return nullptr;
+    }
+    counts.lookups++;
+    auto match_idx = new_find(dgram.header().dst);
+    if (match_idx == _new_routing_tables[0].end()) {
+        counts.no_route++;
+        return nullptr;
+    }
     dgram.header().ttl -= 1;
-    auto next_hop = match_idx->second._next_hop;
-    auto interface_num = match_idx->second._interface_num;
+    counts.routed++;
+    return &match_idx->second;
+}
+
+//! \param[in] dgram The datagram to be routed
+void Router::route_one_datagram(InternetDatagram &&dgram) {
+    const RouteEntry *route = route_for(dgram, _counts);
+    if (route == nullptr) return;
+    const auto &next_hop = route->_next_hop;
     if (next_hop.has_value()) {
-        _interfaces[interface_num].send_datagram(dgram, next_hop.value());
+        _interfaces[route->_interface_num].send_datagram(move(dgram), next_hop.value());
     } else {
-        _interfaces[interface_num].send_datagram(dgram, Address::from_ipv4_numeric(destination));
+        const uint32_t destination = dgram.header().dst;
+        _interfaces[route->_interface_num].send_datagram(move(dgram), Address::from_ipv4_numeric(destination));
     }
     // if (dgram.header().ttl <= 1) return;
     // uint32_t destination = dgram.header().dst;
@@ -106,12 +121,138 @@ void Router::route_one_datagram(InternetDatagram &dgram) {
 }
 
 void Router::route() {
+    if (_running) {
+        throw runtime_error("Router::route() while the workers are routing");
+    }
     // Go through all the interfaces, and route every incoming datagram to its proper outgoing interface.
     for (auto &interface : _interfaces) {
         auto &queue = interface.datagrams_out();
         while (not queue.empty()) {
-            route_one_datagram(queue.front());
+            route_one_datagram(move(queue.front()));
             queue.pop();
         }
     }
 }
+
+void Router::start(const size_t workers) {
+    if (_running or workers == 0 or workers > _interfaces.size()) {
+        throw runtime_error("Router::start() needs from 1 to " + to_string(_interfaces.size()) + " workers");
+    }
+    _frames_in = vector<SpscQueue<EthernetFrame>>(_interfaces.size());
+    _handoffs = vector<SpscQueue<Handoff>>(workers * workers);
+    _worker_counts = vector<RouteCounts>(workers);
+    _worker_count = workers;
+    _running = true;
+    for (size_t worker = 0; worker < workers; worker++) {
+        _workers.emplace_back(&Router::work, this, worker);
+    }
+}
+
+void Router::stop() {
+    if (not _running) {
+        return;
+    }
+    _running = false;
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+
+    // the frames and datagrams still queued, and those they lead to
+    bool busy = true;
+    while (busy) {
+        busy = false;
+        for (size_t worker = 0; worker < _worker_count; worker++) {
+            busy |= work_once(worker, 0);
+        }
+    }
+    _workers.clear();
+
+    for (const auto &counts : _worker_counts) {
+        _counts.lookups += counts.lookups;
+        _counts.routed += counts.routed;
+        _counts.no_route += counts.no_route;
+        _counts.ttl_expired += counts.ttl_expired;
+        _counts.handoffs += counts.handoffs;
+    }
+    _worker_counts.clear();
+}
+
+Router::Stats Router::stats() const {
+    if (_running) {
+        throw runtime_error("Router::stats() while the workers are routing");
+    }
+    Stats stats;
+    stats.route_lookups = _counts.lookups;
+    stats.routed = _counts.routed;
+    stats.no_route = _counts.no_route;
+    stats.ttl_expired = _counts.ttl_expired;
+    stats.handoffs = _counts.handoffs;
+    for (const auto &interface : _interfaces) {
+        stats.interfaces += interface.stats();
+    }
+    return stats;
+}
+
+void Router::deliver_frame(const size_t N, EthernetFrame &&frame) {
+    if (not _running) {
+        throw runtime_error("Router::deliver_frame() without workers");
+    }
+    _frames_in.at(N).push(move(frame));
+}
+
+bool Router::work_once(const size_t worker, const size_t ms) {
+    const size_t workers = _worker_count;
+    RouteCounts &counts = _worker_counts[worker];
+    bool busy = false;
+    for (size_t i = worker; i < _interfaces.size(); i += workers) {
+        auto &interface = _interfaces[i];
+        for (auto &frames = _frames_in[i]; not frames.empty(); frames.pop()) {
+            interface.recv_frame(frames.front());
+            busy = true;
+        }
+
+        for (auto &queue = interface.datagrams_out(); not queue.empty(); queue.pop()) {
+            InternetDatagram &dgram = queue.front();
+            const RouteEntry *route = route_for(dgram, counts);
+            if (route == nullptr) {
+                continue;
+            }
+            const uint32_t next_hop =
+                route->_next_hop.has_value() ? route->_next_hop->ipv4_numeric() : dgram.header().dst;
+            const size_t owner = route->_interface_num % workers;
+            if (owner == worker) {
+                _interfaces[route->_interface_num].send_datagram(move(dgram), Address::from_ipv4_numeric(next_hop));
+            } else {
+                _handoffs[worker * workers + owner].push({move(dgram), next_hop, route->_interface_num});
+                counts.handoffs++;
+            }
+            busy = true;
+        }
+
+        if (ms > 0) {
+            interface.tick(ms);
+        }
+    }
+
+    for (size_t from = 0; from < workers; from++) {
+        for (auto &handoffs = _handoffs[from * workers + worker]; not handoffs.empty(); handoffs.pop()) {
+            Handoff &handoff = handoffs.front();
+            _interfaces[handoff.interface_num].send_datagram(move(handoff.dgram),
+                                                             Address::from_ipv4_numeric(handoff.next_hop));
+            busy = true;
+        }
+    }
+    return busy;
+}
+
+void Router::work(const size_t worker) {
+    auto last_tick = chrono::steady_clock::now();
+    while (_running.load(memory_order_acquire)) {
+        const auto now = chrono::steady_clock::now();
+        const size_t ms = chrono::duration_cast<chrono::milliseconds>(now - last_tick).count();
+        last_tick += chrono::milliseconds(ms);
+        if (not work_once(worker, ms)) {
+            this_thread::yield();
+        }
+    }
+}
@@ -3,10 +3,15 @@
 
 #include "network_interface.hh"
 #include "poptrie.hh"
+#include "spsc_queue.hh"
 
+#include <atomic>
 #include <optional>
 #include <queue>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 // void FREE(radix_node_t *radix, void *cbctx);
 //! \brief A wrapper for NetworkInterface that makes the host-side
 //! interface asynchronous: instead of returning received datagrams
@@ -14,13 +19,13 @@
 //! later retrieval. Otherwise, behaves identically to the underlying
 //! implementation of NetworkInterface.
 class AsyncNetworkInterface : public NetworkInterface {
-    std::queue<InternetDatagram> _datagrams_out{};
+    SpscQueue<InternetDatagram> _datagrams_out{};
 
   public:
     using NetworkInterface::NetworkInterface;
 
     //! Construct from a NetworkInterface
-    AsyncNetworkInterface(NetworkInterface &&interface) : NetworkInterface(interface) {}
+    AsyncNetworkInterface(NetworkInterface &&interface) : NetworkInterface(std::move(interface)) {}
 
     //! \brief Receives and Ethernet frame and responds appropriately.
 
@@ -37,7 +42,8 @@ class AsyncNetworkInterface : public NetworkInterface {
     };
 
     //! Access queue of Internet datagrams that have been received
-    std::queue<InternetDatagram> &datagrams_out() { return _datagrams_out; }
+    //! \details It may be drained by another thread (say, the router's) while this one receives frames.
+    SpscQueue<InternetDatagram> &datagrams_out() { return _datagrams_out; }
 };
 class RouteEntry {
     public:
@@ -67,7 +73,48 @@ class Router {
     //! Send a single datagram from the appropriate outbound interface to the next hop,
     //! as specified by the route with the longest prefix_length that matches the
     //! datagram's destination address.
-    void route_one_datagram(InternetDatagram &dgram);
+    void route_one_datagram(InternetDatagram &&dgram);
+
+    //! What the router has done with the datagrams it was given, as counted by one thread
+    //! \details Each worker counts in its own, on a cache line of its own, and stop() adds them up.
+    struct alignas(64) RouteCounts {
+        uint64_t lookups{0};      //!< routes looked up
+        uint64_t routed{0};       //!< datagrams sent on toward their next hop
+        uint64_t no_route{0};     //!< datagrams dropped for want of a route
+        uint64_t ttl_expired{0};  //!< datagrams dropped because their TTL ran out
+        uint64_t handoffs{0};     //!< datagrams handed to the worker of another interface
+    };
+
+    //! counts of route(), and of the workers since stopped
+    RouteCounts _counts{};
+
+    //! \brief Decrement the TTL of a datagram to forward, and find its route
+    //! \returns the route, or nullptr if the datagram is to be dropped
+    const RouteEntry *route_for(InternetDatagram &dgram, RouteCounts &counts);
+
+    //! A datagram that one worker routed to an interface of another
+    struct Handoff {
+        InternetDatagram dgram{};
+        uint32_t next_hop{0};
+        size_t interface_num{0};
+    };
+
+    //! \name Parallel routing (see start())
+    //!@{
+    std::vector<SpscQueue<EthernetFrame>> _frames_in{};  //!< for each interface, frames from deliver_frame()
+    std::vector<SpscQueue<Handoff>> _handoffs{};         //!< [from * workers + to], datagrams between workers
+    std::vector<std::thread> _workers{};
+    std::vector<RouteCounts> _worker_counts{};           //!< for each worker
+    size_t _worker_count{0};
+    std::atomic<bool> _running{false};
+
+    //! \brief Do what there is to do for the interfaces of one worker, whose clock advanced by `ms`
+    //! \returns whether there was anything
+    bool work_once(const size_t worker, const size_t ms);
+
+    //! The loop of one worker thread
+    void work(const size_t worker);
+    //!@}
 
     std::vector<RouteEntry> _routing_table{};
     std::vector<std::unordered_map<uint32_t, RouteEntry>> _new_routing_tables{33};
@@ -99,10 +146,42 @@ class Router {
 
     //! Route packets between the interfaces
     void route();
+
+    //! \brief Route in parallel, with `workers` threads that each own every `workers`th interface
+    //! \details A worker receives the frames given to its interfaces by deliver_frame(), routes the
+    //! datagrams they carry, sends those for its own interfaces and hands the rest to the worker of the
+    //! outbound interface through a queue of their own, and ticks its interfaces by the time that passes.
+    //! The routing table is shared by the workers, so routes can't be added until stop().
+    //!
+    //! Meanwhile, the only other use of an interface is draining its frames_out(), from one thread.
+    void start(const size_t workers);
+
+    //! \brief Stop the workers, after finishing (on this thread) what they had left to do
+    void stop();
+
+    //! \brief A snapshot of the router's counters, and the sum of its interfaces'
+    struct Stats {
+        uint64_t route_lookups{0};  //!< routes looked up
+        uint64_t routed{0};         //!< datagrams sent on toward their next hop
+        uint64_t no_route{0};       //!< datagrams dropped for want of a route
+        uint64_t ttl_expired{0};    //!< datagrams dropped because their TTL ran out
+        uint64_t handoffs{0};       //!< datagrams handed from one worker to another
+        NetworkInterface::Stats interfaces{};
+    };
+
+    //! \brief A snapshot of the router's counters, and the sum of its interfaces'
+    //! \note Not while the workers are routing: the counters are theirs until stop().
+    Stats stats() const;
+
+    //! \brief Give a frame received by interface `N` to its worker
+    //! \note Only between start() and stop(), and from one thread; before, call interface(N).recv_frame().
+    void deliver_frame(const size_t N, EthernetFrame &&frame);
+
     Router(){
         poptrie = poptrie_init(NULL, 22, 22);
     }
     ~Router(){
+        stop();
         poptrie_release(poptrie);
     }
     Router(const Router&other) = default;
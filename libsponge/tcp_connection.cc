@@ -1,5 +1,6 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
 
 // Dummy implementation of a TCP connection
@@ -20,32 +21,92 @@ size_t TCPConnection::unassembled_bytes() const { return _receiver.unassembled_b
 
 size_t TCPConnection::time_since_last_segment_received() const { return _current_time - _last_received; }
 
+TCPConnection::Stats TCPConnection::stats() const {
+    Stats stats = _stats;
+    stats.acks_saved = _acks_saved;
+    stats.bytes_in_flight = bytes_in_flight();
+    stats.unassembled_bytes = unassembled_bytes();
+    stats.sender = _sender.stats();
+    stats.receiver = _receiver.stats();
+    return stats;
+}
+
 void TCPConnection::segment_received(const TCPSegment &seg) { 
     _last_received = _current_time;
+    _stats.segments_received++;
     auto &header = seg.header();
     bool send_empty = false;
     bool ack_valid = false;
 
+    // PAWS: drop an old duplicate without looking at its ACK, but remind the peer where we are
+    if (_receiver.paws_rejects(seg)) {
+        _stats.paws_rejected++;
+        _sender.send_empty_segment();
+        fill_queue();
+        return;
+    }
+
+    // the peer's SYN settles the options and the segment size for the rest of the connection
+    if (header.syn && !_receiver.ackno().has_value()) {
+        _timestamps_ok = _cfg.timestamps && header.timestamps.has_value();
+        _receiver.set_timestamps(_timestamps_ok);
+        // neither side's MSS may leave a segment without room for its options
+        const size_t mss = max(min(_cfg.mss, TCPConfig::peer_mss(header.mss)), TCPConfig::MIN_MSS);
+        const size_t segment_size = mss - (_timestamps_ok ? TCPHeader::TIMESTAMPS_LENGTH : 0);
+        _segment_size = segment_size;
+        // with segmentation offload, send whole multiples of the segment size for the device to cut up
+        size_t payload_size = segment_size;
+        if (segment_size > 0 and _cfg.tso_size > segment_size) {
+            payload_size = min(_cfg.tso_size, TCPConfig::MAX_TSO_SIZE) / segment_size * segment_size;
+        }
+        _sender.set_max_payload_size(payload_size);
+    }
+
     if (header.ack && (_receiver.ackno().has_value() || header.syn)) {
+        const uint64_t acked_before = _sender.next_seqno_absolute() - _sender.bytes_in_flight();
         ack_valid = _sender.ack_received(header.ackno, header.win);
+        const uint64_t acked_after = _sender.next_seqno_absolute() - _sender.bytes_in_flight();
+        if (ack_valid && _timestamps_ok && header.timestamps.has_value() && acked_after > acked_before) {
+            // the echoed timestamp times this ACK, even if it acknowledges retransmitted data
+            _sender.rtt_sample(static_cast<uint32_t>(_current_time) - header.timestamps->tsecr);
+        }
         if (ack_valid) {
             _sender.fill_window();
         } else {
             send_empty = true;
         }
     }
+    const auto ackno_before = _receiver.ackno();
+    const size_t unassembled_before = _receiver.unassembled_bytes();
     bool rec_valid = _receiver.segment_received(seg);
     if (!_is_initialized && header.syn) {
         connect();
     }
     if ((rec_valid || (header.ack && (_sender.next_seqno() == header.ackno))) && header.rst) {
         _is_reset_received = true;
+        _stats.resets_received++;
         _sender.stream_in().set_error();
         inbound_stream().set_error();
         return;
     }
     if (rec_valid && _segments_out.empty() && seg.length_in_sequence_space()) {
-        send_empty = true;
+        // Only plain in-order data may wait for its ACK: anything that fills or leaves a hole,
+        // or carries SYN/FIN, is ACKed right away so the peer's loss recovery isn't slowed down.
+        const bool in_order = ackno_before.has_value() && header.seqno == ackno_before.value() && !header.syn &&
+                              !header.fin && !unassembled_before && !_receiver.unassembled_bytes();
+        // ACK at least every second full-sized segment (RFC 1122, section 4.2.3.2), counted in bytes so
+        // that short segments add up to full-sized ones
+        _ack_pending_segments++;
+        _ack_pending_bytes += seg.payload().size();
+        if (!_cfg.ack_delay || !in_order || _ack_pending_bytes >= 2 * _segment_size) {
+            send_empty = true;
+        } else if (_ack_pending_segments == 1) {
+            _ack_timer = 0;
+        }
+    } else if (rec_valid && seg.length_in_sequence_space()) {
+        // a segment is still waiting to go (the segments of a batch are all received before any is sent),
+        // so it acknowledges this one too
+        update_seg(_segments_out.back());
     }
     if (!rec_valid && _receiver.ackno().has_value() && !header.rst) {
         send_empty = true;
@@ -66,6 +127,24 @@ bool TCPConnection::active() const {
     return !unclean_shutdown && !clean_shutdown; 
 }
 
+optional<size_t> TCPConnection::time_until_next_event() const {
+    if (!active()) {
+        return {};
+    }
+    optional<size_t> next = _sender.time_until_retransmission();
+    const auto sooner = [&next](const size_t ms) { next = next.has_value() ? min(next.value(), ms) : ms; };
+    if (_ack_pending_segments && _cfg.ack_delay) {
+        sooner(_ack_timer >= _cfg.ack_delay ? 0 : _cfg.ack_delay - _ack_timer);
+    }
+    if (_linger_after_streams_finish && !unassembled_bytes() && _receiver.stream_out().eof() &&
+        _sender.stream_in().eof() && !bytes_in_flight()) {
+        const size_t linger = 10 * _cfg.rt_timeout;
+        const size_t waited = time_since_last_segment_received();
+        sooner(waited >= linger ? 0 : linger - waited);
+    }
+    return next;
+}
+
 size_t TCPConnection::write(const string &data) {
     if (!data.size())
         return 0;
@@ -79,6 +158,12 @@ size_t TCPConnection::write(const string &data) {
 void TCPConnection::tick(const size_t ms_since_last_tick) { 
     _current_time += ms_since_last_tick;
     _sender.tick(ms_since_last_tick);
+    if (_ack_pending_segments) {
+        _ack_timer += ms_since_last_tick;
+        if (_ack_timer >= _cfg.ack_delay && _sender.segments_out().empty()) {
+            _sender.send_empty_segment();
+        }
+    }
     fill_queue();
 }
 
@@ -88,6 +173,24 @@ void TCPConnection::end_input_stream() {
     fill_queue();
 }
 
+void TCPConnection::inbound_stream_read() {
+    if (!_receiver.ackno().has_value() || _receiver.stream_out().input_ended() || !active()) {
+        return;
+    }
+    // receiver-side silly window syndrome avoidance (RFC 1122, section 4.2.3.3)
+    const size_t full_segment = min(static_cast<size_t>(_cfg.mss), _cfg.recv_capacity / 2);
+    if (_window_sent < full_segment && _receiver.window_size() >= full_segment) {
+        _sender.send_empty_segment();
+        fill_queue();
+    }
+}
+
+void TCPConnection::uncork() {
+    _sender.set_corked(false);
+    _sender.fill_window();
+    fill_queue();
+}
+
 void TCPConnection::connect() {
     _is_initialized = true;
     _sender.fill_window();
@@ -107,6 +210,19 @@ void TCPConnection::update_seg(TCPSegment &seg) {//设置发送段的ack和标
         }
     }
     seg.header().win = _receiver.window_size();
+    _window_sent = seg.header().win;
+
+    if (!seg.header().rst) {
+        if (seg.header().syn) {
+            seg.header().mss = _cfg.mss;
+        }
+        const bool offer_timestamps = seg.header().syn && _cfg.timestamps && !ackno.has_value();
+        if (_timestamps_ok || offer_timestamps) {
+            seg.header().timestamps =
+                TCPTimestamps{static_cast<uint32_t>(_current_time), _receiver.ts_recent().value_or(0)};
+        }
+        seg.header().doff = (TCPHeader::LENGTH + seg.header().options_length()) / 4;
+    }
 }
 
 void TCPConnection::fill_queue() { //将发送段放入队列
@@ -121,6 +237,14 @@ void TCPConnection::fill_queue() { //将发送段放入队列
         }
         sender_out.pop();
         update_seg(seg);
+        if (_ack_pending_segments && seg.header().ack) {
+            // this segment acknowledges everything received so far
+            _acks_saved += _ack_pending_segments - (seg.length_in_sequence_space() ? 0 : 1);
+            _ack_pending_segments = 0;
+            _ack_pending_bytes = 0;
+        }
+        _stats.segments_sent++;
+        _stats.resets_sent += seg.header().rst;
         _segments_out.push(seg);
     }
 }
@@ -27,6 +27,42 @@ class TCPConnection {
     bool _use_rst_seqno{false};
     WrappingInt32 _rst_seqno{0};
 
+    //! Did both SYNs carry the timestamps option? If so, every non-RST segment carries it too
+    bool _timestamps_ok{false};
+
+    //! Payload of a full-sized segment (the MSS both SYNs settled on, less options), either way
+    size_t _segment_size{TCPConfig::MAX_PAYLOAD_SIZE};
+
+    //! \name Delayed ACKs ([RFC 1122](\ref rfc::rfc1122), section 4.2.3.2)
+    //!@{
+    size_t _ack_pending_segments{0};  //!< received segments whose ACK hasn't gone out yet
+    size_t _ack_pending_bytes{0};     //!< their payload; two full-sized segments' worth is ACKed at once
+    size_t _ack_timer{0};             //!< ms since the oldest of those segments arrived
+    uint64_t _acks_saved{0};          //!< ACK-only segments that were folded into a later segment
+    //!@}
+
+    //! the window in the last segment sent, to tell when reading from inbound_stream() reopens it
+    size_t _window_sent{0};
+
+  public:
+    //! \brief A snapshot of the connection's counters, and of its sender's and receiver's
+    struct Stats {
+        uint64_t segments_received{0};  //!< segments given to segment_received()
+        uint64_t segments_sent{0};      //!< segments queued in segments_out()
+        uint64_t resets_received{0};    //!< RSTs that reset the connection
+        uint64_t resets_sent{0};        //!< RSTs queued
+        uint64_t paws_rejected{0};      //!< segments dropped as old duplicates by PAWS
+        uint64_t acks_saved{0};         //!< see acks_saved()
+        size_t bytes_in_flight{0};      //!< at the time of the snapshot
+        size_t unassembled_bytes{0};    //!< held by the receiver's reassembler, at the time of the snapshot
+        TCPSender::Stats sender{};
+        TCPReceiver::Stats receiver{};
+    };
+
+  private:
+    //! the connection's own counters (the rest of a Stats is filled in by stats())
+    Stats _stats{};
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -43,6 +79,15 @@ class TCPConnection {
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Stop sending segments shorter than the maximum payload size (like `TCP_CORK`)
+    void cork() { _sender.set_corked(true); }
+
+    //! \brief Send whatever cork() held back, and go back to sending short segments
+    void uncork();
+
+    //! \brief Is the outbound data corked?
+    bool corked() const { return _sender.corked(); }
     //!@}
 
     //! \name "Output" interface for the reader
@@ -50,6 +95,12 @@ class TCPConnection {
 
     //! \brief The inbound byte stream received from the peer
     ByteStream &inbound_stream() { return _receiver.stream_out(); }
+
+    //! \brief Tell the connection that the reader has taken bytes from inbound_stream()
+    //! \details If the last window sent was too small for a full segment and the read opened it to one
+    //! (or to half the receive capacity, if that's smaller), sends a window update right away, so that the
+    //! peer doesn't have to wait for a retransmission timeout to probe the window.
+    void inbound_stream_read();
     //!@}
 
     //! \name Accessors used for testing
@@ -63,6 +114,14 @@ class TCPConnection {
     size_t time_since_last_segment_received() const;
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
+    //! \brief Milliseconds until tick() next has something to do (retransmit, send a delayed ACK,
+    //! or stop lingering), or nothing if only a segment or a write can wake the connection up
+    std::optional<size_t> time_until_next_event() const;
+    //! \brief Number of ACK-only segments not sent because their ACK rode on a later segment
+    uint64_t acks_saved() const { return _acks_saved; }
+
+    //! \brief A snapshot of the connection's counters, and of its sender's and receiver's
+    Stats stats() const;
     //!@}
 
     //! \name Methods for the owner or operating system to call
@@ -87,7 +146,7 @@ class TCPConnection {
     //!@}
 
     //! Construct a new connection from a configuration
-    explicit TCPConnection(const TCPConfig &cfg) : _cfg{cfg} {}
+    explicit TCPConnection(const TCPConfig &cfg) : _cfg{cfg} { _sender.set_nagle(_cfg.nagle); }
 
     //! \name construction and destruction
     //! moving is allowed; copying is disallowed; default construction not possible
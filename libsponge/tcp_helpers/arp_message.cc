@@ -9,33 +9,24 @@ using namespace std;
 ParseResult ARPMessage::parse(const Buffer buffer) {
     NetParser p{buffer};
 
-    if (p.buffer().size() < ARPMessage::LENGTH) {
-        return ParseResult::PacketTooShort;
+    tie(hardware_type,
+        protocol_type,
+        hardware_address_size,
+        protocol_address_size,
+        opcode,
+        sender_ethernet_address,
+        sender_ip_address,
+        target_ethernet_address,
+        target_ip_address) = p.fields<Layout>();
+
+    if (p.error()) {
+        return p.get_error();
     }
-
-    hardware_type = p.u16();
-    protocol_type = p.u16();
-    hardware_address_size = p.u8();
-    protocol_address_size = p.u8();
-    opcode = p.u16();
-
     if (not supported()) {
         return ParseResult::Unsupported;
     }
 
-    // read sender addresses (Ethernet and IP)
-    for (auto &byte : sender_ethernet_address) {
-        byte = p.u8();
-    }
-    sender_ip_address = p.u32();
-
-    // read target addresses (Ethernet and IP)
-    for (auto &byte : target_ethernet_address) {
-        byte = p.u8();
-    }
-    target_ip_address = p.u32();
-
-    return p.get_error();
+    return ParseResult::NoError;
 }
 
 bool ARPMessage::supported() const {
@@ -45,31 +36,30 @@ bool ARPMessage::supported() const {
 }
 
 string ARPMessage::serialize() const {
+    string ret(LENGTH, 0);
+    serialize_into(ret.data(), ret.size());
+    return ret;
+}
+
+void ARPMessage::serialize_into(char *out, const size_t size) const {
     if (not supported()) {
         throw runtime_error(
             "ARPMessage::serialize(): unsupported field combination (must be Ethernet/IP, and request or reply)");
     }
-
-    string ret;
-    NetUnparser::u16(ret, hardware_type);
-    NetUnparser::u16(ret, protocol_type);
-    NetUnparser::u8(ret, hardware_address_size);
-    NetUnparser::u8(ret, protocol_address_size);
-    NetUnparser::u16(ret, opcode);
-
-    /* write sender addresses */
-    for (auto &byte : sender_ethernet_address) {
-        NetUnparser::u8(ret, byte);
+    if (size < LENGTH) {
+        throw runtime_error("ARPMessage::serialize_into: no room for the message");
     }
-    NetUnparser::u32(ret, sender_ip_address);
 
-    /* write target addresses */
-    for (auto &byte : target_ethernet_address) {
-        NetUnparser::u8(ret, byte);
-    }
-    NetUnparser::u32(ret, target_ip_address);
-
-    return ret;
+    Layout::store(out,
+                  {hardware_type,
+                   protocol_type,
+                   hardware_address_size,
+                   protocol_address_size,
+                   opcode,
+                   sender_ethernet_address,
+                   sender_ip_address,
+                   target_ethernet_address,
+                   target_ip_address});
 }
 
 string ARPMessage::to_string() const {
@@ -28,12 +28,27 @@ struct ARPMessage {
     uint32_t target_ip_address{};
     //!@}
 
+    //! The message: hardware and protocol types and address sizes, opcode, then sender and target addresses
+    using Layout = HeaderLayout<uint16_t,
+                                uint16_t,
+                                uint8_t,
+                                uint8_t,
+                                uint16_t,
+                                EthernetAddress,
+                                uint32_t,
+                                EthernetAddress,
+                                uint32_t>;
+    static_assert(Layout::SIZE == LENGTH);
+
     //! Parse the ARP message from a string
     ParseResult parse(const Buffer buffer);
 
     //! Serialize the ARP message to a string
     std::string serialize() const;
 
+    //! Serialize the ARP message into `out`, which must have room for #LENGTH bytes
+    void serialize_into(char *out, const size_t size) const;
+
     //! Return a string containing the ARP message in human-readable format
     std::string to_string() const;
 
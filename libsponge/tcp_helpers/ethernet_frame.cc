@@ -5,6 +5,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 using namespace std;
 
@@ -17,8 +18,10 @@ ParseResult EthernetFrame::parse(const Buffer buffer) {
 }
 
 BufferList EthernetFrame::serialize() const {
+    string header(EthernetHeader::LENGTH, 0);
+    _header.serialize_into(header.data(), header.size());
     BufferList ret;
-    ret.append(_header.serialize());
+    ret.append(move(header));
     ret.append(_payload);
     return ret;
 }
@@ -8,44 +8,25 @@
 using namespace std;
 
 ParseResult EthernetHeader::parse(NetParser &p) {
-    if (p.buffer().size() < EthernetHeader::LENGTH) {
-        return ParseResult::PacketTooShort;
-    }
-
-    /* read destination address */
-    for (auto &byte : dst) {
-        byte = p.u8();
-    }
-
-    /* read source address */
-    for (auto &byte : src) {
-        byte = p.u8();
-    }
-
-    /* read the frame's type (e.g. IPv4, ARP, or something else) */
-    type = p.u16();
+    /* read destination and source addresses, and the frame's type (e.g. IPv4, ARP, or something else) */
+    tie(dst, src, type) = p.fields<Layout>();
 
     return p.get_error();
 }
 
 string EthernetHeader::serialize() const {
-    string ret;
-    ret.reserve(LENGTH);
-
-    /* write destination address */
-    for (auto &byte : dst) {
-        NetUnparser::u8(ret, byte);
-    }
+    string ret(LENGTH, 0);
+    serialize_into(ret.data(), ret.size());
+    return ret;
+}
 
-    /* write source address */
-    for (auto &byte : src) {
-        NetUnparser::u8(ret, byte);
+void EthernetHeader::serialize_into(char *out, const size_t size) const {
+    if (size < LENGTH) {
+        throw runtime_error("EthernetHeader::serialize_into: no room for the header");
     }
 
-    /* write the frame's type (e.g. IPv4, ARP or something else) */
-    NetUnparser::u16(ret, type);
-
-    return ret;
+    /* write destination and source addresses, and the frame's type (e.g. IPv4, ARP or something else) */
+    Layout::store(out, {dst, src, type});
 }
 
 //! \returns A string with a textual representation of an Ethernet address
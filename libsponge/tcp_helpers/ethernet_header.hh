@@ -27,12 +27,19 @@ struct EthernetHeader {
     uint16_t type;
     //!@}
 
+    //! The header: destination, source and type
+    using Layout = HeaderLayout<EthernetAddress, EthernetAddress, uint16_t>;
+    static_assert(Layout::SIZE == LENGTH);
+
     //! Parse the Ethernet fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the Ethernet fields to a string
     std::string serialize() const;
 
+    //! Serialize the Ethernet fields into `out`, which must have room for #LENGTH bytes
+    void serialize_into(char *out, const size_t size) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 };
@@ -1,11 +1,22 @@
 #include "fd_adapter.hh"
 
+#include "datagram_ring.hh"
+
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <utility>
 
 using namespace std;
 
+TCPOverUDPSocketAdapter::TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(move(sock)) {}
+
+TCPOverUDPSocketAdapter::~TCPOverUDPSocketAdapter() = default;
+
+TCPOverUDPSocketAdapter::TCPOverUDPSocketAdapter(TCPOverUDPSocketAdapter &&other) = default;
+
+TCPOverUDPSocketAdapter &TCPOverUDPSocketAdapter::operator=(TCPOverUDPSocketAdapter &&other) = default;
+
 //! \details This function first attempts to parse a TCP segment from the next UDP
 //! payload recv()d from the socket.
 //!
@@ -19,8 +30,41 @@ using namespace std;
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
 optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
+    if (_ring) {
+        auto datagram = _ring->recv_datagram();
+        _ring->flush();
+        return datagram.has_value() ? _unwrap(datagram.value()) : nullopt;
+    }
     auto datagram = _sock.recv();
+    return _unwrap(datagram);
+}
+
+//! \details See read() for which segments are kept; the listening flag is cleared by the first SYN in
+//! the batch, and the datagrams after it are checked against its sender.
+//! \param[out] segments has the segments appended
+void TCPOverUDPSocketAdapter::read_batch(vector<TCPSegment> &segments) {
+    if (_ring) {
+        // everything the ring has received, with the receives posted again in one system call
+        while (auto datagram = _ring->recv_datagram()) {
+            auto seg = _unwrap(datagram.value());
+            if (seg.has_value()) {
+                segments.push_back(move(seg.value()));
+            }
+        }
+        _ring->flush();
+        return;
+    }
+
+    const size_t received = _sock.recv_many(_batch, BATCH_SIZE);
+    for (size_t i = 0; i < received; i++) {
+        auto seg = _unwrap(_batch[i]);
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+    }
+}
 
+optional<TCPSegment> TCPOverUDPSocketAdapter::_unwrap(UDPSocket::received_datagram &datagram) {
     // is it for us?
     if (not listening() and (datagram.source_address != config().destination)) {
         return {};
@@ -50,8 +94,60 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
+    if (_ring) {
+        _ring->sendto(config().destination, seg.serialize(0));
+        _ring->flush();
+        return;
+    }
     _sock.sendto(config().destination, seg.serialize(0));
 }
 
+//! \param[in,out] segments are the TCP segments to write; each is addressed as by write()
+void TCPOverUDPSocketAdapter::write_batch(queue<TCPSegment> &segments) {
+    vector<BufferList> serialized;
+    serialized.reserve(segments.size());
+    while (not segments.empty()) {
+        TCPSegment &seg = segments.front();
+        seg.header().sport = config().source.port();
+        seg.header().dport = config().destination.port();
+        serialized.push_back(seg.serialize(0));
+        segments.pop();
+    }
+    const vector<BufferViewList> payloads{serialized.begin(), serialized.end()};
+    if (_ring) {
+        for (const auto &payload : payloads) {
+            _ring->sendto(config().destination, payload);
+        }
+        _ring->flush();
+    } else if (_offload) {
+        // a train of full-sized segments goes to the kernel in one piece
+        _sock.send_segmented(config().destination, payloads);
+    } else {
+        _sock.send_many(config().destination, payloads);
+    }
+}
+
+bool TCPOverUDPSocketAdapter::enable_offload() {
+    if (_ring) {
+        return false;
+    }
+    _offload = _sock.gso_supported() and _sock.enable_gro();
+    return _offload;
+}
+
+//! \details The ring's buffers hold one datagram each, which is why offload (where one datagram
+//! received may be many segments) can't be used with it.
+bool TCPOverUDPSocketAdapter::enable_io_uring() {
+    if (_offload or not DatagramRing::available()) {
+        return false;
+    }
+    if (not _ring) {
+        _ring = make_unique<DatagramRing>(_sock, DatagramRing::Kind::Socket, DatagramRing::DEFAULT_DEPTH, RING_MTU);
+    }
+    return true;
+}
+
+const FileDescriptor &TCPOverUDPSocketAdapter::watched_fd() const { return _ring ? _ring->fd() : _sock; }
+
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
 template class LossyFdAdapter<TCPOverUDPSocketAdapter>;
@@ -8,8 +8,13 @@
 #include "tcp_header.hh"
 #include "tcp_segment.hh"
 
+#include <memory>
 #include <optional>
+#include <queue>
 #include <utility>
+#include <vector>
+
+class DatagramRing;
 
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
@@ -40,6 +45,9 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! Milliseconds until tick() next has something to do, or nothing if it never will unprompted
+    std::optional<size_t> time_until_next_event() const { return {}; }
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
@@ -47,9 +55,33 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
   private:
     UDPSocket _sock;
 
+    std::vector<UDPSocket::received_datagram> _batch{};  //!< reused by read_batch()
+
+    bool _offload{false};  //!< send with UDP GSO and receive with UDP GRO?
+
+    std::unique_ptr<DatagramRing> _ring{};  //!< if set, does all the I/O on `_sock` (see enable_io_uring())
+
+    //! Parse the TCP segment in a received datagram, if it is valid and related to the current connection
+    std::optional<TCPSegment> _unwrap(UDPSocket::received_datagram &datagram);
+
   public:
+    //! Most segments read_batch() takes with one system call
+    static constexpr size_t BATCH_SIZE = 64;
+
+    //! Largest datagram received or sent through the ring, with room for a full TCPConfig::MAX_PAYLOAD_SIZE
+    static constexpr size_t RING_MTU = 2048;
+
     //! Construct from a UDPSocket sliced into a FileDescriptor
-    explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
+    explicit TCPOverUDPSocketAdapter(UDPSocket &&sock);
+
+    ~TCPOverUDPSocketAdapter();
+
+    //! \name
+    //! Moved with its ring, if any
+    //!@{
+    TCPOverUDPSocketAdapter(TCPOverUDPSocketAdapter &&other);
+    TCPOverUDPSocketAdapter &operator=(TCPOverUDPSocketAdapter &&other);
+    //!@}
 
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
@@ -57,6 +89,28 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
+    //! Reads the datagrams waiting (up to BATCH_SIZE) with one system call, and appends the TCP
+    //! segments related to the current connection to `segments`
+    void read_batch(std::vector<TCPSegment> &segments);
+
+    //! Writes every segment in `segments` (leaving it empty), as many per system call as possible
+    void write_batch(std::queue<TCPSegment> &segments);
+
+    //! \brief Write batches with UDP GSO and read them with UDP GRO, if the kernel supports both
+    //! \returns whether it does (if not, nothing changes)
+    //! \note Afterwards only read_batch() can read, as one datagram received may hold several segments.
+    bool enable_offload();
+
+    //! \brief Receive and send through a DatagramRing, if io_uring is available and offload isn't enabled
+    //! \details Receives are kept posted, and each read_batch() or write_batch() passes everything it
+    //! queued to the kernel with one system call. Wait on watched_fd() rather than the socket afterwards,
+    //! and use the adapter from one thread only (see DatagramRing).
+    //! \returns whether the ring is used (if not, nothing changes)
+    bool enable_io_uring();
+
+    //! The file descriptor to wait on before read_batch() and write_batch(): the socket, or the ring's
+    const FileDescriptor &watched_fd() const;
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
@@ -5,37 +5,49 @@
 
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 using namespace std;
 
+//! \details Whatever follows the `len` bytes of the datagram (say, the padding of a minimum-size Ethernet
+//! frame) is left out of the payload.
 ParseResult IPv4Datagram::parse(const Buffer buffer) {
     NetParser p{buffer};
     _header.parse(p);
     _payload = p.buffer();
 
-    if (_payload.size() != _header.payload_length()) {
+    const size_t payload_length = _header.payload_length();
+    if (_payload.size() < payload_length) {
         return ParseResult::PacketTooShort;
     }
+    if (_payload.size() > payload_length) {
+        // only a short datagram is padded, so copying what is left of it is cheap
+        _payload = Buffer{string{p.buffer().str().substr(0, payload_length)}};
+    }
 
     return p.get_error();
 }
 
-BufferList IPv4Datagram::serialize() const {
-    if (_payload.size() != _header.payload_length()) {
+//! The header of a datagram with `payload`, with its checksum filled in
+static string serialize_header(const IPv4Header &header, const BufferList &payload) {
+    if (payload.size() != header.payload_length()) {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
-    IPv4Header header_out = _header;
-    header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
-
-    // calculate checksum -- taken over header only
-    InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
+    // the checksum is taken over the header only, as it is written
+    string ret(4 * header.hlen, 0);
+    header.serialize_into(ret.data(), ret.size());
+    return ret;
+}
 
-    BufferList ret;
-    ret.append(header_out.serialize());
+BufferList IPv4Datagram::serialize() const & {
+    BufferList ret{serialize_header(_header, _payload)};
     ret.append(_payload);
     return ret;
 }
+
+BufferList IPv4Datagram::serialize() && {
+    BufferList ret{serialize_header(_header, _payload)};
+    ret.append(move(_payload));
+    return ret;
+}
@@ -15,7 +15,10 @@ class IPv4Datagram {
     ParseResult parse(const Buffer buffer);
 
     //! \brief Serialize the segment to a string
-    BufferList serialize() const;
+    BufferList serialize() const &;
+
+    //! \brief Serialize the segment to a string, moving the payload into it
+    BufferList serialize() &&;
 
     //! \name Accessors
     //!@{
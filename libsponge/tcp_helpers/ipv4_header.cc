@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <iomanip>
 #include <sstream>
@@ -20,6 +21,8 @@ using namespace std;
 //! - there is less data in the header than the `doff` field claims
 //! - there is less data in the full datagram than the `len` field claims
 //! - the checksum is bad
+//!
+//! More data than `len` claims is fine: a short datagram arrives with the padding of the frame it came in.
 ParseResult IPv4Header::parse(NetParser &p) {
     Buffer original_serialized_version = p.buffer();
 
@@ -28,24 +31,17 @@ ParseResult IPv4Header::parse(NetParser &p) {
         return ParseResult::PacketTooShort;
     }
 
-    const uint8_t first_byte = p.u8();
+    uint8_t first_byte = 0;
+    uint16_t fo_val = 0;
+    tie(first_byte, tos, len, id, fo_val, ttl, proto, cksum, src, dst) = p.fields<Layout>();
+
     ver = first_byte >> 4;     // version
     hlen = first_byte & 0x0f;  // header length
-    tos = p.u8();              // type of service
-    len = p.u16();             // length
-    id = p.u16();              // id
 
-    const uint16_t fo_val = p.u16();
     df = static_cast<bool>(fo_val & 0x4000);  // don't fragment
     mf = static_cast<bool>(fo_val & 0x2000);  // more fragments
     offset = fo_val & 0x1fff;                 // offset
 
-    ttl = p.u8();     // ttl
-    proto = p.u8();   // proto
-    cksum = p.u16();  // checksum
-    src = p.u32();    // source address
-    dst = p.u32();    // destination address
-
     if (data_size < 4 * hlen) {
         return ParseResult::PacketTooShort;
     }
@@ -55,7 +51,7 @@ ParseResult IPv4Header::parse(NetParser &p) {
     if (hlen < 5) {
         return ParseResult::HeaderTooShort;
     }
-    if (data_size != len) {
+    if (data_size < len or len < 4 * hlen) {
         return ParseResult::TruncatedPacket;
     }
 
@@ -74,39 +70,47 @@ ParseResult IPv4Header::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the IPv4Header to a string (does not recompute the checksum)
-string IPv4Header::serialize() const {
+//! The fields of `header` as they are written, with checksum `checksum`
+static IPv4Header::Layout::Values layout_values(const IPv4Header &header, const uint16_t checksum) {
     // sanity checks
-    if (ver != 4) {
+    if (header.ver != 4) {
         throw runtime_error("wrong IP version");
     }
-    if (4 * hlen < IPv4Header::LENGTH) {
+    if (4 * header.hlen < IPv4Header::LENGTH) {
         throw runtime_error("IP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * hlen);
-
-    const uint8_t first_byte = (ver << 4) | (hlen & 0xf);
-    NetUnparser::u8(ret, first_byte);  // version and header length
-    NetUnparser::u8(ret, tos);         // type of service
-    NetUnparser::u16(ret, len);        // length
-    NetUnparser::u16(ret, id);         // id
-
-    const uint16_t fo_val = (df ? 0x4000 : 0) | (mf ? 0x2000 : 0) | (offset & 0x1fff);
-    NetUnparser::u16(ret, fo_val);  // flags and offset
-
-    NetUnparser::u8(ret, ttl);    // time to live
-    NetUnparser::u8(ret, proto);  // protocol number
-
-    NetUnparser::u16(ret, cksum);  // checksum
+    const uint8_t first_byte = (header.ver << 4) | (header.hlen & 0xf);  // version and header length
+    const uint16_t fo_val = (header.df ? 0x4000 : 0) | (header.mf ? 0x2000 : 0) | (header.offset & 0x1fff);
+    return {first_byte,
+            header.tos,
+            header.len,
+            header.id,
+            fo_val,
+            header.ttl,
+            header.proto,
+            checksum,
+            header.src,
+            header.dst};
+}
 
-    NetUnparser::u32(ret, src);  // src address
-    NetUnparser::u32(ret, dst);  // dst address
+//! Serialize the IPv4Header to a string (does not recompute the checksum)
+string IPv4Header::serialize() const {
+    string ret(4 * hlen, 0);  // the header at its advertised size
+    Layout::store(ret.data(), layout_values(*this, cksum));
+    return ret;
+}
 
-    ret.resize(4 * hlen);  // expand header to advertised size
+//! \details Any space for options is zeroed.
+void IPv4Header::serialize_into(char *out, const size_t size) const {
+    if (size < 4 * hlen) {
+        throw runtime_error("IPv4Header::serialize_into: no room for the header");
+    }
 
-    return ret;
+    const auto values = layout_values(*this, 0);
+    Layout::store(out, values);
+    fill(out + LENGTH, out + 4 * hlen, 0);
+    store_field(out + Layout::OFFSETS[7], InternetChecksum{Layout::sum(values)}.value());
 }
 
 uint16_t IPv4Header::payload_length() const { return len - 4 * hlen; }
@@ -46,12 +46,22 @@ struct IPv4Header {
     uint32_t dst = 0;           //!< dst address
     //!@}
 
+    //! The fixed header: version and IHL, type of service, total length, identification, flags and
+    //! fragment offset, time to live, protocol, checksum, source and destination
+    using Layout =
+        HeaderLayout<uint8_t, uint8_t, uint16_t, uint16_t, uint16_t, uint8_t, uint8_t, uint16_t, uint32_t, uint32_t>;
+    static_assert(Layout::SIZE == LENGTH);
+
     //! Parse the IP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! \brief Serialize the IP fields into `out`, which must have room for `4 * hlen` bytes, computing the
+    //! header checksum from them as they are written (and writing it instead of `cksum`)
+    void serialize_into(char *out, const size_t size) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
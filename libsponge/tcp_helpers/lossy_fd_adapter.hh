@@ -7,8 +7,10 @@
 #include "util.hh"
 
 #include <optional>
+#include <queue>
 #include <random>
 #include <utility>
+#include <vector>
 
 //! An adapter class that adds random dropping behavior to an FD adapter
 template <typename AdapterT>
@@ -56,6 +58,33 @@ class LossyFdAdapter {
         return _adapter.write(seg);
     }
 
+    //! \brief Read a batch from the underlying AdapterT instance, potentially dropping each segment read
+    //! \param[out] segments has the segments that weren't dropped appended
+    void read_batch(std::vector<TCPSegment> &segments) {
+        const size_t first = segments.size();
+        _adapter.read_batch(segments);
+        size_t kept = first;
+        for (size_t i = first; i < segments.size(); i++) {
+            if (not _should_drop(false)) {
+                segments[kept++] = std::move(segments[i]);
+            }
+        }
+        segments.resize(kept);
+    }
+
+    //! \brief Write a batch to the underlying AdapterT instance, potentially dropping each segment
+    //! \param[in,out] segments are the segments to either write or drop (left empty)
+    void write_batch(std::queue<TCPSegment> &segments) {
+        std::queue<TCPSegment> kept;
+        while (not segments.empty()) {
+            if (not _should_drop(true)) {
+                kept.push(std::move(segments.front()));
+            }
+            segments.pop();
+        }
+        _adapter.write_batch(kept);
+    }
+
     //! \name
     //! Passthrough functions to the underlying AdapterT instance
 
@@ -63,9 +92,13 @@ class LossyFdAdapter {
     void set_listening(const bool l) { _adapter.set_listening(l); }      //!< FdAdapterBase::set_listening passthrough
     const FdAdapterConfig &config() const { return _adapter.config(); }  //!< FdAdapterBase::config passthrough
     FdAdapterConfig &config_mut() { return _adapter.config_mut(); }      //!< FdAdapterBase::config_mut passthrough
+    const FileDescriptor &watched_fd() const { return _adapter.watched_fd(); }  //!< AdapterT::watched_fd passthrough
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
+
+    //! \brief FdAdapterBase::time_until_next_event passthrough
+    std::optional<size_t> time_until_next_event() const { return _adapter.time_until_next_event(); }
     //!@}
 };
 
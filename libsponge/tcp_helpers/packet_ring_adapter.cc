@@ -0,0 +1,110 @@
+#include "packet_ring_adapter.hh"
+
+#include "ethernet_frame.hh"
+
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] ring Packet socket that will be owned by the adapter
+//! \param[in] eth_address Ethernet address (local address) of the adapter
+//! \param[in] ip_address IP address (local address) of the adapter
+//! \param[in] next_hop IP address of the next hop (typically a router or default gateway)
+//! \param[in] mtu Largest IPv4 datagram to send in one frame; use TCPConfig::mss_for_mtu() to size segments
+//!            to match, as larger ones are sent in fragments
+TCPOverIPv4OverPacketRingAdapter::TCPOverIPv4OverPacketRingAdapter(unique_ptr<PacketRing> &&ring,
+                                                                   const EthernetAddress &eth_address,
+                                                                   const Address &ip_address,
+                                                                   const Address &next_hop,
+                                                                   const size_t mtu)
+    : _ring(move(ring)), _interface(eth_address, ip_address, mtu), _next_hop(next_hop), _mtu(mtu) {
+    if (not _ring) {
+        throw runtime_error("TCPOverIPv4OverPacketRingAdapter: no PacketRing");
+    }
+}
+
+optional<TCPSegment> TCPOverIPv4OverPacketRingAdapter::_recv_frame(const string_view frame, const bool check_sum) {
+    EthernetFrame eth_frame;
+    if (eth_frame.parse(Buffer{string(frame)}) != ParseResult::NoError) {
+        return {};
+    }
+
+    // Give the frame to the NetworkInterface. Get back an Internet datagram if frame was carrying one.
+    optional<InternetDatagram> ip_dgram = _interface.recv_frame(eth_frame);
+    if (ip_dgram) {
+        return unwrap_tcp_in_ip(ip_dgram.value(), check_sum);
+    }
+    return {};
+}
+
+optional<TCPSegment> TCPOverIPv4OverPacketRingAdapter::read() {
+    if (_segments_read.empty()) {
+        _ring->recv_frames([&](const string_view frame, const bool check_sum) {
+            auto seg = _recv_frame(frame, check_sum);
+            if (seg.has_value()) {
+                _segments_read.push(move(seg.value()));
+            }
+        });
+
+        // The incoming frames may have caused the NetworkInterface to send frames.
+        _queue_pending();
+        _ring->flush();
+    }
+
+    if (_segments_read.empty()) {
+        return {};
+    }
+    optional<TCPSegment> seg{move(_segments_read.front())};
+    _segments_read.pop();
+    return seg;
+}
+
+void TCPOverIPv4OverPacketRingAdapter::read_batch(vector<TCPSegment> &segments) {
+    for (; not _segments_read.empty(); _segments_read.pop()) {
+        segments.push_back(move(_segments_read.front()));
+    }
+    _ring->recv_frames([&](const string_view frame, const bool check_sum) {
+        auto seg = _recv_frame(frame, check_sum);
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+    });
+    _queue_pending();
+    _ring->flush();
+}
+
+//! \param[in] seg the TCPSegment to send
+//! \details A segment too large for the link MTU (say, sized for a jumbo MTU) is sent in fragments.
+void TCPOverIPv4OverPacketRingAdapter::_queue_segment(TCPSegment &seg) {
+    InternetDatagram dgram = wrap_tcp_in_ip(seg);
+    dgram.header().df = dgram.header().len <= _mtu;
+    _interface.send_datagram(move(dgram), _next_hop);
+    _queue_pending();
+}
+
+//! \param[in] seg the TCPSegment to send
+void TCPOverIPv4OverPacketRingAdapter::write(TCPSegment &seg) {
+    _queue_segment(seg);
+    _ring->flush();
+}
+
+void TCPOverIPv4OverPacketRingAdapter::write_batch(queue<TCPSegment> &segments) {
+    for (; not segments.empty(); segments.pop()) {
+        _queue_segment(segments.front());
+    }
+    _ring->flush();
+}
+
+//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
+void TCPOverIPv4OverPacketRingAdapter::tick(const size_t ms_since_last_tick) {
+    _interface.tick(ms_since_last_tick);
+    _queue_pending();
+    _ring->flush();
+}
+
+void TCPOverIPv4OverPacketRingAdapter::_queue_pending() {
+    for (; not _interface.frames_out().empty(); _interface.frames_out().pop()) {
+        _ring->send_frame(_interface.frames_out().front().serialize());
+    }
+}
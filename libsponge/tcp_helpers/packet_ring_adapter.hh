@@ -0,0 +1,86 @@
+#ifndef SPONGE_LIBSPONGE_PACKET_RING_ADAPTER_HH
+#define SPONGE_LIBSPONGE_PACKET_RING_ADAPTER_HH
+
+#include "network_interface.hh"
+#include "packet_ring.hh"
+#include "tcp_config.hh"
+#include "tcp_over_ip.hh"
+
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <vector>
+
+//! \brief A FD adapter for IPv4 datagrams in Ethernet frames, sent and received through the memory-mapped
+//! rings of a PacketRing on an existing interface (say, one end of a veth pair)
+//! \details Like TCPOverIPv4OverEthernetAdapter, but read_batch() takes every frame that has arrived
+//! without a system call per frame, and write_batch() sends all the frames for its segments with one.
+class TCPOverIPv4OverPacketRingAdapter : public TCPOverIPv4Adapter {
+  private:
+    std::unique_ptr<PacketRing> _ring;  //!< Raw Ethernet connection (not movable, so held by pointer)
+
+    NetworkInterface _interface;  //!< NIC abstraction
+
+    Address _next_hop;  //!< IP address of the next hop
+
+    size_t _mtu;  //!< Largest IPv4 datagram the link carries (must match the interface's MTU)
+
+    //! Segments taken from the receive ring by read() but not yet returned by it
+    std::queue<TCPSegment> _segments_read{};
+
+    //! Give a frame received to the NetworkInterface, and return the TCP segment it carried, if any
+    std::optional<TCPSegment> _recv_frame(std::string_view frame, const bool check_sum);
+
+    //! Wrap a segment in an IPv4 datagram, and copy the frames that causes into the transmit ring
+    void _queue_segment(TCPSegment &seg);
+
+    //! Copy any pending Ethernet frames into the transmit ring (without sending them)
+    void _queue_pending();
+
+  public:
+    //! Construct from a PacketRing
+    explicit TCPOverIPv4OverPacketRingAdapter(std::unique_ptr<PacketRing> &&ring,
+                                              const EthernetAddress &eth_address,
+                                              const Address &ip_address,
+                                              const Address &next_hop,
+                                              const size_t mtu = TCPConfig::ETHERNET_MTU);
+
+    //! \brief Attempts to read a TCP segment related to the current connection
+    //! \details Takes every frame waiting in the receive ring, returns the first segment, and keeps the
+    //! rest for later calls to read() (or read_batch()), which return them before taking any more frames.
+    std::optional<TCPSegment> read();
+
+    //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
+    void write(TCPSegment &seg);
+
+    //! Takes every frame waiting in the receive ring, and appends the TCP segments related to the
+    //! current connection to `segments`
+    void read_batch(std::vector<TCPSegment> &segments);
+
+    //! Writes every segment in `segments` (leaving it empty) into the transmit ring, and sends them together
+    void write_batch(std::queue<TCPSegment> &segments);
+
+    //! Called periodically when time elapses
+    void tick(const size_t ms_since_last_tick);
+
+    //! Milliseconds until tick() next has something to do (see NetworkInterface::time_until_next_event())
+    std::optional<size_t> time_until_next_event() const { return _interface.time_until_next_event(); }
+
+    //! A snapshot of the counters of the adapter's NetworkInterface
+    NetworkInterface::Stats interface_stats() const { return _interface.stats(); }
+
+    //! Largest IPv4 datagram the adapter will send
+    size_t mtu() const { return _mtu; }
+
+    //! The file descriptor to wait on before read_batch() and write_batch(): the packet socket
+    const FileDescriptor &watched_fd() const { return *_ring; }
+
+    //! Access the underlying packet socket
+    operator PacketRing &() { return *_ring; }
+
+    //! Access the underlying packet socket
+    operator const PacketRing &() const { return *_ring; }
+};
+
+#endif  // SPONGE_LIBSPONGE_PACKET_RING_ADAPTER_HH
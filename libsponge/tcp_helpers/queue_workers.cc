@@ -0,0 +1,162 @@
+#include "queue_workers.hh"
+
+#include "ethernet_header.hh"
+#include "eventloop.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(fds)));
+    return {FileDescriptor{fds[0]}, FileDescriptor{fds[1]}};
+}
+
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    return x ^ (x >> 33);
+}
+
+//! \details Fragments of a datagram carry no ports, so any fragment hashes just the addresses.
+std::optional<uint64_t> QueueWorkers::ipv4_flow(const string &frame, const size_t offset) {
+    constexpr uint8_t PROTO_TCP = 6;
+    constexpr uint8_t PROTO_UDP = 17;
+    if (frame.size() < offset + 20) {
+        return {};
+    }
+    const auto byte = [&](const size_t i) { return static_cast<uint8_t>(frame[offset + i]); };
+    const auto word = [&](const size_t i) { return uint16_t(byte(i) << 8 | byte(i + 1)); };
+    const auto address = [&](const size_t i) { return uint64_t{word(i)} << 16 | word(i + 2); };
+
+    const size_t header_length = (byte(0) & 0xf) * 4;
+    if ((byte(0) >> 4) != 4 or header_length < 20) {
+        return {};
+    }
+    const uint8_t proto = byte(9);
+    const bool fragment = (word(6) & 0x3fff) != 0;  // more fragments, or a fragment offset
+    uint64_t source = address(12) << 16;
+    uint64_t destination = address(16) << 16;
+    if ((proto == PROTO_TCP or proto == PROTO_UDP) and not fragment and frame.size() >= offset + header_length + 4) {
+        source |= word(header_length);
+        destination |= word(header_length + 2);
+    }
+
+    // order the endpoints, so that both directions of a flow hash the same
+    return mix(min(source, destination) * 31 + mix(max(source, destination) ^ proto));
+}
+
+std::optional<uint64_t> QueueWorkers::tap_flow(const string &frame) {
+    if (frame.size() < EthernetHeader::LENGTH or
+        (uint16_t(uint8_t(frame[12]) << 8 | uint8_t(frame[13])) != EthernetHeader::TYPE_IPv4)) {
+        return {};
+    }
+    return ipv4_flow(frame, EthernetHeader::LENGTH);
+}
+
+//! \param[in] queues are the device's queues, in shard order
+//! \param[in] handler is called (on the owning shard's thread) with each frame
+//! \param[in] classifier hashes the flow of a frame
+QueueWorkers::QueueWorkers(vector<FileDescriptor> &&queues, Handler handler, Classifier classifier)
+    : _handler(move(handler)), _classifier(move(classifier)) {
+    if (queues.empty()) {
+        throw runtime_error("QueueWorkers needs at least one queue");
+    }
+    for (auto &queue : queues) {
+        _workers.push_back(make_unique<Worker>(move(queue), make_pipe()));
+    }
+}
+
+QueueWorkers::~QueueWorkers() { stop(); }
+
+void QueueWorkers::start() {
+    if (_running.exchange(true)) {
+        return;
+    }
+    for (size_t i = 0; i < _workers.size(); i++) {
+        _workers[i]->thread = thread([this, i] { _run(i); });
+    }
+}
+
+void QueueWorkers::stop() {
+    if (not _running.exchange(false)) {
+        return;
+    }
+    for (auto &worker : _workers) {
+        worker->wake_write.write("x");
+    }
+    for (auto &worker : _workers) {
+        worker->thread.join();
+    }
+}
+
+uint64_t QueueWorkers::frames() const {
+    uint64_t total = 0;
+    for (const auto &worker : _workers) {
+        total += worker->counts.frames.load(memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t QueueWorkers::handoffs() const {
+    uint64_t total = 0;
+    for (const auto &worker : _workers) {
+        total += worker->counts.handoffs.load(memory_order_relaxed);
+    }
+    return total;
+}
+
+void QueueWorkers::_dispatch(const size_t index, string &&frame) {
+    WorkerCounts &counts = _workers[index]->counts;
+    counts.frames.fetch_add(1, memory_order_relaxed);
+    const size_t shard = shard_of(_classifier(frame));
+    if (shard == index) {
+        _handler(index, _workers[index]->queue, move(frame));
+        return;
+    }
+
+    counts.handoffs.fetch_add(1, memory_order_relaxed);
+    Worker &owner = *_workers[shard];
+    bool was_empty = false;
+    {
+        lock_guard<mutex> lock(owner.inbox_mutex);
+        was_empty = owner.inbox.empty();
+        owner.inbox.push_back(move(frame));
+    }
+    // if the inbox wasn't empty, the owner has been woken already and hasn't taken the frames yet
+    if (was_empty) {
+        owner.wake_write.write("x");
+    }
+}
+
+void QueueWorkers::_run(const size_t index) {
+    Worker &worker = *_workers[index];
+    EventLoop loop{EventLoop::Backend::Epoll};
+    loop.add_rule(worker.queue, Direction::In, [&] { _dispatch(index, worker.queue.read(MAX_FRAME)); });
+
+    vector<string> handed_over;
+    loop.add_rule(worker.wake_read, Direction::In, [&] {
+        worker.wake_read.read(4096);
+        {
+            lock_guard<mutex> lock(worker.inbox_mutex);
+            swap(handed_over, worker.inbox);
+        }
+        for (auto &frame : handed_over) {
+            _handler(index, worker.queue, move(frame));
+        }
+        handed_over.clear();
+    });
+
+    // Exit: the rules have been cancelled (the queue hung up) or a signal interrupted the wait; stop either way
+    while (_running) {
+        if (loop.wait_next_event(-1) == EventLoop::Result::Exit) {
+            break;
+        }
+    }
+}
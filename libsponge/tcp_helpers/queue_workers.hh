@@ -0,0 +1,127 @@
+#ifndef SPONGE_LIBSPONGE_QUEUE_WORKERS_HH
+#define SPONGE_LIBSPONGE_QUEUE_WORKERS_HH
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! \brief Services the queues of a multi-queue TUN or TAP device, each on its own thread with its own EventLoop
+//! \details Queue `i` is read by thread `i`, which owns shard `i`: every frame whose flow hashes to `i`
+//! (modulo the number of queues) is handled on that thread and no other, so whatever the Handler keeps
+//! per shard needs no locking. The kernel picks the queue for each
+//! frame by flow, too, but by its own hash, so a frame that arrives on another shard's queue is handed to
+//! the owner's thread. The Handler writes replies to its own shard's queue, and since the kernel then
+//! steers the rest of that flow to the same queue, handoffs become rare once a flow has sent something.
+//!
+//! The queues can be any FileDescriptors that read and write one frame at a time (e.g. a TunTapFD
+//! opened with `multi_queue`, or one end of a datagram socket pair).
+//!
+//! \note Nothing shards TCPConnections: the TCP adapters don't run on QueueWorkers, and a TCPSpongeSocket
+//! serves one connection from one queue on one thread. Only the tun_multiqueue_benchmark app, which echoes
+//! UDP, uses QueueWorkers.
+class QueueWorkers {
+  public:
+    //! \brief Called on shard `shard`'s thread with a frame of one of its flows
+    //! \details `queue` is the shard's own queue, for writing replies.
+    using Handler = std::function<void(const size_t shard, FileDescriptor &queue, std::string &&frame)>;
+
+    //! \brief Hashes a frame's flow; frames without one (e.g. ARP) go to shard 0
+    using Classifier = std::function<std::optional<uint64_t>(const std::string &frame)>;
+
+    //! \brief Hash of the 4-tuple of the TCP or UDP segment in an IPv4 datagram (the same in both directions)
+    //! \param[in] frame is the datagram, or a frame carrying it
+    //! \param[in] offset is where the IPv4 header starts in `frame`
+    static std::optional<uint64_t> ipv4_flow(const std::string &frame, const size_t offset = 0);
+
+    //! \brief A Classifier for a TUN device: ipv4_flow() of the frame
+    static std::optional<uint64_t> tun_flow(const std::string &frame) { return ipv4_flow(frame); }
+
+    //! \brief A Classifier for a TAP device: ipv4_flow() of the IPv4 datagram in an Ethernet frame
+    static std::optional<uint64_t> tap_flow(const std::string &frame);
+
+  private:
+    //! Counts of one worker, on a cache line of their own so that the threads don't contend for them
+    struct alignas(64) WorkerCounts {
+        std::atomic<uint64_t> frames{0};    //!< frames read from the worker's queue
+        std::atomic<uint64_t> handoffs{0};  //!< of those, frames of another shard handed to its owner
+    };
+
+    //! The state of one queue and the shard it owns
+    struct Worker {
+        FileDescriptor queue;  //!< read only by this worker's thread
+        FileDescriptor wake_read;
+        FileDescriptor wake_write;  //!< written to by other threads after adding to `inbox`
+
+        std::mutex inbox_mutex{};
+        std::vector<std::string> inbox{};  //!< frames of this shard that arrived on another queue
+
+        std::thread thread{};
+
+        WorkerCounts counts{};  //!< written only by this worker's thread
+
+        Worker(FileDescriptor &&fd, std::pair<FileDescriptor, FileDescriptor> &&wake_pipe)
+            : queue(std::move(fd)), wake_read(std::move(wake_pipe.first)), wake_write(std::move(wake_pipe.second)) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers{};
+
+    Handler _handler;
+
+    Classifier _classifier;
+
+    std::atomic<bool> _running{false};
+
+    //! The loop of worker `index`'s thread
+    void _run(const size_t index);
+
+    //! Handle a frame read from worker `index`'s queue, or hand it to the worker that owns it
+    void _dispatch(const size_t index, std::string &&frame);
+
+  public:
+    //! Largest frame read from a queue
+    static constexpr size_t MAX_FRAME = 65536;
+
+    //! \brief Take over `queues`, one shard each; nothing is read until start()
+    QueueWorkers(std::vector<FileDescriptor> &&queues, Handler handler, Classifier classifier = tun_flow);
+
+    //! Stops the threads if they are running
+    ~QueueWorkers();
+
+    //! \brief Start one thread per queue
+    void start();
+
+    //! \brief Stop and join the threads; frames not yet read stay in the queues
+    void stop();
+
+    //! \brief The shard that owns a flow hash (or shard 0 for no flow)
+    size_t shard_of(const std::optional<uint64_t> &flow) const { return flow.value_or(0) % _workers.size(); }
+
+    //! \brief Number of queues (and shards and threads)
+    size_t size() const { return _workers.size(); }
+
+    //! \brief Frames read from all the queues so far
+    uint64_t frames() const;
+
+    //! \brief Frames that arrived on a queue other than their shard's and were handed over
+    uint64_t handoffs() const;
+
+    //! \name
+    //! The threads refer to the QueueWorkers, so it can't be copied or moved
+    //!@{
+    QueueWorkers(const QueueWorkers &other) = delete;
+    QueueWorkers &operator=(const QueueWorkers &other) = delete;
+    QueueWorkers(QueueWorkers &&other) = delete;
+    QueueWorkers &operator=(QueueWorkers &&other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_QUEUE_WORKERS_HH
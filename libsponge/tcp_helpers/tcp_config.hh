@@ -7,6 +7,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <stdexcept>
+#include <string>
 
 //! Config for TCP sender and receiver
 class TCPConfig {
@@ -15,11 +17,47 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t MIN_TIMEOUT = 200;       //!< Lower bound on a timeout computed from RTT samples
+    static constexpr uint16_t MAX_TIMEOUT = 60000;     //!< Upper bound on a timeout computed from RTT samples
+    static constexpr size_t ETHERNET_MTU = 1500;       //!< MTU of a standard Ethernet link
+    static constexpr size_t JUMBO_MTU = 9000;          //!< MTU of an Ethernet link with jumbo frames
+    static constexpr size_t MIN_MTU = 68;              //!< Smallest MTU of an IPv4 link
+    static constexpr size_t MAX_MTU = 65535;           //!< Largest IPv4 datagram
+    //! Smallest MSS a peer may hold us to: room for the most TCP options there can be, and 8 bytes of payload
+    static constexpr uint16_t MIN_MSS = 48;
+
+    //! Largest TCP payload that fits in an IPv4 datagram of `mtu` bytes (no IP or TCP options)
+    static constexpr uint16_t mss_for_mtu(const size_t mtu) {
+        if (mtu < MIN_MTU or mtu > MAX_MTU) {
+            throw std::runtime_error("TCPConfig: an MTU of " + std::to_string(mtu) + " is outside [68, 65535]");
+        }
+        return mtu - 20 - 20;
+    }
+
+    //! \brief The MSS to send to a peer whose SYN carried `advertised`
+    //! \details A peer that doesn't advertise an MSS is assumed to take what we would send over UDP, and one that
+    //! advertises less than MIN_MSS (even 0) gets MIN_MSS, so that a segment always has room for its options.
+    static constexpr uint16_t peer_mss(const std::optional<uint16_t> advertised) {
+        if (not advertised.has_value()) {
+            return MAX_PAYLOAD_SIZE;
+        }
+        return advertised.value() < MIN_MSS ? MIN_MSS : advertised.value();
+    }
+
+    //! Largest TCP payload that fits in any IPv4 datagram, whatever the TCP options (the limit for tso_size)
+    static constexpr size_t MAX_TSO_SIZE = 65535 - 20 - 60;
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    uint16_t mss = MAX_PAYLOAD_SIZE;  //!< Largest payload to send or receive in a segment; advertised in the SYN
+    bool timestamps = false;  //!< Offer [timestamps](\ref rfc::rfc7323) (RTT measurement and PAWS) in the SYN
+    uint16_t ack_delay = 0;   //!< Longest time an in-order segment may wait for its ACK, in ms (0 ACKs every segment)
+    bool nagle = false;       //!< Hold short segments while data is unacknowledged ([RFC 896](\ref rfc::rfc896))
+    //! Largest payload to send in one segment, if the device cuts segments to the MSS itself (TCP
+    //! segmentation offload); 0 (or anything below the MSS) sends segments of the MSS
+    size_t tso_size = 0;
 };
 
 //! Config for classes derived from FdAdapter
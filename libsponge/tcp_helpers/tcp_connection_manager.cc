@@ -0,0 +1,261 @@
+#include "tcp_connection_manager.hh"
+
+#include "parser.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] cfg the configuration for every connection
+//! \param[in] local the address to bind the shared UDP socket to
+//! \param[in] io how to receive and send datagrams
+TCPConnectionManager::TCPConnectionManager(const TCPConfig &cfg, const Address &local, const IO io)
+    : _cfg(cfg), _socket(), _timers(timestamp_ms()), _next_ephemeral_port(EPHEMERAL_PORT_MIN) {
+    _socket.bind(local);
+    _socket.set_receive_buffer_size(SOCKET_BUFFER_SIZE);
+    _socket.set_send_buffer_size(SOCKET_BUFFER_SIZE);
+
+    if (io == IO::IoUring and DatagramRing::available()) {
+        _ring = make_unique<DatagramRing>(_socket, DatagramRing::Kind::Socket, RING_DEPTH);
+        _eventloop.add_rule(_ring->fd(), Direction::In, [&] { _receive_ring(); });
+        return;
+    }
+    _eventloop.add_rule(_socket, Direction::In, [&] { _receive(_socket.recv()); });
+}
+
+//! \details The segment is only checksummed and parsed once its ports and flags (see TCPHeader::peek())
+//! show that it belongs to a connection, or is a SYN to a listening port.
+void TCPConnectionManager::_receive(UDPSocket::received_datagram &&datagram) {
+    const auto fields = TCPHeader::peek(datagram.payload);
+    if (not fields.has_value()) {
+        _bad_segments++;
+        return;
+    }
+
+    const FourTuple key{
+        fields->dport, datagram.source_address.ipv4_numeric(), datagram.source_address.port(), fields->sport};
+    auto it = _connections.find(key);
+    // only a SYN to a listening port starts a connection; anything else for an unknown 4-tuple is dropped
+    const auto listener = it == _connections.end() ? _listeners.find(fields->dport) : _listeners.end();
+    if (it == _connections.end() and
+        (not fields->syn or fields->ack or fields->rst or listener == _listeners.end())) {
+        _strays++;
+        return;
+    }
+
+    TCPSegment seg;
+    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+        _bad_segments++;
+        return;
+    }
+
+    if (it == _connections.end()) {
+        Listener &listening = listener->second;
+        // half-open connections are counted too: each of them joins the accept queue once its handshake is done
+        if (listening.half_open + listening.accept_queue.size() >= listening.backlog) {
+            _syns_dropped++;
+            return;
+        }
+        listening.half_open++;
+        it = _connections
+                 .emplace(key,
+                          make_unique<Connection>(_cfg, datagram.source_address, timestamp_ms(), Stage::HalfOpen))
+                 .first;
+    }
+
+    Connection &conn = *it->second;
+    _tick(conn);
+    conn.tcp.segment_received(seg);
+    _service(key, conn);
+}
+
+void TCPConnectionManager::_receive_ring() {
+    while (auto datagram = _ring->recv_datagram()) {
+        _receive(move(datagram.value()));
+    }
+}
+
+void TCPConnectionManager::_tick(Connection &conn) {
+    const uint64_t now = timestamp_ms();
+    conn.tcp.tick(now - conn.last_tick_ms);
+    conn.last_tick_ms = now;
+}
+
+void TCPConnectionManager::_send(const FourTuple &key, Connection &conn) {
+    auto &segments = conn.tcp.segments_out();
+    while (not segments.empty()) {
+        TCPSegment &seg = segments.front();
+        seg.header().sport = key.local_port;
+        seg.header().dport = key.peer_port;
+        if (_ring) {
+            _ring->sendto(conn.peer, seg.serialize(0));
+        } else {
+            _socket.sendto(conn.peer, seg.serialize(0));
+        }
+        segments.pop();
+    }
+}
+
+void TCPConnectionManager::_arm(const FourTuple &key, Connection &conn, const bool immediately) {
+    if (conn.deadline.has_value()) {
+        _timers.cancel(conn.deadline.value());
+        conn.deadline.reset();
+    }
+
+    // a connection that has finished gets a timer anyway, so it is serviced (and forgotten) soon
+    const bool now = immediately or not conn.tcp.active();
+    const auto delay = now ? optional<size_t>{0} : conn.tcp.time_until_next_event();
+    if (not delay.has_value()) {
+        return;
+    }
+    conn.deadline = _timers.arm(conn.last_tick_ms + delay.value(), [this, key] {
+        const auto it = _connections.find(key);
+        if (it != _connections.end()) {
+            Connection &due = *it->second;
+            due.deadline.reset();
+            _tick(due);
+            _service(key, due);
+        }
+    });
+}
+
+void TCPConnectionManager::_service(const FourTuple &key, Connection &conn) {
+    _send(key, conn);
+
+    if (conn.stage == Stage::HalfOpen and conn.tcp.active() and conn.tcp.state() != TCPState::State::SYN_RCVD) {
+        // the handshake is done
+        Listener &listener = _listeners.at(key.local_port);
+        listener.half_open--;
+        listener.accept_queue.push_back(key);
+        conn.stage = Stage::Queued;
+        if (_accept_handler) {
+            _accept_handler(key.local_port);
+        }
+    }
+
+    if (conn.stage == Stage::Open and _handler) {
+        _handler(key, conn.tcp);
+        conn.tcp.inbound_stream_read();
+        _send(key, conn);
+    }
+
+    if (conn.tcp.active()) {
+        _arm(key, conn);
+        return;
+    }
+    _erase(key, conn);
+}
+
+void TCPConnectionManager::_erase(const FourTuple &key, Connection &conn) {
+    if (conn.deadline.has_value()) {
+        _timers.cancel(conn.deadline.value());
+    }
+    if (conn.stage == Stage::HalfOpen) {
+        _listeners.at(key.local_port).half_open--;
+    } else if (conn.stage == Stage::Queued) {
+        auto &queue = _listeners.at(key.local_port).accept_queue;
+        queue.erase(find(queue.begin(), queue.end(), key));
+    }
+    _connections.erase(key);
+}
+
+//! \param[in] port the TCP port to listen on
+//! \param[in] backlog how many connections may be half-open or waiting to be accepted, together
+void TCPConnectionManager::listen(const uint16_t port, const size_t backlog) {
+    if (backlog == 0) {
+        throw runtime_error("TCPConnectionManager::listen: backlog must be positive");
+    }
+    _listeners[port].backlog = backlog;
+}
+
+//! \param[in] port the TCP port that is listening
+optional<TCPConnectionManager::FourTuple> TCPConnectionManager::accept(const uint16_t port) {
+    const auto listener = _listeners.find(port);
+    if (listener == _listeners.end() or listener->second.accept_queue.empty()) {
+        return {};
+    }
+
+    const FourTuple key = listener->second.accept_queue.front();
+    listener->second.accept_queue.pop_front();
+    Connection &conn = *_connections.at(key);
+    conn.stage = Stage::Open;
+
+    // let the Handler see what arrived before the connection was accepted
+    _arm(key, conn, true);
+    return key;
+}
+
+//! \param[in] peer the UDP socket of the TCPConnectionManager to connect to
+//! \param[in] peer_port the TCP port it is listening on
+TCPConnectionManager::FourTuple TCPConnectionManager::connect(const Address &peer, const uint16_t peer_port) {
+    constexpr size_t ephemeral_ports = size_t{UINT16_MAX} - EPHEMERAL_PORT_MIN + 1;
+    for (size_t tries = 0; tries < ephemeral_ports; tries++) {
+        const uint16_t port = _next_ephemeral_port;
+        _next_ephemeral_port = port == UINT16_MAX ? EPHEMERAL_PORT_MIN : port + 1;
+
+        const FourTuple key{port, peer.ipv4_numeric(), peer.port(), peer_port};
+        if (_listeners.count(port) or _connections.count(key)) {
+            continue;
+        }
+
+        auto &conn =
+            *_connections.emplace(key, make_unique<Connection>(_cfg, peer, timestamp_ms(), Stage::Open)).first->second;
+        conn.tcp.connect();
+        _send(key, conn);
+        _arm(key, conn);
+        return key;
+    }
+
+    throw runtime_error("TCPConnectionManager::connect: no free port for another connection to " + peer.to_string());
+}
+
+//! \param[in] key the 4-tuple of the connection
+TCPConnection *TCPConnectionManager::connection(const FourTuple &key) {
+    const auto it = _connections.find(key);
+    return it == _connections.end() ? nullptr : &it->second->tcp;
+}
+
+//! \param[in] key the 4-tuple of the connection
+void TCPConnectionManager::flush(const FourTuple &key) {
+    const auto it = _connections.find(key);
+    if (it != _connections.end()) {
+        _send(key, *it->second);
+        _arm(key, *it->second);
+    }
+    if (_ring) {
+        _ring->flush();
+    }
+}
+
+//! \details Like TCPSpongeSocket's loop, this sleeps until the earliest deadline of any connection
+//! (or until a datagram arrives) rather than waking up on a fixed tick.
+void TCPConnectionManager::run(const function<bool()> &condition, const uint64_t max_wait_ms) {
+    while (condition()) {
+        const uint64_t now = timestamp_ms();
+        _timers.advance(now);
+
+        const auto deadline = _timers.next_deadline();
+        uint64_t wait_ms = max_wait_ms;
+        if (deadline.has_value()) {
+            wait_ms = deadline.value() > now ? min(deadline.value() - now, max_wait_ms) : 0;
+        }
+        if (_ring) {
+            // waiting for a send slot may have taken receives off the ring, which won't wake it up again
+            _receive_ring();
+            _ring->flush();
+        }
+        // the manager always has a rule, so Exit means the wait was interrupted by a signal
+        if (_eventloop.wait_next_event(static_cast<int>(wait_ms)) == EventLoop::Result::Exit) {
+            break;
+        }
+    }
+
+    // whatever the last events sent shouldn't wait for the next run()
+    if (_ring) {
+        _ring->flush();
+    }
+}
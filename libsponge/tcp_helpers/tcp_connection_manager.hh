@@ -0,0 +1,215 @@
+#ifndef SPONGE_LIBSPONGE_TCP_CONNECTION_MANAGER_HH
+#define SPONGE_LIBSPONGE_TCP_CONNECTION_MANAGER_HH
+
+#include "address.hh"
+#include "datagram_ring.hh"
+#include "eventloop.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "timer_wheel.hh"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+
+//! \brief Many TCPConnections sharing one UDP socket, one EventLoop and one thread
+//! \details Segments are carried in UDP payloads, as with TCPOverUDPSocketAdapter, but here the
+//! TCP ports in the header are real: every segment is demultiplexed by its 4-tuple to the
+//! TCPConnection it belongs to. The connections' retransmission, delayed-ACK and linger deadlines
+//! live on one TimerWheel, so the thread sleeps until the next of them (or the next datagram).
+//!
+//! Everything runs on the thread that calls run(); the application talks to its connections from
+//! the Handler, which is called whenever a connection may have something new to read or room to write.
+//! To use more cores, run one TCPConnectionManager (with its own UDP socket) per thread.
+//!
+//! A port passed to listen() keeps listening: each SYN to it starts a half-open connection. Once the
+//! three-way handshake completes, the connection waits in the port's accept queue until the
+//! application takes it with accept(). Only then is the Handler called for it. The port's backlog
+//! bounds the half-open and queued connections together; further SYNs are dropped (and the peer will
+//! retransmit them), so a full queue never has to turn away a connection that finished its handshake.
+//!
+//! With IO::IoUring, datagrams go through a DatagramRing instead of a system call each: every
+//! wakeup takes all the datagrams that have arrived, and everything sent is submitted at once before
+//! the next wait. The ring belongs to the first thread to call run() or flush(); only that thread can use
+//! the manager after that.
+class TCPConnectionManager {
+  public:
+    //! How datagrams are received and sent
+    enum class IO {
+        Syscalls,  //!< recvfrom and sendto, one datagram at a time
+        IoUring    //!< a DatagramRing (if io_uring is unavailable, Syscalls is used instead)
+    };
+
+    //! Identifies a connection. Over UDP the peer's "IP address" is its UDP endpoint.
+    struct FourTuple {
+        uint16_t local_port;  //!< TCP port at this end
+        uint32_t peer_ip;     //!< IPv4 address of the peer's UDP socket
+        uint16_t peer_udp;    //!< UDP port of the peer's UDP socket
+        uint16_t peer_port;   //!< TCP port at the peer
+
+        bool operator==(const FourTuple &other) const {
+            return local_port == other.local_port and peer_ip == other.peer_ip and peer_udp == other.peer_udp and
+                   peer_port == other.peer_port;
+        }
+    };
+
+    //! Called with a connection that may have new inbound data, more room for outbound data, or
+    //! have finished (then `active()` is false and this is the last call for it)
+    using Handler = std::function<void(const FourTuple &, TCPConnection &)>;
+
+    //! Called with a listening port when a connection to it is ready to be accept()ed
+    using AcceptHandler = std::function<void(const uint16_t)>;
+
+  private:
+    struct FourTupleHash {
+        size_t operator()(const FourTuple &t) const {
+            return std::hash<uint64_t>{}((uint64_t{t.peer_ip} << 32) ^ (uint64_t{t.peer_udp} << 16) ^
+                                         (uint64_t{t.local_port} << 48) ^ t.peer_port);
+        }
+    };
+
+    //! How far a connection has got towards the application
+    enum class Stage {
+        HalfOpen,  //!< opened by a peer's SYN, still in the three-way handshake
+        Queued,    //!< established, waiting in the accept queue
+        Open       //!< accepted, or opened by connect(): the Handler sees it
+    };
+
+    //! A TCPConnection and what the manager needs to drive it
+    struct Connection {
+        TCPConnection tcp;
+        Address peer;                                   //!< UDP endpoint of the peer
+        uint64_t last_tick_ms;                          //!< when `tcp` was last ticked
+        Stage stage;                                    //!< see Stage
+        std::optional<TimerWheel::TimerId> deadline{};  //!< the timer for `tcp`'s next tick, if it needs one
+
+        Connection(const TCPConfig &cfg, const Address &peer_address, const uint64_t now, const Stage initial)
+            : tcp(cfg), peer(peer_address), last_tick_ms(now), stage(initial) {}
+    };
+
+    //! A listening port
+    struct Listener {
+        size_t backlog{DEFAULT_BACKLOG};       //!< most connections half-open and in the accept queue together
+        size_t half_open{0};                   //!< connections still in the three-way handshake
+        std::deque<FourTuple> accept_queue{};  //!< established connections waiting for accept()
+    };
+
+    TCPConfig _cfg;
+
+    UDPSocket _socket;  //!< shared by every connection
+
+    std::unique_ptr<DatagramRing> _ring{};  //!< for IO::IoUring
+
+    EventLoop _eventloop{EventLoop::Backend::Epoll};
+
+    TimerWheel _timers;
+
+    //! connections by 4-tuple; the Connection is on the heap so its timer can refer to it
+    std::unordered_map<FourTuple, std::unique_ptr<Connection>, FourTupleHash> _connections{};
+
+    std::unordered_map<uint16_t, Listener> _listeners{};  //!< by TCP port
+
+    uint64_t _syns_dropped{0};  //!< SYNs turned away because a listener's backlog was full
+
+    uint64_t _strays{0};  //!< segments for no connection (and not SYNs to a listener), dropped unchecked
+
+    uint64_t _bad_segments{0};  //!< segments that were damaged, or too short for a TCP header
+
+    uint16_t _next_ephemeral_port;  //!< where to start looking for a free port for connect()
+
+    Handler _handler{};
+
+    AcceptHandler _accept_handler{};
+
+    //! Hand the segment in a received datagram to the connection it belongs to
+    void _receive(UDPSocket::received_datagram &&datagram);
+
+    //! Hand every datagram the DatagramRing has received to _receive()
+    void _receive_ring();
+
+    //! Tick a connection up to the current time
+    void _tick(Connection &conn);
+
+    //! Send the segments a connection has queued, addressed with its 4-tuple
+    void _send(const FourTuple &key, Connection &conn);
+
+    //! (Re-)arm the timer for a connection's next tick, or for right away
+    void _arm(const FourTuple &key, Connection &conn, const bool immediately = false);
+
+    //! After something happened to a connection: send its segments, move it along the accept
+    //! queue or call the handler, and then re-arm its timer, or forget it if it has finished
+    void _service(const FourTuple &key, Connection &conn);
+
+    //! Forget a connection, and its place in a listener's backlog
+    void _erase(const FourTuple &key, Connection &conn);
+
+  public:
+    //! Lowest TCP port connect() picks for the local end
+    static constexpr uint16_t EPHEMERAL_PORT_MIN = 49152;
+
+    //! Kernel buffer size asked for on the shared UDP socket; the default drops datagrams as soon as
+    //! a few hundred connections send at once
+    static constexpr int SOCKET_BUFFER_SIZE = 4 * 1024 * 1024;
+
+    //! Receives posted on the DatagramRing with IO::IoUring
+    static constexpr size_t RING_DEPTH = 256;
+
+    //! Bind the shared UDP socket to `local` and start with no connections
+    TCPConnectionManager(const TCPConfig &cfg, const Address &local, const IO io = IO::Syscalls);
+
+    //! Backlog for listen() if none is given
+    static constexpr size_t DEFAULT_BACKLOG = 128;
+
+    //! \brief Accept connections to TCP port `port`, with at most `backlog` half-open or unaccepted at once
+    void listen(const uint16_t port, const size_t backlog = DEFAULT_BACKLOG);
+
+    //! \brief Take the oldest established connection to `port` from its accept queue
+    //! \returns its 4-tuple, or nothing if none is waiting; from now on the Handler is called for it
+    std::optional<FourTuple> accept(const uint16_t port);
+
+    //! \brief Set the function called when a connection is ready to be accept()ed
+    void set_accept_handler(AcceptHandler handler) { _accept_handler = std::move(handler); }
+
+    //! \brief Open a connection to TCP port `peer_port` at the manager whose UDP socket is `peer`
+    //! \returns the 4-tuple of the new connection
+    FourTuple connect(const Address &peer, const uint16_t peer_port);
+
+    //! \brief Set the function called when a connection has something to do
+    void set_handler(Handler handler) { _handler = std::move(handler); }
+
+    //! \brief The connection with 4-tuple `key`, or `nullptr` if there is none
+    TCPConnection *connection(const FourTuple &key);
+
+    //! \brief Send whatever the application just wrote to (or closed on) the connection with 4-tuple `key`
+    //! \note Not needed from within the Handler, which is always followed by a flush.
+    void flush(const FourTuple &key);
+
+    //! \brief Handle datagrams and deadlines while `condition` is true
+    //! \param[in] condition checked before each wait
+    //! \param[in] max_wait_ms longest to sleep with nothing to do, so `condition` is checked that often
+    void run(const std::function<bool()> &condition, const uint64_t max_wait_ms = 100);
+
+    //! \brief Number of connections that are open or still finishing (including unaccepted ones)
+    size_t size() const { return _connections.size(); }
+
+    //! \brief Number of SYNs dropped because the backlog of the port they were for was full
+    uint64_t syns_dropped() const { return _syns_dropped; }
+
+    //! \brief Number of segments dropped because they were for no connection, without checksumming them
+    uint64_t strays() const { return _strays; }
+
+    //! \brief Number of segments dropped because they were damaged (or too short), once wanted
+    uint64_t bad_segments() const { return _bad_segments; }
+
+    //! \brief How datagrams are actually received and sent
+    IO io() const { return _ring ? IO::IoUring : IO::Syscalls; }
+
+    //! \brief The address the shared UDP socket is bound to
+    Address local_address() const { return _socket.local_address(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_CONNECTION_MANAGER_HH
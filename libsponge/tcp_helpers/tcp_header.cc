@@ -1,5 +1,8 @@
 #include "tcp_header.hh"
 
+#include "util.hh"
+
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
@@ -14,14 +17,18 @@ using namespace std;
 //! - the header's `doff` field is shorter than the minimum allowed
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
+//!
+//! Options are parsed from the `4 * doff - LENGTH` bytes that follow the fixed header.
+//! The MSS and timestamps options are recorded; unknown options are skipped, and a malformed
+//! option list is ignored from the point where it stops making sense.
 ParseResult TCPHeader::parse(NetParser &p) {
-    sport = p.u16();                 // source port
-    dport = p.u16();                 // destination port
-    seqno = WrappingInt32{p.u32()};  // sequence number
-    ackno = WrappingInt32{p.u32()};  // ack number
-    doff = p.u8() >> 4;              // data offset
+    uint32_t raw_seqno = 0, raw_ackno = 0;
+    uint8_t doff_b = 0, fl_b = 0;  // bytes including the data offset, and the flags
+    tie(sport, dport, raw_seqno, raw_ackno, doff_b, fl_b, win, cksum, uptr) = p.fields<Layout>();
+    seqno = WrappingInt32{raw_seqno};
+    ackno = WrappingInt32{raw_ackno};
+    doff = doff_b >> 4;
 
-    const uint8_t fl_b = p.u8();                  // byte including flags
     urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
@@ -29,16 +36,44 @@ ParseResult TCPHeader::parse(NetParser &p) {
     syn = static_cast<bool>(fl_b & 0b0000'0010);
     fin = static_cast<bool>(fl_b & 0b0000'0001);
 
-    win = p.u16();    // window size
-    cksum = p.u16();  // checksum
-    uptr = p.u16();   // urgent pointer
-
     if (doff < 5) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse any options, skipping the ones we don't understand
+    mss.reset();
+    timestamps.reset();
+    size_t options_left = doff * 4 - TCPHeader::LENGTH;
+    while (options_left > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        options_left--;
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+
+        const uint8_t opt_len = options_left > 0 ? p.u8() : 0;
+        options_left -= options_left > 0 ? 1 : 0;
+        if (opt_len < 2 or size_t(opt_len - 2) > options_left) {
+            break;  // malformed option list
+        }
+
+        if (kind == OPT_MSS and opt_len == MSS_LENGTH) {
+            mss = p.u16();
+        } else if (kind == OPT_TIMESTAMPS and opt_len == 10) {
+            const uint32_t tsval = p.u32();
+            const uint32_t tsecr = p.u32();
+            timestamps = TCPTimestamps{tsval, tsecr};
+        } else {
+            p.remove_prefix(opt_len - 2);
+        }
+        options_left -= opt_len - 2;
+    }
+
+    // skip whatever is left of the option space
+    p.remove_prefix(options_left);
 
     if (p.error()) {
         return p.get_error();
@@ -47,34 +82,94 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the TCPHeader to a string (does not recompute the checksum)
-string TCPHeader::serialize() const {
+//! \details Options and the checksum are left for parse(), once the segment turns out to be wanted.
+optional<TCPHeader::DemuxFields> TCPHeader::peek(const string_view segment) {
+    // the header up to the flags
+    using PeekLayout = HeaderLayout<uint16_t, uint16_t, uint32_t, uint32_t, uint8_t, uint8_t>;
+    if (segment.size() < PeekLayout::SIZE) {
+        return {};
+    }
+
+    const auto [sport, dport, seqno, ackno, doff, flags] = PeekLayout::load(segment.data());
+    return DemuxFields{sport,
+                       dport,
+                       static_cast<bool>(flags & 0b0001'0000),
+                       static_cast<bool>(flags & 0b0000'0100),
+                       static_cast<bool>(flags & 0b0000'0010),
+                       static_cast<bool>(flags & 0b0000'0001)};
+}
+
+//! \brief Write the fields of `header` to `out`, which has room for `4 * header.doff` bytes
+//! \returns the sum of what was written, as for InternetChecksum
+//! \note Options are only written if `doff` leaves room for them (see options_length())
+static uint32_t store_header(const TCPHeader &header, char *out, const uint16_t checksum) {
     // sanity check
-    if (doff < 5) {
+    if (header.doff < 5) {
         throw runtime_error("TCP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * doff);
-
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    const uint8_t fl_b = (header.urg ? 0b0010'0000 : 0) | (header.ack ? 0b0001'0000 : 0) |
+                         (header.psh ? 0b0000'1000 : 0) | (header.rst ? 0b0000'0100 : 0) |
+                         (header.syn ? 0b0000'0010 : 0) | (header.fin ? 0b0000'0001 : 0);
+    const TCPHeader::Layout::Values values{header.sport,
+                                           header.dport,
+                                           header.seqno.raw_value(),
+                                           header.ackno.raw_value(),
+                                           uint8_t(header.doff << 4),
+                                           fl_b,
+                                           header.win,
+                                           checksum,
+                                           header.uptr};
+    TCPHeader::Layout::store(out, values);
+    uint32_t sum = TCPHeader::Layout::sum(values);
+
+    char *options = out + TCPHeader::LENGTH;
+    char *const end = out + 4 * header.doff;
+    const bool write_options = 4 * header.doff >= TCPHeader::LENGTH + header.options_length();
+    if (header.mss.has_value() and write_options) {
+        using MSSLayout = HeaderLayout<uint8_t, uint8_t, uint16_t>;
+        const MSSLayout::Values mss{TCPHeader::OPT_MSS, TCPHeader::MSS_LENGTH, header.mss.value()};
+        MSSLayout::store(options, mss);
+        sum += MSSLayout::sum(mss);
+        options += MSSLayout::SIZE;
+    }
+    if (header.timestamps.has_value() and write_options) {
+        using TimestampsLayout = HeaderLayout<uint8_t, uint8_t, uint8_t, uint8_t, uint32_t, uint32_t>;
+        const TimestampsLayout::Values timestamps{TCPHeader::OPT_NOP,
+                                                  TCPHeader::OPT_NOP,
+                                                  TCPHeader::OPT_TIMESTAMPS,
+                                                  10,
+                                                  header.timestamps->tsval,
+                                                  header.timestamps->tsecr};
+        TimestampsLayout::store(options, timestamps);
+        sum += TimestampsLayout::sum(timestamps);
+        options += TimestampsLayout::SIZE;
+    }
+    fill(options, end, 0);  // expand header to advertised size
 
-    const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
-                         (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    return sum;
+}
 
-    NetUnparser::u16(ret, cksum);  // checksum
+//! Serialize the TCPHeader to a string (does not recompute the checksum)
+string TCPHeader::serialize() const {
+    string ret(4 * doff, 0);
+    store_header(*this, ret.data(), cksum);
+    return ret;
+}
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+void TCPHeader::serialize_into(char *out, const size_t size, const uint32_t initial_sum) const {
+    if (size < 4 * doff) {
+        throw runtime_error("TCPHeader::serialize_into: no room for the header");
+    }
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    const uint32_t sum = store_header(*this, out, 0);
+    store_field(out + Layout::OFFSETS[7], InternetChecksum{initial_sum + sum}.value());
+}
 
-    return ret;
+//! \details The sender of a segment sets `doff = (LENGTH + options_length()) / 4`
+//! after filling in the options it wants to send.
+size_t TCPHeader::options_length() const {
+    return (mss.has_value() ? MSS_LENGTH : 0) + (timestamps.has_value() ? TIMESTAMPS_LENGTH : 0);
 }
 
 //! \returns A string with the header's contents
@@ -90,13 +185,26 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (mss.has_value()) {
+        ss << "TCP mss: " << +mss.value() << '\n';
+    }
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: " << +timestamps->tsval << " " << +timestamps->tsecr << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (mss.has_value()) {
+        ss << ",mss=" << mss.value();
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->tsval << "/" << timestamps->tsecr;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -4,11 +4,34 @@
 #include "parser.hh"
 #include "../wrapping_integers.hh"
 
+#include <optional>
+#include <string_view>
+
+//! \brief [TCP timestamps option](\ref rfc::rfc7323) values
+struct TCPTimestamps {
+    uint32_t tsval = 0;  //!< timestamp value (sender's clock)
+    uint32_t tsecr = 0;  //!< timestamp echo reply (most recent TSval received from the peer)
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Only the MSS and [timestamps](\ref rfc::rfc7323) options are supported; other options are skipped
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
 
+    //! \name TCP option kinds
+    //!@{
+    static constexpr uint8_t OPT_EOL = 0;         //!< end of option list
+    static constexpr uint8_t OPT_NOP = 1;         //!< no-operation (padding)
+    static constexpr uint8_t OPT_MSS = 2;         //!< maximum segment size
+    static constexpr uint8_t OPT_TIMESTAMPS = 8;  //!< [timestamps](\ref rfc::rfc7323)
+    //!@}
+
+    //! Space taken by the MSS option
+    static constexpr size_t MSS_LENGTH = 4;
+
+    //! Space taken by the timestamps option, including the two leading NOPs that align it
+    static constexpr size_t TIMESTAMPS_LENGTH = 12;
+
     //! \struct TCPHeader
     //! ~~~{.txt}
     //!   0                   1                   2                   3
@@ -50,12 +73,44 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! The fixed header: ports, sequence and ack numbers, data offset, flags, window, checksum and urgent pointer
+    using Layout = HeaderLayout<uint16_t, uint16_t, uint32_t, uint32_t, uint8_t, uint8_t, uint16_t, uint16_t, uint16_t>;
+    static_assert(Layout::SIZE == LENGTH);
+
+    //! \name TCP options
+    //!@{
+    std::optional<uint16_t> mss{};              //!< maximum segment size option (SYN only), if present
+    std::optional<TCPTimestamps> timestamps{};  //!< timestamps option, if present
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
+    //! \brief What a demultiplexer needs of a header: its ports and flags
+    struct DemuxFields {
+        uint16_t sport;
+        uint16_t dport;
+        bool ack;
+        bool rst;
+        bool syn;
+        bool fin;
+    };
+
+    //! \brief Read the ports and flags of a serialized segment, without parsing (or checksumming) the rest
+    //! \returns nothing if the segment is too short to hold them
+    static std::optional<DemuxFields> peek(const std::string_view segment);
+
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! \brief Serialize the TCP fields into `out`, which must have room for `4 * doff` bytes, computing the
+    //! checksum from them as they are written (and writing it instead of `cksum`)
+    //! \param[in] initial_sum is the sum that the checksum starts from: the pseudo-header's and the payload's
+    void serialize_into(char *out, const size_t size, const uint32_t initial_sum) const;
+
+    //! Number of bytes needed to carry the options that are set (a multiple of four)
+    size_t options_length() const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -4,6 +4,7 @@
 #include "ipv4_header.hh"
 #include "parser.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <stdexcept>
 #include <unistd.h>
@@ -11,60 +12,71 @@
 
 using namespace std;
 
-//! \details This function attempts to parse a TCP segment from
-//! the IP datagram's payload.
+//! \details This function checks, in order of cost, that the IP datagram carries a TCP segment
+//! related to the current connection, and then parses the segment.
 //!
-//! If this succeeds, it then checks that the received segment is related to the
-//! current connection. When a TCP connection has been established, this means
-//! checking that the source and destination ports in the TCP header are correct.
+//! The ports and flags are peeked at first (see TCPHeader::peek()): when a TCP connection has been
+//! established, the source and destination ports must be correct, and while it is listening
+//! (i.e., TCPOverIPv4OverTunFdAdapter::_listen is `true`) the segment must be a SYN to the right port.
+//! Only a segment that passes is checksummed and parsed, so unrelated traffic costs no more than
+//! reading a few fields.
 //!
-//! If the TCP connection is listening (i.e., TCPOverIPv4OverTunFdAdapter::_listen is `true`)
-//! and the TCP segment read from the wire includes a SYN, this function clears the
-//! `_listen` flag and records the source and destination addresses and port numbers
-//! from the TCP header; it uses this information to filter future reads.
+//! If the connection is listening, the first valid SYN clears the `_listen` flag, and its source and
+//! destination addresses and port numbers are recorded to filter future reads.
+//!
+//! The MSS in the peer's SYN is remembered for vnet_header_for(). Datagrams turned away are counted
+//! in unwrap_drops().
+//! \param[in] ip_dgram is the datagram to unwrap
+//! \param[in] check_sum is `false` if the TCP checksum needn't (or can't) be checked (see TCPSegment::parse)
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram) {
-    // is the IPv4 datagram for us?
+optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram, const bool check_sum) {
+    // is the IPv4 datagram for us, and from our peer?
     // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual address contacted
-    if (not listening() and (ip_dgram.header().dst != config().source.ipv4_numeric())) {
+    if (not listening() and (ip_dgram.header().dst != config().source.ipv4_numeric() or
+                             ip_dgram.header().src != config().destination.ipv4_numeric())) {
+        _drops.wrong_address++;
         return {};
     }
 
-    // is the IPv4 datagram from our peer?
-    if (not listening() and (ip_dgram.header().src != config().destination.ipv4_numeric())) {
+    // does the IPv4 datagram claim that its payload is a TCP segment?
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        _drops.not_tcp++;
         return {};
     }
 
-    // does the IPv4 datagram claim that its payload is a TCP segment?
-    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+    // is the TCP segment for us, and from our peer (or a SYN, if we're listening)?
+    const Buffer segment = ip_dgram.payload();
+    const auto fields = TCPHeader::peek(segment);
+    if (not fields.has_value()) {
+        _drops.bad_header++;
+        return {};
+    }
+    if (fields->dport != config().source.port() or
+        (listening() ? not fields->syn or fields->rst : fields->sport != config().destination.port())) {
+        _drops.wrong_port++;
         return {};
     }
 
     // is the payload a valid TCP segment?
-    TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    if (check_sum and not TCPSegment::checksum_ok(segment, ip_dgram.header().pseudo_cksum())) {
+        _drops.bad_checksum++;
         return {};
     }
-
-    // is the TCP segment for us?
-    if (tcp_seg.header().dport != config().source.port()) {
+    TCPSegment tcp_seg;
+    if (ParseResult::NoError != tcp_seg.parse(segment, 0, false)) {
+        _drops.bad_header++;
         return {};
     }
 
-    // should we target this source addr/port (and use its destination addr as our source) in reply?
+    // target this source addr/port (and use its destination addr as our source) in reply
     if (listening()) {
-        if (tcp_seg.header().syn and not tcp_seg.header().rst) {
-            config_mutable().source = {inet_ntoa({htobe32(ip_dgram.header().dst)}), config().source.port()};
-            config_mutable().destination = {inet_ntoa({htobe32(ip_dgram.header().src)}), tcp_seg.header().sport};
-            set_listening(false);
-        } else {
-            return {};
-        }
+        config_mutable().source = {inet_ntoa({htobe32(ip_dgram.header().dst)}), config().source.port()};
+        config_mutable().destination = {inet_ntoa({htobe32(ip_dgram.header().src)}), tcp_seg.header().sport};
+        set_listening(false);
     }
 
-    // is the TCP segment from our peer?
-    if (tcp_seg.header().sport != config().destination.port()) {
-        return {};
+    if (tcp_seg.header().syn) {
+        _peer_mss = TCPConfig::peer_mss(tcp_seg.header().mss);
     }
 
     return tcp_seg;
@@ -72,7 +84,8 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
 
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
-InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+//! \param[in] partial_checksum leaves the TCP checksum for the device to finish (see TCPSegment::serialize_partial)
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg, const bool partial_checksum) {
     // set the port numbers in the TCP segment
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
@@ -84,7 +97,41 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
 
     // set payload, calculating TCP checksum using information from IP header
-    ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+    if (partial_checksum) {
+        ip_dgram.payload() = seg.serialize_partial(ip_dgram.header().pseudo_cksum());
+    } else {
+        ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+    }
 
     return ip_dgram;
 }
+
+//! \param[in] ip_dgram is the serialized datagram, from `wrap_tcp_in_ip(seg, true)`
+//! \param[in] link_header_length is the number of bytes in front of the datagram in its frame
+//! \param[in] mtu is the largest datagram the link carries
+//! \details The header asks the device to finish the TCP checksum. If the segment carries more payload
+//! than fits in a datagram of `mtu` bytes, or than the peer's MSS, the header also asks the device to cut
+//! it into segments that do (TCP segmentation offload), each with the same headers and options.
+VnetHeader TCPOverIPv4Adapter::vnet_header_for(const BufferList &ip_dgram,
+                                               const size_t link_header_length,
+                                               const size_t mtu) const {
+    // the IP and TCP headers are the first buffers of a serialized datagram
+    const string_view ip_header = ip_dgram.buffers().at(0).str();
+    const string_view tcp_header = ip_dgram.buffers().at(1).str();
+
+    VnetHeader vnet;
+    vnet.flags = VnetHeader::FLAG_NEEDS_CSUM;
+    vnet.csum_start = link_header_length + ip_header.size();
+    vnet.csum_offset = 16;  // the checksum field of a TCP header
+
+    const size_t payload_size = ip_dgram.size() - ip_header.size() - tcp_header.size();
+    const size_t options = tcp_header.size() - TCPHeader::LENGTH;
+    const size_t mss = min(size_t{TCPConfig::mss_for_mtu(mtu)}, size_t{_peer_mss});
+    const size_t max_payload = mss > options ? mss - options : 0;
+    if (max_payload > 0 and payload_size > max_payload) {
+        vnet.gso_type = VnetHeader::GSO_TCPV4;
+        vnet.gso_size = static_cast<uint16_t>(max_payload);  // below the MSS, which fits
+        vnet.hdr_len = vnet.csum_start + tcp_header.size();
+    }
+    return vnet;
+}
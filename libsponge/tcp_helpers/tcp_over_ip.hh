@@ -4,16 +4,40 @@
 #include "buffer.hh"
 #include "fd_adapter.hh"
 #include "ipv4_datagram.hh"
+#include "tcp_config.hh"
 #include "tcp_segment.hh"
+#include "vnet_header.hh"
 
+#include <cstdint>
 #include <optional>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
-    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
+    //! \brief Datagrams that unwrap_tcp_in_ip() turned away, by the stage that turned them away
+    struct UnwrapDrops {
+        uint64_t wrong_address{0};  //!< not between this connection's addresses
+        uint64_t not_tcp{0};        //!< carrying another protocol
+        uint64_t wrong_port{0};     //!< not between this connection's ports (or, while listening, not a SYN)
+        uint64_t bad_checksum{0};   //!< for this connection, but damaged
+        uint64_t bad_header{0};     //!< too short for a TCP header, or with one that doesn't parse
+    };
 
-    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+  private:
+    uint16_t _peer_mss{TCPConfig::MAX_PAYLOAD_SIZE};  //!< the MSS in the peer's SYN, as TCPConfig::peer_mss() clamps it
+
+    UnwrapDrops _drops{};
+
+  public:
+    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram, const bool check_sum = true);
+
+    //! \brief Datagrams that unwrap_tcp_in_ip() turned away
+    const UnwrapDrops &unwrap_drops() const { return _drops; }
+
+    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg, const bool partial_checksum = false);
+
+    //! \brief The VnetHeader to send before an IPv4 datagram from `wrap_tcp_in_ip(seg, true)`
+    VnetHeader vnet_header_for(const BufferList &ip_dgram, const size_t link_header_length, const size_t mtu) const;
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -3,16 +3,17 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <utility>
 #include <variant>
 
 using namespace std;
 
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
-    if (check.value()) {
+//! \param[in] check_sum is `false` if the checksum was checked already, or was left for us by a
+//!                      device that doesn't finish it (see VnetHeader)
+ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum, const bool check_sum) {
+    if (check_sum and not checksum_ok(buffer, datagram_layer_checksum)) {
         return ParseResult::BadChecksum;
     }
 
@@ -22,20 +23,40 @@ ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer
     return p.get_error();
 }
 
+//! \param[in] buffer string/Buffer holding the segment
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+bool TCPSegment::checksum_ok(const Buffer &buffer, const uint32_t datagram_layer_checksum) {
+    InternetChecksum check(datagram_layer_checksum);
+    check.add(buffer);
+    return check.value() == 0;
+}
+
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \details The checksum is taken over the entire segment: the payload's sum is added to the header's
+//! as the header is written, once.
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
-
-    // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
     check.add(_payload);
-    header_out.cksum = check.value();
+    string header_out(4 * _header.doff, 0);
+    _header.serialize_into(header_out.data(), header_out.size(), static_cast<uint16_t>(~check.value()));
+
+    BufferList ret;
+    ret.append(move(header_out));
+    ret.append(_payload);
+
+    return ret;
+}
+
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \details The checksum field holds the sum of the pseudo-header alone (not complemented). Finishing
+//! it means adding the rest of the segment in, so this never reads the payload.
+BufferList TCPSegment::serialize_partial(const uint32_t datagram_layer_checksum) const {
+    TCPHeader header_out = _header;
+    header_out.cksum = static_cast<uint16_t>(~InternetChecksum(datagram_layer_checksum).value());
 
     BufferList ret;
     ret.append(header_out.serialize());
@@ -14,11 +14,19 @@ class TCPSegment {
 
   public:
     //! \brief Parse the segment from a string
-    ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
+    ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0, const bool check_sum = true);
+
+    //! \brief Check the checksum of a serialized segment, without parsing it
+    //! \details A demultiplexer can TCPHeader::peek() at the ports first, and only check (and parse)
+    //! the segments it wants: `parse(buffer, 0, false)` after this.
+    static bool checksum_ok(const Buffer &buffer, const uint32_t datagram_layer_checksum);
 
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize the segment with a partial checksum, for a device to finish (checksum offload)
+    BufferList serialize_partial(const uint32_t datagram_layer_checksum) const;
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
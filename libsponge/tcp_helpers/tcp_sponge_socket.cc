@@ -5,8 +5,10 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
+#include <future>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -18,24 +20,69 @@
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+//! Longest the TCPConnection thread sleeps with nothing due, so it still notices _abort and _cork
+static constexpr uint64_t TCP_MAX_SLEEP_MS = 100;
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_tick_tcp() {
+    const auto now = timestamp_ms();
+    if (_tcp.value().active()) {
+        _tcp.value().tick(now - _last_tick_ms);
+        _datagram_adapter.tick(now - _last_tick_ms);
+    }
+    _last_tick_ms = now;
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_arm_next_deadline() {
+    if (_next_deadline.has_value()) {
+        _timers.cancel(_next_deadline.value());
+        _next_deadline.reset();
+    }
+    if (not _tcp.value().active()) {
+        return;
+    }
+
+    auto delay = _tcp.value().time_until_next_event();
+    const auto adapter_delay = _datagram_adapter.time_until_next_event();
+    if (adapter_delay.has_value() and (not delay.has_value() or adapter_delay.value() < delay.value())) {
+        delay = adapter_delay;
+    }
+    if (delay.has_value()) {
+        _next_deadline = _timers.arm(_last_tick_ms + delay.value(), [&] {
+            _next_deadline.reset();
+            _tick_tcp();
+        });
+    }
+}
 
 //! \param[in] condition is a function returning true if loop should continue
+//! \details Instead of waking up on a fixed tick, the loop sleeps until the next deadline of the
+//! TCPConnection or the adapter (or until an event arrives). The deadline's timer ticks them once it
+//! has come, and the rules tick them before handling an event; the loop itself doesn't tick them again.
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
-    auto base_time = timestamp_ms();
+    _last_tick_ms = timestamp_ms();
+    _timers.advance(_last_tick_ms);
+    _arm_next_deadline();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        const auto now = timestamp_ms();
+        const auto deadline = _timers.next_deadline();
+        uint64_t sleep_ms = TCP_MAX_SLEEP_MS;
+        if (deadline.has_value()) {
+            sleep_ms = deadline.value() > now ? min(deadline.value() - now, TCP_MAX_SLEEP_MS) : 0;
+        }
+
+        auto ret = _eventloop.wait_next_event(static_cast<int>(sleep_ms));
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
-        if (_tcp.value().active()) {
-            const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
-            _datagram_adapter.tick(next_time - base_time);
-            base_time = next_time;
-        }
+        _apply_cork();
+
+        // ticks the connection if its deadline has come (the rules tick it before handling their events)
+        _timers.advance(timestamp_ms());
+        _arm_next_deadline();
     }
 }
 
@@ -71,14 +118,20 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     //
     // 4) Outbound segment generated by TCP (needs to be
     //    given to underlying datagram socket)
+    //
+    // Rules 1 and 4 move as many segments per system call as the adapter allows. They wait on the
+    // adapter's watched_fd(), which is its ring's if it does its I/O through io_uring.
 
     // rule 1: read from filtered packet stream and dump into TCPConnection
-    _eventloop.add_rule(_datagram_adapter,
+    _eventloop.add_rule(_datagram_adapter.watched_fd(),
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                            _tick_tcp();
+                            // everything that has arrived, with one system call where the adapter can
+                            _segments_in.clear();
+                            _datagram_adapter.read_batch(_segments_in);
+                            for (auto &seg : _segments_in) {
+                                _tcp->segment_received(move(seg));
                             }
 
                             // debugging output:
@@ -96,6 +149,8 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
+            _tick_tcp();
+            _apply_cork();
             const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
@@ -132,6 +187,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             const std::string buffer = inbound.peek_output(amount_to_write);
             const auto bytes_written = _thread_data.write(move(buffer), false);
             inbound.pop_output(bytes_written);
+            _tcp->inbound_stream_read();
 
             if (inbound.eof() or inbound.error()) {
                 _thread_data.shutdown(SHUT_WR);
@@ -151,17 +207,24 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         });
 
     // rule 4: read outbound segments from TCPConnection and send as datagrams
-    _eventloop.add_rule(_datagram_adapter,
+    _eventloop.add_rule(_datagram_adapter.watched_fd(),
                         Direction::Out,
-                        [&] {
-                            while (not _tcp->segments_out().empty()) {
-                                _datagram_adapter.write(_tcp->segments_out().front());
-                                _tcp->segments_out().pop();
-                            }
-                        },
+                        [&] { _datagram_adapter.write_batch(_tcp->segments_out()); },
                         [&] { return not _tcp->segments_out().empty(); });
 }
 
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_apply_cork() {
+    const bool cork = _cork.load();
+    if (cork != _tcp->corked()) {
+        if (cork) {
+            _tcp->cork();
+        } else {
+            _tcp->uncork();
+        }
+    }
+}
+
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
 //! \param[in] type is the type of AF_UNIX sockets to create (e.g., SOCK_SEQPACKET)
 //! \returns a std::pair of connected sockets
@@ -222,10 +285,8 @@ void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterCon
                             expected_state.name());
     }
 
-    _tcp_loop([&] { return _tcp->state() == TCPState::State::SYN_SENT; });
+    _start_tcp_thread([&] { return _tcp->state() == TCPState::State::SYN_SENT; });
     cerr << "done.\n";
-
-    _tcp_thread = thread(&TCPSpongeSocket::_tcp_main, this);
 }
 
 //! \param[in] c_tcp is the TCPConfig for the TCPConnection
@@ -242,21 +303,46 @@ void TCPSpongeSocket<AdaptT>::listen_and_accept(const TCPConfig &c_tcp, const Fd
     _datagram_adapter.set_listening(true);
 
     cerr << "DEBUG: Listening for incoming connection... ";
-    _tcp_loop([&] {
+    _start_tcp_thread([&] {
         const auto s = _tcp->state();
         return (s == TCPState::State::LISTEN or s == TCPState::State::SYN_RCVD or s == TCPState::State::SYN_SENT);
     });
     cerr << "new connection from " << _datagram_adapter.config().destination.to_string() << ".\n";
+}
 
-    _tcp_thread = thread(&TCPSpongeSocket::_tcp_main, this);
+//! \param[in] handshaking is a function returning true until the connection has been set up (or has failed to)
+//! \details The TCPConnection thread handles the handshake too, so only one thread ever uses the adapter
+//! (as one doing its I/O through a DatagramRing must); the caller waits here until the handshake is over, and
+//! gets any exception it threw.
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_start_tcp_thread(const function<bool()> &handshaking) {
+    promise<void> handshake_over;
+    auto handshake = handshake_over.get_future();
+    _tcp_thread = thread(&TCPSpongeSocket::_tcp_main, this, handshaking, move(handshake_over));
+    try {
+        handshake.get();
+    } catch (...) {
+        _tcp_thread.join();
+        throw;
+    }
 }
 
+//! \param[in] handshaking is a function returning true until the connection has been set up
+//! \param[in] handshake_over is told when it has been, or given the exception that stopped it
 template <typename AdaptT>
-void TCPSpongeSocket<AdaptT>::_tcp_main() {
+void TCPSpongeSocket<AdaptT>::_tcp_main(const function<bool()> handshaking, promise<void> handshake_over) {
     try {
         if (not _tcp.has_value()) {
             throw runtime_error("no TCP");
         }
+        _tcp_loop(handshaking);
+    } catch (...) {
+        handshake_over.set_exception(current_exception());
+        return;
+    }
+    handshake_over.set_value();
+
+    try {
         _tcp_loop([] { return true; });
         shutdown(SHUT_RDWR);
         if (not _tcp.value().active()) {
@@ -279,6 +365,9 @@ template class TCPSpongeSocket<TCPOverIPv4OverTunFdAdapter>;
 //! Specialization of TCPSpongeSocket for TCPOverIPv4OverEthernetAdapter
 template class TCPSpongeSocket<TCPOverIPv4OverEthernetAdapter>;
 
+//! Specialization of TCPSpongeSocket for TCPOverIPv4OverPacketRingAdapter
+template class TCPSpongeSocket<TCPOverIPv4OverPacketRingAdapter>;
+
 //! Specialization of TCPSpongeSocket for LossyTCPOverUDPSocketAdapter
 template class TCPSpongeSocket<LossyTCPOverUDPSocketAdapter>;
 
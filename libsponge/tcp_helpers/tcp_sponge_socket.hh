@@ -6,12 +6,16 @@
 #include "fd_adapter.hh"
 #include "file_descriptor.hh"
 #include "network_interface.hh"
+#include "packet_ring_adapter.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
+#include "timer_wheel.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -32,14 +36,35 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! TCP state machine
     std::optional<TCPConnection> _tcp{};
 
+    //! Segments read from the adapter in one batch (kept to reuse its storage)
+    std::vector<TCPSegment> _segments_in{};
+
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
     //! Process events while specified condition is true
     void _tcp_loop(const std::function<bool()> &condition);
 
-    //! Main loop of TCPConnection thread
-    void _tcp_main();
+    //! Deadlines of the TCPConnection and the adapter; the event loop sleeps until the next one
+    TimerWheel _timers{};
+
+    //! The timer armed for the next thing the TCPConnection or the adapter has to do on its own
+    std::optional<TimerWheel::TimerId> _next_deadline{};
+
+    //! When the TCPConnection and the adapter were last ticked (from timestamp_ms())
+    uint64_t _last_tick_ms{0};
+
+    //! Tick the TCPConnection and the adapter up to the current time
+    void _tick_tcp();
+
+    //! (Re-)arm _next_deadline for whichever of the TCPConnection and the adapter needs a tick first
+    void _arm_next_deadline();
+
+    //! Main loop of TCPConnection thread, from the handshake on
+    void _tcp_main(const std::function<bool()> handshaking, std::promise<void> handshake_over);
+
+    //! Start the TCPConnection thread, and wait for it to finish the handshake
+    void _start_tcp_thread(const std::function<bool()> &handshaking);
 
     //! Handle to the TCPConnection thread; owner thread calls join() in the destructor
     std::thread _tcp_thread{};
@@ -49,6 +74,11 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     std::atomic_bool _abort{false};  //!< Flag used by the owner to force the TCPConnection thread to shut down
 
+    std::atomic_bool _cork{false};  //!< Flag used by the owner to cork/uncork the TCPConnection (see set_cork())
+
+    //! Called by the TCPConnection thread to bring the TCPConnection in line with _cork
+    void _apply_cork();
+
     bool _inbound_shutdown{false};  //!< Has TCPSpongeSocket shut down the incoming data to the owner?
 
     bool _outbound_shutdown{false};  //!< Has the owner shut down the outbound data to the TCP connection?
@@ -70,6 +100,11 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! \brief Cork or uncork the outbound data, like the `TCP_CORK` socket option
+    //! \details While corked, only full-sized segments are sent; uncorking sends the remainder.
+    //! The TCPConnection thread picks up the change the next time it wakes up (within TCP_MAX_SLEEP_MS).
+    void set_cork(const bool cork) { _cork.store(cork); }
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
@@ -97,6 +132,7 @@ class TCPSpongeSocket : public LocalStreamSocket {
 using TCPOverUDPSpongeSocket = TCPSpongeSocket<TCPOverUDPSocketAdapter>;
 using TCPOverIPv4SpongeSocket = TCPSpongeSocket<TCPOverIPv4OverTunFdAdapter>;
 using TCPOverIPv4OverEthernetSpongeSocket = TCPSpongeSocket<TCPOverIPv4OverEthernetAdapter>;
+using TCPOverIPv4OverPacketRingSpongeSocket = TCPSpongeSocket<TCPOverIPv4OverPacketRingAdapter>;
 
 using LossyTCPOverUDPSpongeSocket = TCPSpongeSocket<LossyTCPOverUDPSocketAdapter>;
 using LossyTCPOverIPv4SpongeSocket = TCPSpongeSocket<LossyTCPOverIPv4OverTunFdAdapter>;
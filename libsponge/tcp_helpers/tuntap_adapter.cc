@@ -1,25 +1,201 @@
 #include "tuntap_adapter.hh"
 
+#include "datagram_ring.hh"
+#include "vnet_header.hh"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
 using namespace std;
 
+//! The largest IPv4 datagram, which is as big as a segment to be cut up by the device may be
+static constexpr size_t MAX_DATAGRAM = 65535;
+
+//! \brief Size of a DatagramRing's buffers for a device
+//! \details Room for a frame the MTU allows or, with `vnet_hdr`, for one the kernel hasn't cut up, behind its
+//! header; the device refuses to read a packet into a buffer too small for it.
+static size_t ring_buffer_size(const bool vnet_hdr, const size_t mtu) {
+    return vnet_hdr ? VnetHeader::LENGTH + EthernetHeader::LENGTH + MAX_DATAGRAM : EthernetHeader::LENGTH + mtu;
+}
+
+//! Strip the VnetHeader from a packet read from a device opened with `vnet_hdr`
+//! \param[in,out] packet is the packet, and then what followed the header
+//! \returns `true` if the TCP checksum still has to be checked, or nothing if there was no valid header
+static optional<bool> strip_vnet_header(Buffer &packet) {
+    NetParser p{packet};
+    VnetHeader vnet;
+    if (vnet.parse(p) != ParseResult::NoError) {
+        return {};
+    }
+    packet = p.buffer();
+    return not(vnet.flags & (VnetHeader::FLAG_NEEDS_CSUM | VnetHeader::FLAG_DATA_VALID));
+}
+
+//! \param[in] tun Raw network device that will be owned by the adapter
+//! \param[in] mtu Largest IPv4 datagram the device sends without offload (its MTU)
+TCPOverIPv4OverTunFdAdapter::TCPOverIPv4OverTunFdAdapter(TunFD &&tun, const size_t mtu)
+    : _tun(move(tun)), _mtu(mtu) {
+    _tun.set_offload(_tun.vnet_hdr());
+}
+
+TCPOverIPv4OverTunFdAdapter::~TCPOverIPv4OverTunFdAdapter() = default;
+
+TCPOverIPv4OverTunFdAdapter::TCPOverIPv4OverTunFdAdapter(TCPOverIPv4OverTunFdAdapter &&other) = default;
+
+TCPOverIPv4OverTunFdAdapter &TCPOverIPv4OverTunFdAdapter::operator=(TCPOverIPv4OverTunFdAdapter &&other) = default;
+
+optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::read() {
+    if (_ring) {
+        auto packet = _ring->recv_packet();
+        _ring->flush();
+        return packet.has_value() ? _unwrap(move(packet.value())) : nullopt;
+    }
+    return _unwrap(_tun.read());
+}
+
+//! \param[in] packet is the packet as read from the device
+optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::_unwrap(Buffer packet) {
+    bool check_sum = true;
+    if (_tun.vnet_hdr()) {
+        const auto still_to_check = strip_vnet_header(packet);
+        if (not still_to_check.has_value()) {
+            return {};
+        }
+        check_sum = still_to_check.value();
+    }
+
+    InternetDatagram ip_dgram;
+    if (ip_dgram.parse(packet) != ParseResult::NoError) {
+        return {};
+    }
+    return unwrap_tcp_in_ip(ip_dgram, check_sum);
+}
+
+//! \param[out] segments has the segments appended
+void TCPOverIPv4OverTunFdAdapter::read_batch(vector<TCPSegment> &segments) {
+    if (not _ring) {
+        auto seg = read();
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+        return;
+    }
+
+    while (auto packet = _ring->recv_packet()) {
+        auto seg = _unwrap(move(packet.value()));
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+    }
+    _ring->flush();
+}
+
+//! \param[in] seg the TCPSegment to send
+void TCPOverIPv4OverTunFdAdapter::write(TCPSegment &seg) {
+    _queue_segment(seg);
+    if (_ring) {
+        _ring->flush();
+    }
+}
+
+//! \param[in,out] segments are the TCP segments to write
+void TCPOverIPv4OverTunFdAdapter::write_batch(queue<TCPSegment> &segments) {
+    for (; not segments.empty(); segments.pop()) {
+        _queue_segment(segments.front());
+    }
+    if (_ring) {
+        _ring->flush();
+    }
+}
+
+void TCPOverIPv4OverTunFdAdapter::_queue_segment(TCPSegment &seg) {
+    BufferList packet;
+    if (not _tun.vnet_hdr()) {
+        packet = wrap_tcp_in_ip(seg).serialize();
+    } else {
+        const BufferList ip_dgram = wrap_tcp_in_ip(seg, true).serialize();
+        if (ip_dgram.size() > MAX_DATAGRAM) {
+            throw runtime_error("TCP segment of " + to_string(ip_dgram.size()) + " bytes is too large for IPv4");
+        }
+        packet = vnet_header_for(ip_dgram, 0, _mtu).serialize();
+        packet.append(ip_dgram);
+    }
+
+    if (_ring) {
+        _ring->send(packet);
+    } else {
+        _tun.write(packet);
+    }
+}
+
+bool TCPOverIPv4OverTunFdAdapter::enable_io_uring() {
+    if (not DatagramRing::available()) {
+        return false;
+    }
+    if (not _ring) {
+        _ring = make_unique<DatagramRing>(
+            _tun, DatagramRing::Kind::Device, DatagramRing::DEFAULT_DEPTH, ring_buffer_size(_tun.vnet_hdr(), _mtu));
+    }
+    return true;
+}
+
+const FileDescriptor &TCPOverIPv4OverTunFdAdapter::watched_fd() const { return _ring ? _ring->fd() : _tun; }
+
 //! \param[in] tap Raw network device that will be owned by the adapter
 //! \param[in] eth_address Ethernet address (local address) of the adapter
 //! \param[in] ip_address IP address (local address) of the adapter
 //! \param[in] next_hop IP address of the next hop (typically a router or default gateway)
+//! \param[in] mtu Largest IPv4 datagram to send in one frame; use TCPConfig::mss_for_mtu() to size segments
+//!            to match, as larger ones are sent in fragments
 TCPOverIPv4OverEthernetAdapter::TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
                                                                const EthernetAddress &eth_address,
                                                                const Address &ip_address,
-                                                               const Address &next_hop)
-    : _tap(move(tap)), _interface(eth_address, ip_address), _next_hop(next_hop) {
+                                                               const Address &next_hop,
+                                                               const size_t mtu)
+    : _tap(move(tap))
+    , _interface(eth_address, ip_address, _tap.vnet_hdr() ? NetworkInterface::NO_FRAGMENTS : mtu)
+    , _next_hop(next_hop)
+    , _mtu(mtu) {
+    _tap.set_offload(_tap.vnet_hdr());
+
     // Linux seems to ignore the first frame sent on a TAP device, so send a dummy frame to prime the pump :-(
     EthernetFrame dummy_frame;
-    _tap.write(dummy_frame.serialize());
+    BufferList dummy{_tap.vnet_hdr() ? VnetHeader{}.serialize() : string{}};
+    dummy.append(dummy_frame.serialize());
+    _tap.write(dummy);
 }
 
+TCPOverIPv4OverEthernetAdapter::~TCPOverIPv4OverEthernetAdapter() = default;
+
+TCPOverIPv4OverEthernetAdapter::TCPOverIPv4OverEthernetAdapter(TCPOverIPv4OverEthernetAdapter &&other) = default;
+
+TCPOverIPv4OverEthernetAdapter &TCPOverIPv4OverEthernetAdapter::operator=(TCPOverIPv4OverEthernetAdapter &&other) =
+    default;
+
 optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
-    // Read Ethernet frame from the raw device
+    if (_ring) {
+        auto packet = _ring->recv_packet();
+        const auto seg = packet.has_value() ? _recv_frame(move(packet.value())) : nullopt;
+        _ring->flush();
+        return seg;
+    }
+    return _recv_frame(_tap.read());
+}
+
+//! \param[in] packet is the frame as read from the device
+optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::_recv_frame(Buffer packet) {
+    bool check_sum = true;
+    if (_tap.vnet_hdr()) {
+        const auto still_to_check = strip_vnet_header(packet);
+        if (not still_to_check.has_value()) {
+            return {};
+        }
+        check_sum = still_to_check.value();
+    }
+
     EthernetFrame frame;
-    if (frame.parse(_tap.read()) != ParseResult::NoError) {
+    if (frame.parse(packet) != ParseResult::NoError) {
         return {};
     }
 
@@ -27,15 +203,34 @@ optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     optional<InternetDatagram> ip_dgram = _interface.recv_frame(frame);
 
     // The incoming frame may have caused the NetworkInterface to send a frame.
-    send_pending();
+    _queue_pending();
 
     // Try to interpret IPv4 datagram as TCP
     if (ip_dgram) {
-        return unwrap_tcp_in_ip(ip_dgram.value());
+        return unwrap_tcp_in_ip(ip_dgram.value(), check_sum);
     }
     return {};
 }
 
+//! \param[out] segments has the segments appended
+void TCPOverIPv4OverEthernetAdapter::read_batch(vector<TCPSegment> &segments) {
+    if (not _ring) {
+        auto seg = read();
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+        return;
+    }
+
+    while (auto packet = _ring->recv_packet()) {
+        auto seg = _recv_frame(move(packet.value()));
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+    }
+    _ring->flush();
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
     _interface.tick(ms_since_last_tick);
@@ -44,16 +239,71 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
 
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    _send_datagram(seg);
+    send_pending();
+}
+
+//! \param[in,out] segments are the TCP segments to write
+void TCPOverIPv4OverEthernetAdapter::write_batch(queue<TCPSegment> &segments) {
+    for (; not segments.empty(); segments.pop()) {
+        _send_datagram(segments.front());
+    }
     send_pending();
 }
 
+//! \param[in] seg the TCPSegment to send
+//! \details Without offload, a segment too large for the link MTU (say, sized for a jumbo MTU) is sent in
+//! fragments.
+void TCPOverIPv4OverEthernetAdapter::_send_datagram(TCPSegment &seg) {
+    InternetDatagram dgram = wrap_tcp_in_ip(seg, _tap.vnet_hdr());
+    if (not _tap.vnet_hdr()) {
+        dgram.header().df = dgram.header().len <= _mtu;
+    }
+    _interface.send_datagram(move(dgram), _next_hop);
+}
+
 void TCPOverIPv4OverEthernetAdapter::send_pending() {
+    _queue_pending();
+    if (_ring) {
+        _ring->flush();
+    }
+}
+
+void TCPOverIPv4OverEthernetAdapter::_queue_pending() {
     while (not _interface.frames_out().empty()) {
-        _tap.write(_interface.frames_out().front().serialize());
+        const EthernetFrame &frame = _interface.frames_out().front();
+        BufferList packet;
+        if (not _tap.vnet_hdr()) {
+            packet = frame.serialize();
+        } else {
+            // every IPv4 datagram the adapter sends is a TCP segment from wrap_tcp_in_ip(seg, true)
+            const bool tcp = frame.header().type == EthernetHeader::TYPE_IPv4;
+            packet = tcp ? vnet_header_for(frame.payload(), EthernetHeader::LENGTH, _mtu).serialize()
+                         : VnetHeader{}.serialize();
+            packet.append(frame.serialize());
+        }
+
+        if (_ring) {
+            _ring->send(packet);
+        } else {
+            _tap.write(packet);
+        }
         _interface.frames_out().pop();
     }
 }
 
+bool TCPOverIPv4OverEthernetAdapter::enable_io_uring() {
+    if (not DatagramRing::available()) {
+        return false;
+    }
+    if (not _ring) {
+        _ring = make_unique<DatagramRing>(
+            _tap, DatagramRing::Kind::Device, DatagramRing::DEFAULT_DEPTH, ring_buffer_size(_tap.vnet_hdr(), _mtu));
+    }
+    return true;
+}
+
+const FileDescriptor &TCPOverIPv4OverEthernetAdapter::watched_fd() const { return _ring ? _ring->fd() : _tap; }
+
 //! Specialize LossyFdAdapter to TCPOverIPv4OverTunFdAdapter
 template class LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
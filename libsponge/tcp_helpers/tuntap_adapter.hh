@@ -3,32 +3,70 @@
 
 #include "ethernet_header.hh"
 #include "network_interface.hh"
+#include "tcp_config.hh"
 #include "tun.hh"
 
+#include <memory>
 #include <optional>
+#include <queue>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+class DatagramRing;
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TUN device
+//! \details If the TunFD was opened with `vnet_hdr`, the adapter leaves TCP checksums to the kernel and
+//! hands it segments of any size, which it cuts to fit the MTU (see TCPConfig::tso_size); it also takes
+//! large segments the kernel hasn't cut up.
 class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
   private:
     TunFD _tun;
 
+    size_t _mtu;  //!< Largest IPv4 datagram the link carries (must match the TUN device's MTU)
+
+    std::unique_ptr<DatagramRing> _ring{};  //!< if set, does all the I/O on `_tun` (see enable_io_uring())
+
+    //! Parse a packet read from the device, and return the TCP segment it carried, if any
+    std::optional<TCPSegment> _unwrap(Buffer packet);
+
+    //! Queue a TCP segment's packet on the ring, or write it to the device
+    void _queue_segment(TCPSegment &seg);
+
   public:
     //! Construct from a TunFD
-    explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
+    explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun, const size_t mtu = TCPConfig::ETHERNET_MTU);
+
+    ~TCPOverIPv4OverTunFdAdapter();
+
+    //! \name
+    //! Moved with its ring, if any
+    //!@{
+    TCPOverIPv4OverTunFdAdapter(TCPOverIPv4OverTunFdAdapter &&other);
+    TCPOverIPv4OverTunFdAdapter &operator=(TCPOverIPv4OverTunFdAdapter &&other);
+    //!@}
 
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
-    std::optional<TCPSegment> read() {
-        InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
-            return {};
-        }
-        return unwrap_tcp_in_ip(ip_dgram);
-    }
+    std::optional<TCPSegment> read();
 
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    void write(TCPSegment &seg);
+
+    //! Reads a datagram (or, with the ring, every datagram it has received), appending the TCP segments
+    //! related to the current connection to `segments`
+    void read_batch(std::vector<TCPSegment> &segments);
+
+    //! Writes every segment in `segments` (leaving it empty); the ring passes them all to the kernel at once
+    void write_batch(std::queue<TCPSegment> &segments);
+
+    //! \brief Read and write the device through a DatagramRing, if io_uring is available
+    //! \details Like TCPOverUDPSocketAdapter::enable_io_uring(), but the ring reads and writes with
+    //! buffers registered with the kernel.
+    //! \returns whether the ring is used (if not, nothing changes)
+    bool enable_io_uring();
+
+    //! The file descriptor to wait on before read_batch() and write_batch(): the device, or the ring's
+    const FileDescriptor &watched_fd() const;
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -41,6 +79,8 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
 using LossyTCPOverIPv4OverTunFdAdapter = LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TAP device
+//! \details Offloads TCP checksums and segmentation like TCPOverIPv4OverTunFdAdapter if the TapFD was
+//! opened with `vnet_hdr`.
 class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
   private:
     TapFD _tap;  //!< Raw Ethernet connection
@@ -49,6 +89,19 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
 
     Address _next_hop;  //!< IP address of the next hop
 
+    size_t _mtu;  //!< Largest IPv4 datagram the link carries (must match the TAP device's MTU)
+
+    std::unique_ptr<DatagramRing> _ring{};  //!< if set, does all the I/O on `_tap` (see enable_io_uring())
+
+    //! Give a frame read from the device to the NetworkInterface, and return the TCP segment it carried, if any
+    std::optional<TCPSegment> _recv_frame(Buffer packet);
+
+    //! Give a TCP segment, in an IPv4 datagram, to the NetworkInterface
+    void _send_datagram(TCPSegment &seg);
+
+    //! Queue any pending Ethernet frames on the ring, or write them to the device
+    void _queue_pending();
+
     void send_pending();  //!< Sends any pending Ethernet frames
 
   public:
@@ -56,16 +109,51 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     explicit TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
                                             const EthernetAddress &eth_address,
                                             const Address &ip_address,
-                                            const Address &next_hop);
+                                            const Address &next_hop,
+                                            const size_t mtu = TCPConfig::ETHERNET_MTU);
+
+    ~TCPOverIPv4OverEthernetAdapter();
+
+    //! \name
+    //! Moved with its ring, if any
+    //!@{
+    TCPOverIPv4OverEthernetAdapter(TCPOverIPv4OverEthernetAdapter &&other);
+    TCPOverIPv4OverEthernetAdapter &operator=(TCPOverIPv4OverEthernetAdapter &&other);
+    //!@}
+
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
+    //! Reads a frame (or, with the ring, every frame it has received), appending the TCP segments
+    //! related to the current connection to `segments`
+    void read_batch(std::vector<TCPSegment> &segments);
+
+    //! Writes every segment in `segments` (leaving it empty); the ring passes them all to the kernel at once
+    void write_batch(std::queue<TCPSegment> &segments);
+
+    //! \brief Read and write the device through a DatagramRing, if io_uring is available
+    //! \details As TCPOverIPv4OverTunFdAdapter::enable_io_uring().
+    //! \returns whether the ring is used (if not, nothing changes)
+    bool enable_io_uring();
+
+    //! The file descriptor to wait on before read_batch() and write_batch(): the device, or the ring's
+    const FileDescriptor &watched_fd() const;
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! Milliseconds until tick() next has something to do (see NetworkInterface::time_until_next_event())
+    std::optional<size_t> time_until_next_event() const { return _interface.time_until_next_event(); }
+
+    //! A snapshot of the counters of the adapter's NetworkInterface
+    NetworkInterface::Stats interface_stats() const { return _interface.stats(); }
+
+    //! Largest IPv4 datagram the adapter will send
+    size_t mtu() const { return _mtu; }
+
     //! Access the underlying raw Ethernet connection
     operator TapFD &() { return _tap; }
 
@@ -0,0 +1,43 @@
+#include "vnet_header.hh"
+
+using namespace std;
+
+//! the header is little-endian, where NetParser reads network byte order
+static uint16_t le16(NetParser &p) {
+    const uint16_t low = p.u8();
+    return low | uint16_t(p.u8() << 8);
+}
+
+static void le16(string &s, const uint16_t val) {
+    NetUnparser::u8(s, val & 0xff);
+    NetUnparser::u8(s, val >> 8);
+}
+
+ParseResult VnetHeader::parse(NetParser &p) {
+    if (p.buffer().size() < VnetHeader::LENGTH) {
+        return ParseResult::PacketTooShort;
+    }
+
+    flags = p.u8();
+    gso_type = p.u8();
+    hdr_len = le16(p);
+    gso_size = le16(p);
+    csum_start = le16(p);
+    csum_offset = le16(p);
+
+    return p.get_error();
+}
+
+string VnetHeader::serialize() const {
+    string ret;
+    ret.reserve(LENGTH);
+
+    NetUnparser::u8(ret, flags);
+    NetUnparser::u8(ret, gso_type);
+    le16(ret, hdr_len);
+    le16(ret, gso_size);
+    le16(ret, csum_start);
+    le16(ret, csum_offset);
+
+    return ret;
+}
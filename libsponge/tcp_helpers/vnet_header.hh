@@ -0,0 +1,39 @@
+#ifndef SPONGE_LIBSPONGE_VNET_HEADER_HH
+#define SPONGE_LIBSPONGE_VNET_HEADER_HH
+
+#include "../util/parser.hh"
+
+#include <cstdint>
+#include <string>
+
+//! \brief The virtio-net header that precedes each packet on a TUN/TAP device opened with `vnet_hdr`
+//! \details It carries the offloads that would otherwise need the packet itself: a checksum the other
+//! side still has to finish (\ref FLAG_NEEDS_CSUM), and a large TCP segment that is to be cut into
+//! segments of `gso_size` bytes of payload (\ref GSO_TCPV4). The fields are little-endian (see TunTapFD).
+struct VnetHeader {
+    static constexpr size_t LENGTH = 10;  //!< size of `struct virtio_net_hdr`
+
+    static constexpr uint8_t FLAG_NEEDS_CSUM = 1;  //!< the checksum at `csum_start + csum_offset` is partial
+    static constexpr uint8_t FLAG_DATA_VALID = 2;  //!< the checksums were checked already
+
+    static constexpr uint8_t GSO_NONE = 0;   //!< an ordinary packet
+    static constexpr uint8_t GSO_TCPV4 = 1;  //!< a TCP segment (in IPv4) to be cut into `gso_size`-byte segments
+
+    //! \name virtio-net header fields
+    //!@{
+    uint8_t flags = 0;
+    uint8_t gso_type = GSO_NONE;
+    uint16_t hdr_len = 0;      //!< bytes of headers (link, IP and TCP) that are repeated on every segment
+    uint16_t gso_size = 0;     //!< payload bytes in each segment
+    uint16_t csum_start = 0;   //!< where the checksummed data starts (the TCP header)
+    uint16_t csum_offset = 0;  //!< where the checksum field is, from `csum_start`
+    //!@}
+
+    //! Parse the virtio-net fields from the provided NetParser
+    ParseResult parse(NetParser &p);
+
+    //! Serialize the virtio-net fields to a string
+    std::string serialize() const;
+};
+
+#endif  // SPONGE_LIBSPONGE_VNET_HEADER_HH
@@ -5,8 +5,29 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+bool TCPReceiver::paws_rejects(const TCPSegment &seg) const {
+    const TCPHeader &header = seg.header();
+    if (!_timestamps || !header.timestamps.has_value() || !_ts_recent.has_value() || header.rst || header.syn) {
+        return false;
+    }
+    // TSval is compared in 32-bit modular arithmetic, like a sequence number
+    return static_cast<int32_t>(header.timestamps->tsval - _ts_recent.value()) < 0;
+}
+
 bool TCPReceiver::segment_received(const TCPSegment &seg) {
+    _stats.segments_received++;
+    const bool acceptable = segment_accepted(seg);
+    if (!acceptable) {
+        _stats.unacceptable++;
+    }
+    return acceptable;
+}
+
+bool TCPReceiver::segment_accepted(const TCPSegment &seg) {
     const TCPHeader header = seg.header();
+    if (paws_rejects(seg)) {
+        return false;
+    }
     if (!_syn_set) {
         if (header.syn) {
             _isn = header.seqno;
@@ -25,6 +46,10 @@ bool TCPReceiver::segment_received(const TCPSegment &seg) {
         return false;
     }
 
+    // only a segment that starts no later than the ackno we've been sending may update TS.Recent
+    const bool ts_recent_candidate = _timestamps && header.timestamps.has_value() &&
+                                     unwrap(header.seqno, _isn, _checkpoint) <= unwrap(_ackno, _isn, _checkpoint);
+
     auto seg_seqno_start = unwrap(header.seqno, _isn, _checkpoint);
     auto seg_seqno_end = seg_seqno_start + (seg.length_in_sequence_space() ? seg.length_in_sequence_space() - 1 : 0);
     auto seqno_start = unwrap(_ackno, _isn, _checkpoint);
@@ -44,6 +69,7 @@ bool TCPReceiver::segment_received(const TCPSegment &seg) {
         size_t max_len = min(seg.length_in_sequence_space() - header.syn - header.fin,
                              seqno_start + window_size() - seg_seqno_start);
         _reassembler.push_substring(seg.payload().copy().substr(0, max_len), seg_seqno_start - 1, header.fin);
+        _stats.bytes_received += max_len;
     }
     _checkpoint = _reassembler.stream_out().bytes_written();
     if (!_fin_set && header.fin) {
@@ -58,10 +84,11 @@ bool TCPReceiver::segment_received(const TCPSegment &seg) {
     } else if (seg.length_in_sequence_space()) {
         _ackno = wrap(_reassembler.stream_out().bytes_written() + 1, _isn);
     }
-    if (fall_into_window || header.fin || header.syn) {
-        return true;
+    const bool acceptable = fall_into_window || header.fin || header.syn;
+    if (acceptable && ts_recent_candidate) {
+        _ts_recent = header.timestamps->tsval;
     }
-    return false;
+    return acceptable;
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -27,6 +27,26 @@ class TCPReceiver {
     uint64_t _checkpoint = 0;
     WrappingInt32 _ackno;
 
+    //! most recent timestamp from the peer worth echoing (TS.Recent in [RFC 7323](\ref rfc::rfc7323))
+    std::optional<uint32_t> _ts_recent{};
+
+    //! were timestamps negotiated? If not, the option is ignored (no PAWS, no TS.Recent)
+    bool _timestamps{false};
+
+  public:
+    //! Counts of the segments the TCPReceiver has been given
+    struct Stats {
+        uint64_t segments_received{0};  //!< segments given to segment_received()
+        uint64_t bytes_received{0};     //!< bytes of payload that fell in the window (including duplicates)
+        uint64_t unacceptable{0};       //!< segments entirely outside the window, or otherwise refused
+    };
+
+  private:
+    Stats _stats{};
+
+    //! Handle an inbound segment for segment_received(), which counts it
+    bool segment_accepted(const TCPSegment &seg);
+
   public:
     //! \brief Construct a TCP receiver
     //!
@@ -55,11 +75,27 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The peer's timestamp to echo back in outgoing segments
+    //! \returns empty if the peer hasn't sent the timestamps option, or timestamps weren't negotiated
+    std::optional<uint32_t> ts_recent() const { return _ts_recent; }
+
+    //! \brief Use the timestamps option (for PAWS and TS.Recent) only if both SYNs carried it
+    //! \details Call this before giving the receiver the peer's SYN, so that TS.Recent starts from it.
+    void set_timestamps(const bool negotiated) { _timestamps = negotiated; }
     //!@}
 
+    //! \brief Would [PAWS](\ref rfc::rfc7323) reject this segment as an old duplicate?
+    //! \details True if timestamps were negotiated and the segment carries one older than TS.Recent. Such a
+    //! segment may come from an earlier trip around the 32-bit sequence space, so its seqno can't be trusted.
+    bool paws_rejects(const TCPSegment &seg) const;
+
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \brief Counts of the segments the TCPReceiver has been given
+    const Stats &stats() const { return _stats; }
+
     //! \brief handle an inbound segment
     //! \returns `true` if any part of the segment was inside the window
     bool segment_received(const TCPSegment &seg);
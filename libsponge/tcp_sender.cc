@@ -17,8 +17,7 @@ TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const s
     , _initial_retransmission_timeout{retx_timeout}
     , _stream(capacity)
     , _timer()
-    , _retransmission_timeout(retx_timeout)
-    , _unacked_segments() {}
+    , _retransmission_timeout(retx_timeout) {}
 
 uint64_t TCPSender::bytes_in_flight() const { return max(_next_seqno - _abs_ackno, 0ul); }
 
@@ -27,25 +26,21 @@ void TCPSender::fill_window() {
         TCPSegment tcp_segment;
         tcp_segment.header().seqno = next_seqno();
         tcp_segment.header().syn = true;
-        _segments_out.push(tcp_segment);
-        _next_seqno++;
-        _unacked_segments.push(tcp_segment);
         _is_syn_sent = true;
-        if (!_timer.is_turn_on()) {
-            _timer.turn_on(_retransmission_timeout);
-            _timer.set_last_expire_time(_current_time);
-        }
+        send_segment(move(tcp_segment));
     }
 
     while (_stream.buffer_size()                                    
            && (bytes_in_flight() < _window_size || !_window_size))  
     {
         size_t len_to_read =
-            min(TCPConfig::MAX_PAYLOAD_SIZE,
+            min(_max_payload_size,
                 min(_stream.buffer_size(),
                     max(static_cast<size_t>(1), static_cast<size_t>(_window_size)) - bytes_in_flight()));
         if (!len_to_read)
             break;
+        if (hold_short_segment(len_to_read))
+            break;
         TCPSegment tcp_segment;
         tcp_segment.payload() = Buffer(_stream.read(len_to_read));
         auto &header = tcp_segment.header();
@@ -55,15 +50,7 @@ void TCPSender::fill_window() {
             _is_fin_sent = true;
         }
         header.seqno = next_seqno();
-        _next_seqno += tcp_segment.length_in_sequence_space();
-        _segments_out.push(tcp_segment);
-
-        _unacked_segments.push(tcp_segment);
-
-        if (!_timer.is_turn_on()) {
-            _timer.turn_on(_retransmission_timeout);
-            _timer.set_last_expire_time(_current_time);
-        }
+        send_segment(move(tcp_segment));
         if (!_window_size) {  
             break;
         }
@@ -72,14 +59,21 @@ void TCPSender::fill_window() {
         TCPSegment tcp_segment;
         tcp_segment.header().seqno = next_seqno();
         tcp_segment.header().fin = true;
-        _segments_out.push(tcp_segment);
-        _next_seqno++;
-        _unacked_segments.push(tcp_segment);
         _is_fin_sent = true;
-        if (!_timer.is_turn_on()) {
-            _timer.turn_on(_retransmission_timeout);
-            _timer.set_last_expire_time(_current_time);
-        }
+        send_segment(move(tcp_segment));
+    }
+}
+
+//! \param[in] seg a segment whose seqno is next_seqno()
+void TCPSender::send_segment(TCPSegment &&seg) {
+    _unacked_segments.push(_next_seqno, seg);
+    _next_seqno += seg.length_in_sequence_space();
+    _stats.segments_sent++;
+    _stats.bytes_sent += seg.payload().size();
+    _segments_out.push(move(seg));
+    if (!_timer.is_turn_on()) {
+        _timer.turn_on(_retransmission_timeout);
+        _timer.set_last_expire_time(_current_time);
     }
 }
 
@@ -89,11 +83,16 @@ void TCPSender::fill_window() {
 bool TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
     auto abs_ackno = unwrap(ackno, _isn, _abs_ackno);
     // invalid ackno
-    if (abs_ackno > _next_seqno)
+    if (abs_ackno > _next_seqno) {
+        _stats.invalid_acks++;
         return false;
+    }
     // has been acked
     if (abs_ackno < _abs_ackno)
         return true;
+    if (abs_ackno == _abs_ackno && window_size == _window_size && bytes_in_flight()) {
+        _stats.dup_acks++;
+    }
     _consecutive_retrans = 0;
     _retransmission_timeout = _initial_retransmission_timeout;
     _timer.set_last_expire_time(_current_time);
@@ -101,17 +100,9 @@ bool TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     _abs_ackno = abs_ackno;
     _window_size = window_size;
 
-    auto first_unacked_seno = !_unacked_segments.empty() ? unwrap(_unacked_segments.front().header().seqno, _isn, _abs_ackno) : 0;
-    while(!_unacked_segments.empty() && first_unacked_seno < abs_ackno)
-    {
-        _unacked_segments.pop();
-        if (!_unacked_segments.empty())
-            first_unacked_seno = unwrap(_unacked_segments.front().header().seqno, _isn, _abs_ackno);
-        else
-            break;
-    }
+    _unacked_segments.ack(abs_ackno);
     fill_window();
-    if (!_unacked_segments.size())
+    if (_unacked_segments.empty())
         _timer.turn_off();
     return true;
 }
@@ -119,8 +110,11 @@ bool TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
     _current_time += ms_since_last_tick;
-    if (_timer.is_turn_on() && _timer.is_expire(_current_time) && _unacked_segments.size()) {
-        _segments_out.push(_unacked_segments.front());
+    if (_timer.is_turn_on() && _timer.is_expire(_current_time) && !_unacked_segments.empty()) {
+        _segments_out.push(RetransmissionQueue::segment(_unacked_segments.front(), _isn));
+        _stats.segments_sent++;
+        _stats.retransmissions++;
+        _stats.bytes_retransmitted += _segments_out.back().payload().size();
         if (_window_size) {
             _consecutive_retrans++;
             _retransmission_timeout *= 2;
@@ -130,6 +124,49 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
     }
 }
 
+optional<size_t> TCPSender::time_until_retransmission() const {
+    if (!_timer.is_turn_on() || _unacked_segments.empty()) {
+        return {};
+    }
+    return _timer.time_remaining(_current_time);
+}
+
+//! \param[in] rtt_ms the measured round-trip time, in milliseconds
+//! \details Updates the smoothed RTT and RTT variance as in [RFC 6298](\ref rfc::rfc6298) and
+//! derives the retransmission timeout from them, clamped to
+//! [TCPConfig::MIN_TIMEOUT, TCPConfig::MAX_TIMEOUT]. A timer that is backed off
+//! after a timeout keeps its backed-off value until the next ACK.
+void TCPSender::rtt_sample(const size_t rtt_ms) {
+    if (!_has_rtt_sample) {
+        _srtt = rtt_ms;
+        _rttvar = rtt_ms / 2;
+        _has_rtt_sample = true;
+    } else {
+        const size_t delta = _srtt > rtt_ms ? _srtt - rtt_ms : rtt_ms - _srtt;
+        _rttvar = (3 * _rttvar + delta) / 4;
+        _srtt = (7 * _srtt + rtt_ms) / 8;
+    }
+
+    const size_t rto = _srtt + max(static_cast<size_t>(1), 4 * _rttvar);
+    _initial_retransmission_timeout =
+        min(static_cast<size_t>(TCPConfig::MAX_TIMEOUT), max(static_cast<size_t>(TCPConfig::MIN_TIMEOUT), rto));
+    if (!_consecutive_retrans) {
+        _retransmission_timeout = _initial_retransmission_timeout;
+        _timer.set_timeout(_retransmission_timeout);
+    }
+}
+
+//! \param[in] len the payload size of the segment fill_window() is about to send
+//! \returns `true` if the segment is short only because the application hasn't written
+//! more yet, and corking or the Nagle algorithm says to wait for more
+//! \note The last segment of a stream that has ended, and zero-window probes, always go out.
+bool TCPSender::hold_short_segment(const size_t len) const {
+    if (len >= _max_payload_size || len < _stream.buffer_size() || _stream.input_ended() || !_window_size) {
+        return false;
+    }
+    return _corked || (_nagle && bytes_in_flight());
+}
+
 unsigned int TCPSender::consecutive_retransmissions() const { return _consecutive_retrans; }
 
 void TCPSender::send_empty_segment() {
@@ -137,4 +174,5 @@ void TCPSender::send_empty_segment() {
     auto &header = tcp_segment.header();
     header.seqno = next_seqno();
     _segments_out.push(tcp_segment);
+    _stats.segments_sent++;
 }
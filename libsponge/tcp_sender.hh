@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "retransmission_queue.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "timer.hh"
@@ -9,6 +10,7 @@
 
 #include <functional>
 #include <map>
+#include <optional>
 #include <queue>
 
 //! \brief The "sender" part of a TCP implementation.
@@ -25,7 +27,8 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    //! retransmission timer for the connection
+    //! retransmission timeout to fall back to after an ACK: the configured initial value,
+    //! refined by RTT samples once any are taken (see rtt_sample())
     unsigned int _initial_retransmission_timeout;
 
     //! outgoing stream of bytes that have not yet been sent
@@ -43,7 +46,45 @@ class TCPSender {
     unsigned int _retransmission_timeout;
     bool _is_syn_sent = false;
     bool _is_fin_sent = false;
-    std::queue<TCPSegment> _unacked_segments;
+
+    //! segments sent but not yet acknowledged
+    RetransmissionQueue _unacked_segments{};
+
+    //! Queue a new segment for sending and remember it for retransmission
+    void send_segment(TCPSegment &&seg);
+
+    //! largest payload to put in one segment
+    size_t _max_payload_size{TCPConfig::MAX_PAYLOAD_SIZE};
+
+    //! \name Policies for holding back short segments (see fill_window())
+    //!@{
+    bool _nagle = false;   //!< only one short segment may be in flight
+    bool _corked = false;  //!< no short segments at all until uncorked
+    //!@}
+
+    //! Should a segment with `len` bytes of payload wait for more data?
+    bool hold_short_segment(const size_t len) const;
+
+    //! \name RTT estimator state ([RFC 6298](\ref rfc::rfc6298)), in milliseconds
+    //!@{
+    bool _has_rtt_sample = false;
+    size_t _srtt{0};
+    size_t _rttvar{0};
+    //!@}
+
+  public:
+    //! Counts of what the TCPSender has sent and been told
+    struct Stats {
+        uint64_t segments_sent{0};        //!< segments queued, including retransmissions and empty ones
+        uint64_t bytes_sent{0};           //!< bytes of payload sent the first time
+        uint64_t retransmissions{0};      //!< segments sent again when the retransmission timer went off
+        uint64_t bytes_retransmitted{0};  //!< bytes of payload in them
+        uint64_t dup_acks{0};             //!< ACKs with data in flight that moved neither the ackno nor the window
+        uint64_t invalid_acks{0};         //!< ACKs of sequence numbers not sent yet
+    };
+
+  private:
+    Stats _stats{};
 
   public:
     //! Initialize a TCPSender
@@ -73,6 +114,21 @@ class TCPSender {
     void tick(const size_t ms_since_last_tick);
     //!@}
 
+    //! \brief A round-trip time was measured (e.g. from an echoed timestamp) for an ACK of new data
+    void rtt_sample(const size_t rtt_ms);
+
+    //! \brief Limit the payload of each outgoing segment (e.g. to leave room for TCP options)
+    void set_max_payload_size(const size_t max_payload_size) { _max_payload_size = max_payload_size; }
+
+    //! \brief Turn the Nagle algorithm on or off
+    void set_nagle(const bool nagle) { _nagle = nagle; }
+
+    //! \brief Hold back (or stop holding back) short segments; call fill_window() after uncorking
+    void set_corked(const bool corked) { _corked = corked; }
+
+    //! \brief Are short segments being held back until uncorked?
+    bool corked() const { return _corked; }
+
     //! \name Accessors
     //!@{
 
@@ -84,6 +140,18 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief The timeout the retransmission timer falls back to after an ACK
+    unsigned int retransmission_timeout() const { return _initial_retransmission_timeout; }
+
+    //! \brief Milliseconds until the retransmission timer goes off, or nothing if it isn't running
+    std::optional<size_t> time_until_retransmission() const;
+
+    //! \brief Largest payload the TCPSender will put in one segment
+    size_t max_payload_size() const { return _max_payload_size; }
+
+    //! \brief Counts of what the TCPSender has sent and been told
+    const Stats &stats() const { return _stats; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
@@ -12,6 +12,10 @@ void Timer::turn_off() { _is_turn_on = false; }
 
 bool Timer::is_expire(unsigned int current_time) const { return (current_time - _last_expire_time) >= _timeout; }
 
+unsigned int Timer::time_remaining(unsigned int current_time) const {
+    return is_expire(current_time) ? 0 : _timeout - (current_time - _last_expire_time);
+}
+
 void Timer::set_timeout(unsigned int timeout) { _timeout = timeout; }
 
 void Timer::set_last_expire_time(unsigned int last_expire_time) { _last_expire_time = last_expire_time; }
\ No newline at end of file
@@ -12,6 +12,7 @@ class Timer {
     bool is_turn_on() const;
     void turn_off();
     bool is_expire(unsigned int delta) const;
+    unsigned int time_remaining(unsigned int current_time) const;
     void set_timeout(unsigned int timeout);
     void set_last_expire_time(unsigned int last_expire_time);
 };
@@ -1,5 +1,7 @@
 #include "buffer.hh"
 
+#include <iterator>
+
 using namespace std;
 
 void Buffer::remove_prefix(const size_t n) {
@@ -18,6 +20,16 @@ void BufferList::append(const BufferList &other) {
     }
 }
 
+void BufferList::append(BufferList &&other) {
+    if (_buffers.empty()) {
+        _buffers = move(other._buffers);
+    } else {
+        _buffers.insert(
+            _buffers.end(), make_move_iterator(other._buffers.begin()), make_move_iterator(other._buffers.end()));
+    }
+    other._buffers.clear();
+}
+
 BufferList::operator Buffer() const {
     switch (_buffers.size()) {
         case 0:
@@ -49,19 +61,21 @@ size_t BufferList::size() const {
 }
 
 void BufferList::remove_prefix(size_t n) {
+    auto first_kept = _buffers.begin();
     while (n > 0) {
-        if (_buffers.empty()) {
+        if (first_kept == _buffers.end()) {
             throw std::out_of_range("BufferList::remove_prefix");
         }
 
-        if (n < _buffers.front().str().size()) {
-            _buffers.front().remove_prefix(n);
+        if (n < first_kept->str().size()) {
+            first_kept->remove_prefix(n);
             n = 0;
         } else {
-            n -= _buffers.front().str().size();
-            _buffers.pop_front();
+            n -= first_kept->str().size();
+            ++first_kept;
         }
     }
+    _buffers.erase(_buffers.begin(), first_kept);
 }
 
 BufferViewList::BufferViewList(const BufferList &buffers) {
@@ -54,9 +54,11 @@ class Buffer {
 //! + a payload. This allows us to prepend headers (e.g., to
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
+//! A packet has a handful of Buffers, so they are kept in a vector, which (unlike a deque)
+//! allocates nothing while empty and nothing to be moved.
 class BufferList {
   private:
-    std::deque<Buffer> _buffers{};
+    std::vector<Buffer> _buffers{};
 
   public:
     //! \name Constructors
@@ -75,11 +77,14 @@ class BufferList {
     //!@}
 
     //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    const std::vector<Buffer> &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
 
+    //! \brief Append a BufferList, taking its Buffers
+    void append(BufferList &&other);
+
     //! \brief Transform to a Buffer
     //! \note Throws an exception unless BufferList is contiguous
     operator Buffer() const;
@@ -0,0 +1,235 @@
+#include "datagram_ring.hh"
+
+#include "util.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+//! user_data of the requests to cancel posted receives, whose completions are ignored
+static constexpr uint64_t CANCEL_TAG = UINT64_MAX;
+
+//! Pointer to `p` as io_uring_sqe::addr wants it
+template <typename T>
+static uint64_t sqe_address(T *const p) {
+    return reinterpret_cast<uintptr_t>(p);
+}
+
+DatagramRing::DatagramRing(const FileDescriptor &fd, const Kind kind, const size_t depth, const size_t mtu)
+    : _fd(fd.duplicate())
+    , _kind(kind)
+    , _depth(depth)
+    , _mtu(mtu)
+    , _pool(2 * depth, mtu)
+    , _ring(static_cast<unsigned>(2 * depth))
+    , _slots(2 * depth) {
+    if (_kind == Kind::Device) {
+        _fixed_buffers = _ring.register_buffers({_pool.region()});
+    }
+
+    _free_sends.reserve(depth);
+    for (size_t i = 0; i < _slots.size(); i++) {
+        _slots[i].buffer = _pool.acquire();
+        if (i >= _depth) {
+            _free_sends.push_back(i);
+        }
+    }
+
+    for (size_t i = 0; i < _depth; i++) {
+        _idle_receives.push_back(i);
+    }
+    _post_receives();
+}
+
+DatagramRing::~DatagramRing() {
+    _cancelled = true;
+    if (not _ring.submits_here()) {
+        return;
+    }
+    try {
+        for (size_t i = 0; i < _depth; i++) {
+            io_uring_sqe &sqe = _ring.next_sqe();
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.addr = i;
+            sqe.user_data = CANCEL_TAG;
+        }
+        while (_in_flight > 0) {
+            _ring.submit(1);
+            _reap();
+        }
+    } catch (const exception &e) {
+        cerr << "Exception waiting for io_uring requests to finish: " << e.what() << endl;
+    }
+}
+
+void DatagramRing::_prep_device(
+    io_uring_sqe &sqe, const uint8_t op, const uint8_t fixed_op, Slot &slot, const size_t length) {
+    sqe.opcode = _fixed_buffers ? fixed_op : op;
+    sqe.addr = sqe_address(slot.buffer);
+    sqe.len = static_cast<uint32_t>(length);
+    sqe.off = UINT64_MAX;  // the file position, which TUN/TAP devices don't have
+    sqe.buf_index = 0;     // the whole pool is one registered buffer
+}
+
+//! \details Receives posted separately can complete out of order, as one issued now can take a datagram
+//! before an earlier one that was woken for it gets to run; linked, each is only issued once the one
+//! before it has completed.
+void DatagramRing::_post_receives() {
+    if (_chained > 0 or _cancelled) {
+        return;
+    }
+    for (size_t i = 0; i < _idle_receives.size(); i++) {
+        _post_receive(_idle_receives[i], i + 1 < _idle_receives.size());
+    }
+    _chained = _idle_receives.size();
+    _idle_receives.clear();
+}
+
+void DatagramRing::_post_receive(const size_t slot_index, const bool linked) {
+    Slot &slot = _slots[slot_index];
+    io_uring_sqe &sqe = _ring.next_sqe();
+    sqe.fd = _fd.fd_num();
+    sqe.user_data = slot_index;
+    sqe.flags = linked ? IOSQE_IO_LINK : 0;
+
+    if (_kind == Kind::Socket) {
+        slot.iov = {slot.buffer, _mtu};
+        slot.msg = {};
+        slot.msg.msg_name = &slot.address;
+        slot.msg.msg_namelen = sizeof(slot.address);
+        slot.msg.msg_iov = &slot.iov;
+        slot.msg.msg_iovlen = 1;
+        sqe.opcode = IORING_OP_RECVMSG;
+        sqe.addr = sqe_address(&slot.msg);
+        sqe.len = 1;
+    } else {
+        _prep_device(sqe, IORING_OP_READ, IORING_OP_READ_FIXED, slot, _mtu);
+    }
+    _in_flight++;
+}
+
+void DatagramRing::_queue_send(const Address *const destination, const BufferViewList &payload) {
+    if (payload.size() > _mtu) {
+        throw runtime_error("DatagramRing: datagram payload bigger than the MTU");
+    }
+
+    // with every send slot in flight, wait for some to finish
+    while (_free_sends.empty()) {
+        _ring.submit(1);
+        _reap();
+    }
+    const size_t slot_index = _free_sends.back();
+    _free_sends.pop_back();
+    Slot &slot = _slots[slot_index];
+
+    size_t length = 0;
+    for (const auto &piece : payload.as_iovecs()) {
+        memcpy(slot.buffer + length, piece.iov_base, piece.iov_len);
+        length += piece.iov_len;
+    }
+
+    io_uring_sqe &sqe = _ring.next_sqe();
+    sqe.fd = _fd.fd_num();
+    sqe.user_data = slot_index;
+
+    if (_kind == Kind::Socket) {
+        memcpy(&slot.address, static_cast<const sockaddr *>(*destination), destination->size());
+        slot.iov = {slot.buffer, length};
+        slot.msg = {};
+        slot.msg.msg_name = &slot.address;
+        slot.msg.msg_namelen = destination->size();
+        slot.msg.msg_iov = &slot.iov;
+        slot.msg.msg_iovlen = 1;
+        sqe.opcode = IORING_OP_SENDMSG;
+        sqe.addr = sqe_address(&slot.msg);
+        sqe.len = 1;
+    } else {
+        _prep_device(sqe, IORING_OP_WRITE, IORING_OP_WRITE_FIXED, slot, length);
+    }
+    _in_flight++;
+}
+
+void DatagramRing::_reap() {
+    io_uring_cqe cqe{};
+    while (_ring.next_cqe(cqe)) {
+        if (cqe.user_data == CANCEL_TAG) {
+            continue;
+        }
+        _in_flight--;
+
+        const size_t slot_index = cqe.user_data;
+        if (slot_index >= _depth) {
+            if (cqe.res < 0) {
+                _send_errors++;
+            }
+            _free_sends.push_back(slot_index);
+            continue;
+        }
+
+        _chained--;
+        if (cqe.res >= 0) {
+            // a datagram that didn't fit in the buffer is dropped, as a truncated one would be useless
+            if (_kind == Kind::Device or not(_slots[slot_index].msg.msg_flags & MSG_TRUNC)) {
+                _received.emplace_back(slot_index, cqe.res);
+                continue;
+            }
+        } else if (_cancelled) {
+            continue;
+        } else if (cqe.res != -ECONNREFUSED and cqe.res != -EINTR and cqe.res != -EAGAIN and cqe.res != -ENOBUFS
+                   and cqe.res != -ECANCELED) {
+            // (a receive that fails cancels the rest of its chain)
+            throw unix_error("io_uring receive", -cqe.res);
+        }
+        _idle_receives.push_back(slot_index);
+    }
+}
+
+optional<pair<size_t, size_t>> DatagramRing::_next_received() {
+    if (_received.empty()) {
+        _reap();
+        if (_received.empty()) {
+            return {};
+        }
+    }
+    const auto next = _received.front();
+    _received.pop_front();
+    return next;
+}
+
+optional<UDPSocket::received_datagram> DatagramRing::recv_datagram() {
+    const auto next = _next_received();
+    if (not next.has_value()) {
+        return {};
+    }
+
+    const auto [slot_index, length] = next.value();
+    const Slot &slot = _slots[slot_index];
+    UDPSocket::received_datagram datagram{
+        {reinterpret_cast<const sockaddr *>(&slot.address), slot.msg.msg_namelen}, string(slot.buffer, length)};
+    _idle_receives.push_back(slot_index);
+    return datagram;
+}
+
+optional<string> DatagramRing::recv_packet() {
+    const auto next = _next_received();
+    if (not next.has_value()) {
+        return {};
+    }
+
+    const auto [slot_index, length] = next.value();
+    string packet(_slots[slot_index].buffer, length);
+    _idle_receives.push_back(slot_index);
+    return packet;
+}
+
+//! \param[in] destination the address to send to
+//! \param[in] payload the UDP payload
+void DatagramRing::sendto(const Address &destination, const BufferViewList &payload) {
+    _queue_send(&destination, payload);
+}
+
+//! \param[in] payload the frame or packet
+void DatagramRing::send(const BufferViewList &payload) { _queue_send(nullptr, payload); }
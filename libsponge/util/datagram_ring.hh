@@ -0,0 +1,150 @@
+#ifndef SPONGE_LIBSPONGE_DATAGRAM_RING_HH
+#define SPONGE_LIBSPONGE_DATAGRAM_RING_HH
+
+#include "address.hh"
+#include "buffer.hh"
+#include "file_descriptor.hh"
+#include "io_uring.hh"
+#include "packet_pool.hh"
+#include "socket.hh"
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+//! \brief Batched datagram I/O on a UDP socket or a TUN/TAP device through an IoUring
+//! \details Receives are posted, each into its own buffer from a PacketPool, so datagrams that arrive
+//! while the application is busy are already copied out of the kernel when it gets to them. They are
+//! posted as one linked chain, so they take datagrams in the order these arrive; the buffers the
+//! application has taken datagrams from are posted again, as the next chain, once the last of the
+//! current one completes. Sends are copied into pool buffers and queued; flush() hands every queued
+//! send, and the next chain of receives if it's due, to the kernel in one system call.
+//!
+//! The ring's fd() becomes readable when anything completes, so it is waited on by an EventLoop in
+//! place of the socket or device. Its rule should drain recv_datagram() (or recv_packet()), and
+//! flush() should be called before each wait (or at the end of each callback that queues anything).
+//! fd() starts out readable, so the rule runs once before anything has completed, and the receives are
+//! submitted by the first flush(). The thread that calls it is the only one that can use the DatagramRing
+//! from then on (see IoUring).
+//!
+//! For a device, the pool is registered with the kernel and read and written with fixed buffers
+//! (unless the kernel won't pin it, in which case plain reads and writes are used). A socket needs
+//! recvmsg and sendmsg for the peer's address, which can't use fixed buffers.
+class DatagramRing {
+  public:
+    //! What the ring does I/O on
+    enum class Kind {
+        Socket,  //!< a UDP socket: receive with recv_datagram(), send with sendto()
+        Device   //!< a TUN or TAP device: receive with recv_packet(), send with send()
+    };
+
+  private:
+    //! One posted receive or queued send, and what the kernel reads or writes for it
+    struct Slot {
+        char *buffer;
+        iovec iov;
+        msghdr msg;
+        sockaddr_storage address;
+    };
+
+    FileDescriptor _fd;  //!< the socket or device
+    Kind _kind;
+    size_t _depth;  //!< receive slots, and send slots
+    size_t _mtu;    //!< size of each buffer
+    PacketPool _pool;
+    IoUring _ring;
+    bool _fixed_buffers{false};  //!< is `_pool` registered with `_ring`?
+
+    std::vector<Slot> _slots;  //!< the first `_depth` are for receives, the rest for sends
+
+    std::vector<size_t> _free_sends{};  //!< send slots not in flight
+
+    std::deque<std::pair<size_t, size_t>> _received{};  //!< completed receives: slot, and bytes received
+
+    std::vector<size_t> _idle_receives{};  //!< receive slots to post in the next chain
+
+    size_t _chained{0};  //!< receives of the current chain that haven't completed
+
+    size_t _in_flight{0};  //!< receives and sends the kernel hasn't completed
+
+    bool _cancelled{false};  //!< being destroyed: don't post receives again
+
+    uint64_t _send_errors{0};
+
+    //! Post the idle receive slots as the next chain, unless the current one is still going
+    void _post_receives();
+
+    //! Post a receive into a slot, linked to the next one posted if `linked`
+    void _post_receive(const size_t slot, const bool linked);
+
+    //! Copy a datagram into a free send slot and queue it
+    void _queue_send(const Address *const destination, const BufferViewList &payload);
+
+    //! Fill in a read or write of a slot's buffer on a device
+    void _prep_device(io_uring_sqe &sqe, const uint8_t op, const uint8_t fixed_op, Slot &slot, const size_t length);
+
+    //! Take every waiting completion
+    void _reap();
+
+    //! The oldest completed receive (slot, length), if any
+    std::optional<std::pair<size_t, size_t>> _next_received();
+
+  public:
+    //! Receives posted (and sends queued) at once if not otherwise specified
+    static constexpr size_t DEFAULT_DEPTH = 64;
+
+    //! \brief Do batched I/O on (a duplicate of) `fd`
+    //! \param[in] fd the UDP socket or TUN/TAP device
+    //! \param[in] kind which of the two `fd` is
+    //! \param[in] depth how many receives to keep posted, and how many sends may be in flight
+    //! \param[in] mtu the largest datagram; larger ones received are dropped
+    DatagramRing(const FileDescriptor &fd, const Kind kind, const size_t depth = DEFAULT_DEPTH,
+                 const size_t mtu = 2048);
+
+    //! \brief Cancels the posted receives and waits for everything in flight, whose buffers are about to go
+    //! \details On another thread than the ring's, closing the ring (before the buffers go) cancels them instead.
+    ~DatagramRing();
+
+    //! \brief Can a DatagramRing be used here? (If not, fall back to system calls on the fd itself.)
+    static bool available() { return IoUring::available(); }
+
+    //! \brief The next datagram received on a socket, and its sender, if one has arrived
+    std::optional<UDPSocket::received_datagram> recv_datagram();
+
+    //! \brief The next frame or packet read from a device, if one has arrived
+    std::optional<std::string> recv_packet();
+
+    //! \brief Queue a datagram to `destination` on a socket
+    void sendto(const Address &destination, const BufferViewList &payload);
+
+    //! \brief Queue a frame or packet to write to a device
+    void send(const BufferViewList &payload);
+
+    //! \brief Submit queued sends and the next chain of receives, if the current one is done
+    void flush() {
+        _post_receives();
+        _ring.submit();
+    }
+
+    //! \brief The file descriptor to wait on for completions
+    const FileDescriptor &fd() const { return _ring.completions(); }
+
+    //! \brief Is the pool registered with the kernel, so a device is read and written with fixed buffers?
+    bool fixed_buffers() const { return _fixed_buffers; }
+
+    //! \brief Sends the kernel reported failing (e.g., ECONNREFUSED from an earlier ICMP error)
+    uint64_t send_errors() const { return _send_errors; }
+
+    //! \name
+    //! The kernel holds pointers into a DatagramRing, so it can't be copied or moved
+    //!@{
+    DatagramRing(const DatagramRing &other) = delete;
+    DatagramRing &operator=(const DatagramRing &other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_DATAGRAM_RING_HH
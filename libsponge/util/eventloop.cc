@@ -1,7 +1,9 @@
 #include "eventloop.hh"
 
+#include "io_uring.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
 #include <stdexcept>
 #include <system_error>
@@ -10,10 +12,29 @@
 
 using namespace std;
 
+//! (Backend::IoUring) Submission queue entries; more poll requests than this are submitted in several calls
+static constexpr unsigned RING_ENTRIES = 256;
+
 unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
 
+//! \param[in] backend is the system call to wait in
+EventLoop::EventLoop(const Backend backend) : _backend(backend) {
+    if (_backend == Backend::Epoll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+    }
+    if (_backend == Backend::IoUring) {
+        if (IoUring::available()) {
+            _ring = make_unique<IoUring>(RING_ENTRIES);
+        } else {
+            _backend = Backend::Poll;
+        }
+    }
+}
+
+EventLoop::~EventLoop() = default;
+
 //! \param[in] fd is the FileDescriptor to be polled
 //! \param[in] direction indicates whether to poll for reading (Direction::In) or writing (Direction::Out)
 //! \param[in] callback is called when `fd` is ready.
@@ -26,6 +47,72 @@ void EventLoop::add_rule(const FileDescriptor &fd,
                          const InterestT &interest,
                          const CallbackT &cancel) {
     _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+    if (_backend == Backend::Epoll) {
+        _registrations[fd.fd_num()].rules.push_back(&_rules.back());
+        _epoll_update(fd.fd_num(), true);
+    }
+}
+
+//! \param[in] fd_num the file descriptor number whose registration to update
+//! \param[in] force register it even if the events haven't changed (e.g. for a new Rule)
+void EventLoop::_epoll_update(const int fd_num, const bool force) {
+    EpollRegistration &registration = _registrations.at(fd_num);
+    uint32_t events = 0;
+    for (const Rule *rule : registration.rules) {
+        if (rule->interested) {
+            events |= static_cast<uint32_t>(rule->direction);
+        }
+    }
+    if (events == registration.events and not force) {
+        return;
+    }
+
+    registration.events = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd_num;
+    // the kernel drops a registration when its fd is closed, so fall back to adding it anew
+    if (SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_MOD, fd_num, &event), ENOENT) < 0) {
+        SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_ADD, fd_num, &event));
+    }
+}
+
+//! \param[in] it the rule to erase
+//! \returns the rule after it
+list<EventLoop::Rule>::iterator EventLoop::_erase_rule(const list<Rule>::iterator it) {
+    if (_backend == Backend::IoUring) {
+        _remove_poll(*it);
+    }
+    if (_backend == Backend::Epoll) {
+        const int fd_num = it->fd.fd_num();
+        auto &rules = _registrations.at(fd_num).rules;
+        rules.erase(find(rules.begin(), rules.end(), &*it));
+        if (rules.empty()) {
+            _registrations.erase(fd_num);
+            if (not it->fd.closed()) {
+                epoll_event event{};
+                ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd_num, &event);  // may already be gone
+            }
+        } else {
+            _epoll_update(fd_num);
+        }
+    }
+    return _rules.erase(it);
+}
+
+//! \details The request's completion (and that of the removal) is ignored once it is no longer in _polls.
+//! \param[in] rule the rule whose request to remove
+void EventLoop::_remove_poll(Rule &rule) {
+    if (rule.poll_id == 0) {
+        return;
+    }
+    _polls.erase(rule.poll_id);
+    io_uring_sqe &sqe = _ring->next_sqe();
+    sqe.opcode = IORING_OP_POLL_REMOVE;
+    sqe.fd = -1;
+    sqe.addr = rule.poll_id;
+    sqe.user_data = 0;
+    rule.poll_id = 0;
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -59,6 +146,13 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    if (_backend == Backend::Epoll) {
+        return _wait_next_event_epoll(timeout_ms);
+    }
+    if (_backend == Backend::IoUring) {
+        return _wait_next_event_io_uring(timeout_ms);
+    }
+
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -143,3 +237,193 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+//! \param[in] timeout_ms is the timeout value passed to [epoll_wait(2)](\ref man2::epoll_wait)
+//! \details Same contract as wait_next_event() with Backend::Poll; see the EventLoop class documentation.
+EventLoop::Result EventLoop::_wait_next_event_epoll(const int timeout_ms) {
+    bool something_to_poll = false;
+
+    // cancel rules whose fd is finished, and pass on any change in interest
+    for (auto it = _rules.begin(); it != _rules.end();) {  // NOTE: it gets erased or incremented in loop body
+        auto &this_rule = *it;
+        if ((this_rule.direction == Direction::In && this_rule.fd.eof()) || this_rule.fd.closed()) {
+            this_rule.cancel();
+            it = _erase_rule(it);
+            continue;
+        }
+
+        const bool interested = this_rule.interest();
+        if (interested != this_rule.interested) {
+            this_rule.interested = interested;
+            _epoll_update(this_rule.fd.fd_num());
+        }
+        something_to_poll |= interested;
+        ++it;
+    }
+
+    // quit if there is nothing left to poll
+    if (not something_to_poll) {
+        return Result::Exit;
+    }
+
+    _epoll_events.resize(max(_registrations.size(), size_t{1}));
+    int ready = 0;
+    try {
+        ready = SystemCall(
+            "epoll_wait", ::epoll_wait(_epoll->fd_num(), _epoll_events.data(), _epoll_events.size(), timeout_ms));
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    if (ready == 0) {
+        return Result::Timeout;
+    }
+
+    bool any_cancelled = false;
+    for (int i = 0; i < ready; i++) {
+        const auto &event = _epoll_events[i];
+        if (event.events & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        const auto registration = _registrations.find(event.data.fd);
+        if (registration == _registrations.end()) {
+            continue;
+        }
+        // a copy, since a callback may add rules
+        const auto rules = registration->second.rules;
+        for (Rule *this_rule : rules) {
+            if (this_rule->cancelled or not this_rule->interested) {
+                continue;
+            }
+
+            const auto poll_ready = static_cast<bool>(event.events & static_cast<uint32_t>(this_rule->direction));
+            const auto poll_hup = static_cast<bool>(event.events & EPOLLHUP);
+            if (poll_hup && !poll_ready) {
+                // as with poll: a hangup and nothing else means this fd is defunct
+                this_rule->cancel();
+                this_rule->cancelled = true;
+                any_cancelled = true;
+                continue;
+            }
+
+            if (poll_ready) {
+                const auto count_before = this_rule->service_count();
+                this_rule->callback();
+
+                if (count_before == this_rule->service_count() and this_rule->interest()) {
+                    throw runtime_error(
+                        "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+                }
+            }
+        }
+    }
+
+    if (any_cancelled) {
+        for (auto it = _rules.begin(); it != _rules.end();) {
+            it = it->cancelled ? _erase_rule(it) : next(it);
+        }
+    }
+
+    return Result::Success;
+}
+
+//! \param[in] timeout_ms how long to wait for a poll request to complete
+//! \details Same contract as wait_next_event() with Backend::Poll; see the EventLoop class documentation.
+EventLoop::Result EventLoop::_wait_next_event_io_uring(const int timeout_ms) {
+    bool something_to_poll = false;
+
+    // cancel rules whose fd is finished, and post a poll request for each interested rule without one
+    for (auto it = _rules.begin(); it != _rules.end();) {  // NOTE: it gets erased or incremented in loop body
+        auto &this_rule = *it;
+        if ((this_rule.direction == Direction::In && this_rule.fd.eof()) || this_rule.fd.closed()) {
+            this_rule.cancel();
+            it = _erase_rule(it);
+            continue;
+        }
+
+        if (not this_rule.interest()) {
+            _remove_poll(this_rule);
+        } else if (this_rule.poll_id == 0) {
+            this_rule.poll_id = _next_poll_id++;
+            _polls.emplace(this_rule.poll_id, &this_rule);
+            io_uring_sqe &sqe = _ring->next_sqe();
+            sqe.opcode = IORING_OP_POLL_ADD;
+            sqe.fd = this_rule.fd.fd_num();
+            sqe.poll32_events = static_cast<uint32_t>(this_rule.direction);
+            sqe.user_data = this_rule.poll_id;
+            something_to_poll = true;
+        } else {
+            something_to_poll = true;
+        }
+        ++it;
+    }
+
+    // quit if there is nothing left to poll
+    if (not something_to_poll) {
+        _ring->submit();  // the removals
+        return Result::Exit;
+    }
+
+    try {
+        if (not _ring->wait(timeout_ms)) {
+            return Result::Timeout;
+        }
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+
+    bool any_cancelled = false;
+    io_uring_cqe cqe{};
+    // only the completions already waiting: finishing more would cost a system call for nothing
+    for (unsigned completions = _ring->ready(); completions > 0 and _ring->next_cqe(cqe); completions--) {
+        const auto request = _polls.find(cqe.user_data);
+        if (request == _polls.end()) {
+            continue;  // a removal, or the request of a rule that has been erased
+        }
+        Rule *this_rule = request->second;
+        _polls.erase(request);
+        this_rule->poll_id = 0;
+        if (cqe.res < 0) {
+            throw unix_error("io_uring poll", -cqe.res);
+        }
+
+        const auto revents = static_cast<uint32_t>(cqe.res);
+        if (revents & (POLLERR | POLLNVAL)) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        const auto poll_ready = static_cast<bool>(revents & static_cast<uint32_t>(this_rule->direction));
+        const auto poll_hup = static_cast<bool>(revents & POLLHUP);
+        if (poll_hup && !poll_ready) {
+            // as with poll: a hangup and nothing else means this fd is defunct
+            this_rule->cancel();
+            this_rule->cancelled = true;
+            any_cancelled = true;
+            continue;
+        }
+
+        if (poll_ready) {
+            const auto count_before = this_rule->service_count();
+            this_rule->callback();
+
+            if (count_before == this_rule->service_count() and this_rule->interest()) {
+                throw runtime_error(
+                    "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+            }
+        }
+    }
+
+    if (any_cancelled) {
+        for (auto it = _rules.begin(); it != _rules.end();) {
+            it = it->cancelled ? _erase_rule(it) : next(it);
+        }
+    }
+
+    return Result::Success;
+}
@@ -3,10 +3,18 @@
 
 #include "file_descriptor.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <memory>
+#include <optional>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
+
+class IoUring;
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,6 +25,13 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! The system call an EventLoop waits in
+    enum class Backend {
+        Poll,    //!< [poll(2)](\ref man2::poll), with the list of fds rebuilt on every call
+        Epoll,   //!< [epoll(7)](\ref man7::epoll), with fds registered once and updated when interest changes
+        IoUring  //!< an [io_uring(7)](\ref man7::io_uring) poll request per interested fd (Poll if unavailable)
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
@@ -30,14 +45,48 @@ class EventLoop {
         CallbackT callback;   //!< A callback that reads or writes fd.
         InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool interested{false};  //!< (Backend::Epoll) What Rule::interest returned when last asked.
+        bool cancelled{false};   //!< (Backend::Epoll, IoUring) Canceled while handling events; erased afterwards.
+        uint64_t poll_id{0};     //!< (Backend::IoUring) The poll request waiting on fd, if not 0.
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
     };
 
+    //! (Backend::Epoll) The registration of one file descriptor number, shared by its rules
+    struct EpollRegistration {
+        uint32_t events{0};           //!< events the epoll instance is asked to report
+        std::vector<Rule *> rules{};  //!< rules on this fd
+    };
+
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
 
+    Backend _backend;
+
+    //! \name Backend::Epoll state
+    //!@{
+    std::optional<FileDescriptor> _epoll{};                        //!< the epoll instance
+    std::unordered_map<int, EpollRegistration> _registrations{};  //!< by fd number
+    std::vector<epoll_event> _epoll_events{};                      //!< filled in by epoll_wait
+    //!@}
+
+    //! \name Backend::IoUring state
+    //!@{
+    std::unique_ptr<IoUring> _ring{};               //!< the ring the poll requests go through
+    std::unordered_map<uint64_t, Rule *> _polls{};  //!< rules with a poll request, by its id
+    uint64_t _next_poll_id{1};                      //!< 0 means no request (and tags removals)
+    //!@}
+
+    //! (Backend::IoUring) Ask the kernel to drop a rule's poll request
+    void _remove_poll(Rule &rule);
+
+    //! (Backend::Epoll) Bring the registration of `fd_num` in line with the interest of its rules
+    void _epoll_update(const int fd_num, const bool force = false);
+
+    //! Erase a rule (and, for Backend::Epoll, its part of the registration, or for Backend::IoUring, its poll)
+    std::list<Rule>::iterator _erase_rule(const std::list<Rule>::iterator it);
+
   public:
     //! Returned by each call to EventLoop::wait_next_event.
     enum class Result {
@@ -53,8 +102,23 @@ class EventLoop {
                   const InterestT &interest = [] { return true; },
                   const CallbackT &cancel = [] {});
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! Calls [poll(2)](\ref man2::poll) (or epoll_wait) and then executes callback for each ready fd.
     Result wait_next_event(const int timeout_ms);
+
+    //! Construct an EventLoop with no rules that waits with `backend`
+    explicit EventLoop(const Backend backend = Backend::Poll);
+
+    ~EventLoop();
+
+    //! The backend in use (Backend::IoUring falls back to Backend::Poll where io_uring is unavailable)
+    Backend backend() const { return _backend; }
+
+  private:
+    //! wait_next_event() for Backend::Epoll
+    Result _wait_next_event_epoll(const int timeout_ms);
+
+    //! wait_next_event() for Backend::IoUring
+    Result _wait_next_event_io_uring(const int timeout_ms);
 };
 
 using Direction = EventLoop::Direction;
@@ -72,5 +136,17 @@ using Direction = EventLoop::Direction;
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
+//!
+//! With Backend::Epoll, each file descriptor is registered with an [epoll(7)](\ref man7::epoll)
+//! instance when its first Rule is added, and [epoll_ctl(2)](\ref man2::epoll_ctl) is only called
+//! again when a Rule::interest callback changes its answer. A wakeup then costs one call of each
+//! Rule::interest plus work for the file descriptors that are ready, instead of building and
+//! scanning a [poll(2)](\ref man2::poll) array of every file descriptor. It is level triggered,
+//! so the rules behave exactly as with Backend::Poll.
+//!
+//! With Backend::IoUring, each interested Rule has a one-shot IORING_OP_POLL_ADD request, and
+//! wait_next_event() submits the new requests and waits for completions in one io_uring_enter. A request
+//! is only posted again after its Rule has been handled, so this too behaves as level triggered. The ring
+//! belongs to the thread that first calls wait_next_event() (see the IoUring class).
 
 #endif  // SPONGE_LIBSPONGE_EVENTLOOP_HH
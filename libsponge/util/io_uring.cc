@@ -0,0 +1,220 @@
+#include "io_uring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+// there is no libc wrapper for the io_uring system calls (short of liburing), so call them directly
+
+int IoUring::setup(const unsigned entries, io_uring_params &params) {
+    params = {};
+    // disabled until the first submit, which makes the submitting thread (not the constructing one) the issuer
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_TASKRUN_FLAG |
+                   IORING_SETUP_R_DISABLED;
+    return SystemCall("io_uring_setup", static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params)));
+}
+
+//! Call io_uring_register
+static int ring_register(const int fd, const unsigned opcode, const void *const arg, const unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+//! \details The event starts out signalled, so the first wait on it ends at once, and whoever drains the
+//! ring there gets to submit what was prepared before (say, receives to post).
+IoUring::CompletionEvent::CompletionEvent()
+    : FileDescriptor(SystemCall("eventfd", ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC))) {}
+
+bool IoUring::CompletionEvent::take() {
+    uint64_t count = 0;
+    const ssize_t bytes_read = ::read(fd_num(), &count, sizeof(count));
+    if (bytes_read < 0) {
+        SystemCall("read eventfd", static_cast<int>(bytes_read), EAGAIN);
+    }
+    register_read();
+    return bytes_read > 0;
+}
+
+//! Map one of the ring's regions, at offset `offset` of its file descriptor
+static void *map_ring(const int fd, const size_t size, const off_t offset) {
+    void *const region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (region == MAP_FAILED) {
+        throw unix_error("mmap io_uring");
+    }
+    return region;
+}
+
+//! Pointer to the field `offset` bytes into a mapped ring
+template <typename T>
+static T *field(void *const ring, const uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+IoUring::IoUring(const unsigned entries) : IoUring(entries, io_uring_params{}) {}
+
+//! \param[in] entries the size of the submission queue asked for
+//! \param[in] params filled in by setup() before the members are initialized
+IoUring::IoUring(const unsigned entries, io_uring_params params)
+    : FileDescriptor(setup(entries, params))
+    , _sq_ring(nullptr)
+    , _sq_ring_size(params.sq_off.array + params.sq_entries * sizeof(unsigned))
+    , _sq_head(nullptr)
+    , _sq_tail(nullptr)
+    , _sq_flags(nullptr)
+    , _sq_mask(0)
+    , _sq_array(nullptr)
+    , _sqes(nullptr)
+    , _sqes_size(params.sq_entries * sizeof(io_uring_sqe))
+    , _cq_ring(nullptr)
+    , _cq_ring_size(params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe))
+    , _cq_head(nullptr)
+    , _cq_tail(nullptr)
+    , _cq_mask(0)
+    , _cqes(nullptr)
+    , _entries(params.sq_entries) {
+    // newer kernels put both rings in one mapping
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        _sq_ring_size = _cq_ring_size = max(_sq_ring_size, _cq_ring_size);
+    }
+
+    _sq_ring = map_ring(fd_num(), _sq_ring_size, IORING_OFF_SQ_RING);
+    _cq_ring = single_mmap ? _sq_ring : map_ring(fd_num(), _cq_ring_size, IORING_OFF_CQ_RING);
+    _sqes = static_cast<io_uring_sqe *>(map_ring(fd_num(), _sqes_size, IORING_OFF_SQES));
+
+    _sq_head = field<unsigned>(_sq_ring, params.sq_off.head);
+    _sq_tail = field<unsigned>(_sq_ring, params.sq_off.tail);
+    _sq_flags = field<unsigned>(_sq_ring, params.sq_off.flags);
+    _sq_mask = *field<unsigned>(_sq_ring, params.sq_off.ring_mask);
+    _sq_array = field<unsigned>(_sq_ring, params.sq_off.array);
+
+    _cq_head = field<unsigned>(_cq_ring, params.cq_off.head);
+    _cq_tail = field<unsigned>(_cq_ring, params.cq_off.tail);
+    _cq_mask = *field<unsigned>(_cq_ring, params.cq_off.ring_mask);
+    _cqes = field<io_uring_cqe>(_cq_ring, params.cq_off.cqes);
+
+    const int event_fd = _completion_event.fd_num();
+    SystemCall("io_uring_register eventfd", ring_register(fd_num(), IORING_REGISTER_EVENTFD, &event_fd, 1));
+}
+
+IoUring::~IoUring() {
+    ::munmap(_sqes, _sqes_size);
+    if (_cq_ring != _sq_ring) {
+        ::munmap(_cq_ring, _cq_ring_size);
+    }
+    ::munmap(_sq_ring, _sq_ring_size);
+}
+
+bool IoUring::available() {
+    static const bool works = [] {
+        try {
+            IoUring probe{1};
+            return true;
+        } catch (const unix_error &) {
+            return false;  // ENOSYS or EINVAL on old kernels, EPERM where seccomp or a sysctl forbids it
+        }
+    }();
+    return works;
+}
+
+io_uring_sqe &IoUring::next_sqe() {
+    if (*_sq_tail + _unsubmitted - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) >= _entries) {
+        submit();
+    }
+
+    const unsigned index = (*_sq_tail + _unsubmitted) & _sq_mask;
+    _unsubmitted++;
+    _sq_array[index] = index;
+    io_uring_sqe &sqe = _sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    return sqe;
+}
+
+unsigned IoUring::unsubmitted() const {
+    return *_sq_tail + _unsubmitted - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+}
+
+//! \details Entries the kernel didn't take (it only does so under memory pressure) stay queued
+//! and go with the next submit().
+unsigned IoUring::submit(const unsigned wait_for) {
+    const unsigned to_submit = _publish();
+    if (to_submit == 0 and wait_for == 0) {
+        return 0;
+    }
+
+    const int submitted = _enter(to_submit, wait_for, wait_for > 0 ? IORING_ENTER_GETEVENTS : 0);
+    return submitted < 0 ? 0 : static_cast<unsigned>(submitted);
+}
+
+//! \details Waiting also finishes the requests the kernel has deferred, so completions() needn't be watched.
+bool IoUring::wait(const int timeout_ms) {
+    const unsigned to_submit = _publish();
+    if (timeout_ms < 0) {
+        _enter(to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        return true;
+    }
+
+    __kernel_timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    io_uring_getevents_arg arg{};
+    arg.ts = reinterpret_cast<uintptr_t>(&timeout);
+    _enter(to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, ETIME);
+    return ready() > 0;
+}
+
+unsigned IoUring::_publish() {
+    __atomic_store_n(_sq_tail, *_sq_tail + _unsubmitted, __ATOMIC_RELEASE);
+    _unsubmitted = 0;
+    return unsubmitted();
+}
+
+//! \param[in] to_submit entries to submit
+//! \param[in] wait_for completions to wait for (with IORING_ENTER_GETEVENTS)
+//! \param[in] flags passed on to io_uring_enter
+//! \param[in] arg the wait's timeout (with IORING_ENTER_EXT_ARG)
+//! \param[in] errno_mask an error to return (as -1) rather than throw
+int IoUring::_enter(const unsigned to_submit,
+                    const unsigned wait_for,
+                    const unsigned flags,
+                    const io_uring_getevents_arg *const arg,
+                    const int errno_mask) {
+    if (_issuer == thread::id{}) {
+        SystemCall("io_uring_register enable", ring_register(fd_num(), IORING_REGISTER_ENABLE_RINGS, nullptr, 0));
+        _issuer = this_thread::get_id();
+    }
+    const size_t arg_size = arg == nullptr ? 0 : sizeof(*arg);
+    return SystemCall(
+        "io_uring_enter",
+        static_cast<int>(::syscall(__NR_io_uring_enter, fd_num(), to_submit, wait_for, flags, arg, arg_size)),
+        errno_mask);
+}
+
+bool IoUring::next_cqe(io_uring_cqe &cqe) {
+    const unsigned head = *_cq_head;
+    while (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+        // reset the event before finishing the requests behind it, so none signalled later is missed; the
+        // kernel only finishes so many requests per call, and flags the ring if it left some for the next
+        const bool signalled = _completion_event.take();
+        const bool unfinished = __atomic_load_n(_sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_TASKRUN;
+        if ((not signalled and not unfinished) or _issuer == thread::id{}) {
+            return false;
+        }
+        _enter(0, 0, IORING_ENTER_GETEVENTS);
+    }
+
+    cqe = _cqes[head & _cq_mask];
+    __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool IoUring::register_buffers(const vector<iovec> &buffers) {
+    const int ret =
+        ring_register(fd_num(), IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size()));
+    return SystemCall("io_uring_register", ret, ENOMEM) >= 0;
+}
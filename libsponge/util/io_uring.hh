@@ -0,0 +1,138 @@
+#ifndef SPONGE_LIBSPONGE_IO_URING_HH
+#define SPONGE_LIBSPONGE_IO_URING_HH
+
+#include "file_descriptor.hh"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+//! \brief A minimal [io_uring(7)](\ref man7::io_uring) instance, set up with the raw system calls
+//! \details The IoUring is the ring's file descriptor. Its completions() eventfd is signalled whenever
+//! the kernel has something for next_cqe(), so it can be watched by an EventLoop like any other
+//! FileDescriptor; finding no more completions with next_cqe() counts as a read of it for EventLoop's
+//! busy-wait check. It is also signalled to begin with, so a rule on it gets its first chance to submit.
+//!
+//! Submissions are only passed to the kernel by submit(), so any number of them cost one system call.
+//!
+//! The ring defers the kernel's work of finishing requests until the application asks for completions
+//! (IORING_SETUP_DEFER_TASKRUN, Linux 6.1), rather than interrupting whatever the submitting thread is
+//! blocked in, so a wait on completions() only ends early for a real signal. In exchange, only one thread
+//! can use the ring: the first to submit().
+class IoUring : public FileDescriptor {
+  private:
+    //! An eventfd the kernel signals when requests have finished
+    class CompletionEvent : public FileDescriptor {
+      public:
+        CompletionEvent();
+
+        //! \brief Reset the event (a read, for EventLoop's busy-wait check)
+        //! \returns `true` if it had been signalled
+        bool take();
+    };
+
+    //! \name Submission queue (shared with the kernel)
+    //!@{
+    void *_sq_ring;
+    size_t _sq_ring_size;
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned *_sq_flags;
+    unsigned _sq_mask;
+    unsigned *_sq_array;
+    io_uring_sqe *_sqes;
+    size_t _sqes_size;
+    //!@}
+
+    //! \name Completion queue (shared with the kernel; may share the mapping of the submission queue)
+    //!@{
+    void *_cq_ring;
+    size_t _cq_ring_size;
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    io_uring_cqe *_cqes;
+    //!@}
+
+    unsigned _entries;         //!< size of the submission queue
+    unsigned _unsubmitted{0};  //!< entries filled in but not yet made visible to the kernel
+
+    CompletionEvent _completion_event{};  //!< registered with the ring
+    std::thread::id _issuer{};            //!< the thread that enabled the ring by submitting first
+
+    //! Make the entries filled in visible to the kernel; returns how many it hasn't taken yet
+    unsigned _publish();
+
+    //! Call io_uring_enter, enabling the ring first if this is the first call
+    int _enter(const unsigned to_submit,
+               const unsigned wait_for,
+               const unsigned flags,
+               const io_uring_getevents_arg *const arg = nullptr,
+               const int errno_mask = EINTR);
+
+    //! Set up the ring (the FileDescriptor is constructed from its result)
+    static int setup(const unsigned entries, io_uring_params &params);
+
+    IoUring(const unsigned entries, io_uring_params params);
+
+  public:
+    //! \brief Set up a ring with (at least) `entries` submission queue entries
+    //! \throws unix_error if the kernel doesn't support io_uring with deferred task work (or it is disallowed)
+    explicit IoUring(const unsigned entries);
+
+    ~IoUring();
+
+    //! \brief Can an IoUring be set up here?
+    static bool available();
+
+    //! \brief A cleared submission queue entry to fill in; submits first if the queue is full
+    io_uring_sqe &next_sqe();
+
+    //! \brief Pass the entries filled in so far to the kernel
+    //! \param[in] wait_for also wait until at least this many completions are available
+    //! \returns the number of entries submitted
+    unsigned submit(const unsigned wait_for = 0);
+
+    //! \brief Submit, and wait until a completion is available
+    //! \param[in] timeout_ms how long to wait at most (forever if negative)
+    //! \returns `false` if the timeout expired first
+    //! \throws unix_error with EINTR if a signal interrupted the wait
+    bool wait(const int timeout_ms);
+
+    //! \brief Take the next completion, if there is one
+    //! \details Once the completion queue is empty, finishes the requests the kernel has signalled
+    //! completions() for (which costs a system call), and looks again.
+    //! \returns `false` if no completion is waiting
+    bool next_cqe(io_uring_cqe &cqe);
+
+    //! \brief Completions in the queue, which next_cqe() takes without a system call
+    unsigned ready() const { return __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE) - *_cq_head; }
+
+    //! \brief The file descriptor to wait on for completions
+    const FileDescriptor &completions() const { return _completion_event; }
+
+    //! \brief Can this thread submit? Only the first thread to submit can, from then on.
+    bool submits_here() const { return _issuer == std::thread::id{} or _issuer == std::this_thread::get_id(); }
+
+    //! \brief Register buffers for IORING_OP_READ_FIXED and IORING_OP_WRITE_FIXED
+    //! \returns `false` if the kernel won't pin that much memory (see RLIMIT_MEMLOCK)
+    bool register_buffers(const std::vector<iovec> &buffers);
+
+    //! \brief Entries filled in but not yet submitted
+    unsigned unsubmitted() const;
+
+    //! \name
+    //! An IoUring owns its mappings, so it can't be copied or moved
+    //!@{
+    IoUring(const IoUring &other) = delete;
+    IoUring &operator=(const IoUring &other) = delete;
+    IoUring(IoUring &&other) = delete;
+    IoUring &operator=(IoUring &&other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_IO_URING_HH
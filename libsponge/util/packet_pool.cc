@@ -0,0 +1,31 @@
+#include "packet_pool.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+PacketPool::PacketPool(const size_t count, const size_t buffer_size)
+    : _buffer_size(buffer_size), _storage(count * buffer_size) {
+    _free.reserve(count);
+    // hand out buffers from the start of the region first
+    for (size_t i = count; i > 0; i--) {
+        _free.push_back(_storage.data() + (i - 1) * buffer_size);
+    }
+}
+
+char *PacketPool::acquire() {
+    if (_free.empty()) {
+        return nullptr;
+    }
+    char *const buffer = _free.back();
+    _free.pop_back();
+    return buffer;
+}
+
+void PacketPool::release(char *const buffer) {
+    if (buffer < _storage.data() or buffer >= _storage.data() + _storage.size() or
+        (buffer - _storage.data()) % _buffer_size != 0) {
+        throw runtime_error("PacketPool::release: not one of this pool's buffers");
+    }
+    _free.push_back(buffer);
+}
@@ -0,0 +1,39 @@
+#ifndef SPONGE_LIBSPONGE_PACKET_POOL_HH
+#define SPONGE_LIBSPONGE_PACKET_POOL_HH
+
+#include <cstddef>
+#include <sys/uio.h>
+#include <vector>
+
+//! \brief A fixed number of equal-sized packet buffers carved from one allocation
+//! \details Buffers are handed out and returned without touching the allocator. Because the whole
+//! pool is one contiguous region(), it can be registered with the kernel once (see
+//! IoUring::register_buffers) and any buffer in it used for fixed-buffer I/O.
+class PacketPool {
+  private:
+    size_t _buffer_size;
+    std::vector<char> _storage;
+    std::vector<char *> _free{};  //!< buffers not handed out
+
+  public:
+    //! \brief Allocate `count` buffers of `buffer_size` bytes each
+    PacketPool(const size_t count, const size_t buffer_size);
+
+    //! \brief Take a buffer
+    //! \returns `nullptr` if every buffer is in use
+    char *acquire();
+
+    //! \brief Give back a buffer that acquire() returned
+    void release(char *const buffer);
+
+    //! \brief Size of each buffer
+    size_t buffer_size() const { return _buffer_size; }
+
+    //! \brief Buffers that are not in use
+    size_t available() const { return _free.size(); }
+
+    //! \brief The memory of every buffer in the pool
+    iovec region() { return {_storage.data(), _storage.size()}; }
+};
+
+#endif  // SPONGE_LIBSPONGE_PACKET_POOL_HH
@@ -0,0 +1,151 @@
+#include "packet_ring.hh"
+
+#include "util.hh"
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+using namespace std;
+
+//! Where the frame starts in a transmit slot (what the kernel expects without PACKET_TX_HAS_OFF)
+static constexpr size_t TX_DATA_OFFSET = TPACKET_ALIGN(sizeof(tpacket3_hdr));
+
+//! A ring of `block_count` blocks; a receive ring's blocks are handed over a millisecond after their first frame
+static tpacket_req3 ring_request(const size_t block_count, const size_t frame_size, const bool rx) {
+    tpacket_req3 req{};
+    req.tp_block_size = PacketRing::BLOCK_SIZE;
+    req.tp_block_nr = block_count;
+    req.tp_frame_size = frame_size;
+    req.tp_frame_nr = PacketRing::BLOCK_SIZE / frame_size * block_count;
+    req.tp_retire_blk_tov = rx ? 1 : 0;
+    return req;
+}
+
+//! setsockopt(2) at level SOL_PACKET
+template <typename T>
+static void set_packet_option(const int fd, const char *attempt, const int option, const T &value) {
+    SystemCall(attempt, ::setsockopt(fd, SOL_PACKET, option, &value, sizeof(value)));
+}
+
+static uint32_t load_status(const uint32_t &status) { return __atomic_load_n(&status, __ATOMIC_ACQUIRE); }
+
+static void store_status(uint32_t &status, const uint32_t value) { __atomic_store_n(&status, value, __ATOMIC_RELEASE); }
+
+PacketRing::PacketRing(const string &interface, const size_t frame_size)
+    : FileDescriptor(SystemCall("socket", ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL)))), _frame_size(frame_size) {
+    const unsigned index = ::if_nametoindex(interface.c_str());
+    if (index == 0) {
+        throw unix_error("if_nametoindex " + interface);
+    }
+
+    const tpacket_req3 rx_req = ring_request(RX_BLOCKS, frame_size, true);
+    const tpacket_req3 tx_req = ring_request(TX_BLOCKS, frame_size, false);
+    set_packet_option(fd_num(), "setsockopt PACKET_VERSION", PACKET_VERSION, int{TPACKET_V3});
+    set_packet_option(fd_num(), "setsockopt PACKET_RX_RING", PACKET_RX_RING, rx_req);
+    set_packet_option(fd_num(), "setsockopt PACKET_TX_RING", PACKET_TX_RING, tx_req);
+
+    _map_size = BLOCK_SIZE * (RX_BLOCKS + TX_BLOCKS);
+    _map = ::mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_num(), 0);
+    if (_map == MAP_FAILED) {
+        throw unix_error("mmap packet ring");
+    }
+    _rx = static_cast<char *>(_map);
+    _tx = _rx + BLOCK_SIZE * RX_BLOCKS;
+
+    // bind only now, so that nothing arrives before the ring is there to take it
+    sockaddr_ll address{};
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex = static_cast<int>(index);
+    SystemCall("bind", ::bind(fd_num(), reinterpret_cast<sockaddr *>(&address), sizeof(address)));
+}
+
+PacketRing::~PacketRing() {
+    try {
+        flush();
+    } catch (const exception &) {
+        // the interface may be gone
+    }
+    ::munmap(_map, _map_size);
+}
+
+//! \details Within a block, each frame is preceded by a tpacket3_hdr and the sockaddr_ll it came from;
+//! the ones this host sent (PACKET_OUTGOING) are skipped.
+size_t PacketRing::recv_frames(const function<void(string_view frame, bool check_sum)> &deliver) {
+    register_read();
+    size_t delivered = 0;
+    while (true) {
+        auto &block = *reinterpret_cast<tpacket_block_desc *>(_rx + BLOCK_SIZE * _rx_block);
+        if (not(load_status(block.hdr.bh1.block_status) & TP_STATUS_USER)) {
+            return delivered;
+        }
+
+        const char *packet = reinterpret_cast<char *>(&block) + block.hdr.bh1.offset_to_first_pkt;
+        for (uint32_t i = 0; i < block.hdr.bh1.num_pkts; i++) {
+            const auto &header = *reinterpret_cast<const tpacket3_hdr *>(packet);
+            const auto &from = *reinterpret_cast<const sockaddr_ll *>(packet + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+            if (from.sll_pkttype == PACKET_OUTGOING) {
+                _outgoing_skipped++;
+            } else {
+                deliver({packet + header.tp_mac, header.tp_snaplen},
+                        not(header.tp_status & (TP_STATUS_CSUMNOTREADY | TP_STATUS_CSUM_VALID)));
+                delivered++;
+            }
+            packet += header.tp_next_offset;
+        }
+
+        store_status(block.hdr.bh1.block_status, TP_STATUS_KERNEL);
+        _rx_block = (_rx_block + 1) % RX_BLOCKS;
+    }
+}
+
+char *PacketRing::_next_tx_frame() {
+    char *const slot = _tx + _frame_size * _tx_frame;
+    auto &header = *reinterpret_cast<tpacket3_hdr *>(slot);
+    if (load_status(header.tp_status) != TP_STATUS_AVAILABLE) {
+        // the ring has come round to frames not sent yet: send them, and wait until they are
+        flush();
+        SystemCall("send", ::send(fd_num(), nullptr, 0, 0));
+        if (load_status(header.tp_status) != TP_STATUS_AVAILABLE) {
+            throw runtime_error("PacketRing: transmit ring still full after sending it");
+        }
+    }
+    return slot;
+}
+
+void PacketRing::send_frame(const BufferViewList &frame) {
+    if (frame.size() + TX_DATA_OFFSET > _frame_size) {
+        throw runtime_error("PacketRing: frame of " + to_string(frame.size()) + " bytes does not fit the ring");
+    }
+
+    char *const slot = _next_tx_frame();
+    char *data = slot + TX_DATA_OFFSET;
+    for (const auto &iov : frame.as_iovecs()) {
+        memcpy(data, iov.iov_base, iov.iov_len);
+        data += iov.iov_len;
+    }
+
+    auto &header = *reinterpret_cast<tpacket3_hdr *>(slot);
+    header.tp_len = frame.size();
+    header.tp_snaplen = frame.size();
+    header.tp_next_offset = 0;
+    store_status(header.tp_status, TP_STATUS_SEND_REQUEST);
+
+    _tx_frame = (_tx_frame + 1) % (BLOCK_SIZE / _frame_size * TX_BLOCKS);
+    _tx_queued++;
+}
+
+void PacketRing::flush() {
+    register_write();
+    if (_tx_queued == 0) {
+        return;
+    }
+    _tx_queued = 0;
+    SystemCall("send", ::send(fd_num(), nullptr, 0, MSG_DONTWAIT));
+}
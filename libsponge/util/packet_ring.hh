@@ -0,0 +1,85 @@
+#ifndef SPONGE_LIBSPONGE_PACKET_RING_HH
+#define SPONGE_LIBSPONGE_PACKET_RING_HH
+
+#include "buffer.hh"
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+//! \brief A raw [packet(7)](\ref man7::packet) socket on one network interface, with TPACKET_V3 rings
+//! \details The kernel fills blocks of the memory-mapped receive ring with the frames that arrive, and
+//! hands over a block when it is full or a millisecond after its first frame; recv_frames() takes every
+//! frame of the blocks handed over, with no system call. Frames to send are copied into the transmit ring
+//! by send_frame(), and flush() sends all of them with one system call.
+//!
+//! The PacketRing is readable when a block is waiting, and writable when the transmit ring has room,
+//! so it can be watched by an EventLoop like any other FileDescriptor.
+class PacketRing : public FileDescriptor {
+  private:
+    size_t _frame_size;  //!< room for each frame in the transmit ring (and the rings' frame size)
+
+    void *_map{nullptr};  //!< the receive ring, followed by the transmit ring
+    size_t _map_size{0};
+
+    char *_rx{nullptr};     //!< first block of the receive ring
+    unsigned _rx_block{0};  //!< the block to take next
+
+    char *_tx{nullptr};      //!< first frame of the transmit ring
+    unsigned _tx_frame{0};   //!< the frame to fill next
+    unsigned _tx_queued{0};  //!< frames filled in since the last flush()
+
+    uint64_t _outgoing_skipped{0};  //!< frames sent from this interface by others, which recv_frames() skips
+
+    //! Wait until the frame to fill next is free (after flush() to send it)
+    char *_next_tx_frame();
+
+  public:
+    //! Size of each block of the rings
+    static constexpr size_t BLOCK_SIZE = 1 << 18;
+
+    //! Blocks in the receive ring
+    static constexpr size_t RX_BLOCKS = 16;
+
+    //! Blocks in the transmit ring
+    static constexpr size_t TX_BLOCKS = 4;
+
+    //! \brief Open a packet socket on interface `interface` (say, one end of a veth pair), for every protocol
+    //! \param[in] interface is the name of the interface
+    //! \param[in] frame_size is the room for each frame to send, which must exceed the largest (MTU + 14) by
+    //!            the ring's header; a power of two
+    //! \throws unix_error without CAP_NET_RAW, or if the interface doesn't exist
+    explicit PacketRing(const std::string &interface, const size_t frame_size = 2048);
+
+    ~PacketRing();
+
+    //! \brief Call `deliver` with each frame received, in order, and give their blocks back to the kernel
+    //! \details `check_sum` is false for frames from this host whose checksums were left to a device that
+    //! isn't there (as a veth does), or were already checked by the device.
+    //! \returns the number of frames delivered
+    size_t recv_frames(const std::function<void(std::string_view frame, bool check_sum)> &deliver);
+
+    //! \brief Copy a frame into the transmit ring, to be sent by flush()
+    //! \note If the ring is full, this sends what is queued and waits until the kernel is done with it.
+    void send_frame(const BufferViewList &frame);
+
+    //! \brief Send the frames queued by send_frame() with one system call
+    void flush();
+
+    //! \brief Frames sent by this host on the interface, which were seen and skipped by recv_frames()
+    uint64_t outgoing_skipped() const { return _outgoing_skipped; }
+
+    //! \name
+    //! A PacketRing owns its mapping, so it can't be copied or moved
+    //!@{
+    PacketRing(const PacketRing &other) = delete;
+    PacketRing &operator=(const PacketRing &other) = delete;
+    PacketRing(PacketRing &&other) = delete;
+    PacketRing &operator=(PacketRing &&other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_PACKET_RING_HH
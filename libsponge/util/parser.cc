@@ -31,12 +31,7 @@ T NetParser::_parse_int() {
         return 0;
     }
 
-    T ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret <<= 8;
-        ret += uint8_t(_buffer.at(i));
-    }
-
+    const T ret = load_field<T>(_buffer.str().data());
     _buffer.remove_prefix(len);
 
     return ret;
@@ -3,9 +3,13 @@
 
 #include "buffer.hh"
 
+#include <array>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 //! The result of parsing or unparsing an IP datagram, TCP segment, Ethernet frame, or ARP message
@@ -22,6 +26,102 @@ enum class ParseResult {
 //! Output a string representation of a ParseResult
 std::string as_string(const ParseResult r);
 
+//! \brief Read a field that may not be aligned: an unsigned integer in network byte order, or an array of bytes
+template <typename T>
+T load_field(const char *data) {
+    T value{};
+    std::memcpy(&value, data, sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (std::is_integral_v<T> and sizeof(T) == 2) {
+        return __builtin_bswap16(value);
+    } else if constexpr (std::is_integral_v<T> and sizeof(T) == 4) {
+        return __builtin_bswap32(value);
+    } else if constexpr (std::is_integral_v<T> and sizeof(T) == 8) {
+        return __builtin_bswap64(value);
+    }
+#endif
+    return value;
+}
+
+//! \brief Write a field that may not be aligned: an unsigned integer in network byte order, or an array of bytes
+template <typename T>
+void store_field(char *data, const T &value) {
+    T stored = value;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (std::is_integral_v<T> and sizeof(T) == 2) {
+        stored = __builtin_bswap16(value);
+    } else if constexpr (std::is_integral_v<T> and sizeof(T) == 4) {
+        stored = __builtin_bswap32(value);
+    } else if constexpr (std::is_integral_v<T> and sizeof(T) == 8) {
+        stored = __builtin_bswap64(value);
+    }
+#endif
+    std::memcpy(data, &stored, sizeof(T));
+}
+
+//! \brief The fields of a fixed-size header, one after another, whose offsets are worked out at compile time
+//! \details Each field is an unsigned integer in network byte order, or a std::array of bytes.
+template <typename... Fields>
+class HeaderLayout {
+  public:
+    //! The values of the fields, in order
+    using Values = std::tuple<Fields...>;
+
+    //! Size of the header
+    static constexpr size_t SIZE = (sizeof(Fields) + ... + 0);
+
+    //! Where each field starts
+    static constexpr std::array<size_t, sizeof...(Fields)> OFFSETS = [] {
+        std::array<size_t, sizeof...(Fields)> offsets{};
+        const std::array<size_t, sizeof...(Fields)> sizes{sizeof(Fields)...};
+        for (size_t i = 1; i < offsets.size(); i++) {
+            offsets[i] = offsets[i - 1] + sizes[i - 1];
+        }
+        return offsets;
+    }();
+
+    //! Read every field from `data`, which must hold #SIZE bytes
+    static Values load(const char *data) { return _load(data, std::index_sequence_for<Fields...>{}); }
+
+    //! Write every field to `data`, which must have room for #SIZE bytes
+    static void store(char *data, const Values &values) {
+        _store(data, values, std::index_sequence_for<Fields...>{});
+    }
+
+    //! \brief The sum of the header as 16-bit words in network byte order (to start an InternetChecksum with),
+    //! from the values of its fields rather than the bytes they were written to
+    //! \note The header must start at an even offset of what is checksummed.
+    static uint32_t sum(const Values &values) { return _sum(values, std::index_sequence_for<Fields...>{}); }
+
+  private:
+    template <size_t... I>
+    static Values _load(const char *data, std::index_sequence<I...>) {
+        return Values{load_field<Fields>(data + OFFSETS[I])...};
+    }
+
+    template <size_t... I>
+    static void _store(char *data, const Values &values, std::index_sequence<I...>) {
+        (store_field(data + OFFSETS[I], std::get<I>(values)), ...);
+    }
+
+    //! The sum of one field's bytes, each as the high or low byte of a word
+    template <typename T>
+    static uint32_t _field_sum(const T &value, const size_t offset) {
+        std::array<char, sizeof(T)> bytes{};
+        store_field(bytes.data(), value);
+        uint32_t sum = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            sum += uint32_t(uint8_t(bytes[i])) << ((offset + i) % 2 == 0 ? 8 : 0);
+        }
+        return sum;
+    }
+
+    template <size_t... I>
+    static uint32_t _sum(const Values &values, std::index_sequence<I...>) {
+        return (_field_sum(std::get<I>(values), OFFSETS[I]) + ... + 0);
+    }
+};
+
 class NetParser {
   private:
     Buffer _buffer;
@@ -60,6 +160,19 @@ class NetParser {
 
     //! Remove n bytes from the buffer
     void remove_prefix(const size_t n);
+
+    //! \brief Parse a fixed-size header laid out as `Layout` (a HeaderLayout), checking only once that it's there
+    //! \returns the values of its fields, or zeros if the data stream is too short
+    template <typename Layout>
+    typename Layout::Values fields() {
+        _check_size(Layout::SIZE);
+        if (error()) {
+            return {};
+        }
+        auto values = Layout::load(_buffer.str().data());
+        _buffer.remove_prefix(Layout::SIZE);
+        return values;
+    }
 };
 
 struct NetUnparser {
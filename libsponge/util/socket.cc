@@ -2,12 +2,21 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <netinet/udp.h>
 #include <stdexcept>
 #include <unistd.h>
 
 using namespace std;
 
+//! Room for the one control message of UDP GSO (a uint16_t) or GRO (an int), suitably aligned
+union GSOControl {
+    cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int))];
+};
+
 // default constructor for socket of (subclassed) domain and type
 //! \param[in] domain is as described in [socket(7)](\ref man7::socket), probably `AF_INET` or `AF_UNIX`
 //! \param[in] type is as described in [socket(7)](\ref man7::socket)
@@ -86,6 +95,10 @@ void Socket::shutdown(const int how) {
 
 //! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
 void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
+    if (_gro) {
+        throw runtime_error("UDPSocket::recv: with GRO enabled, use recv_many()");
+    }
+
     // receive source address and payload
     Address::Raw datagram_source_address;
     datagram.payload.resize(mtu);
@@ -141,6 +154,189 @@ void UDPSocket::send(const BufferViewList &payload) {
     register_write();
 }
 
+//! \param[out] datagrams receives the datagrams and the Addresses of their senders; elements past the
+//! returned count are left as they were, so the vector (and its strings' storage) can be reused
+//! \param[in] max_datagrams the most to receive (at most UDPSocket::MAX_BATCH)
+//! \param[in] mtu the largest datagram expected
+//! \note As with recv(), if `mtu` is too small to hold a received datagram this method throws a std::runtime_error
+size_t UDPSocket::recv_many(vector<received_datagram> &datagrams, const size_t max_datagrams, const size_t mtu) {
+    const size_t count = min(max_datagrams, MAX_BATCH);
+    if (count == 0) {
+        return 0;
+    }
+    if (_batch_buffer.size() < count * mtu) {
+        _batch_buffer.resize(count * mtu);
+    }
+
+    vector<Address::Raw> addresses(count);
+    vector<iovec> iovecs(count);
+    vector<mmsghdr> messages(count);
+    vector<GSOControl> controls(_gro ? count : 0);
+    for (size_t i = 0; i < count; i++) {
+        iovecs[i] = {_batch_buffer.data() + i * mtu, mtu};
+        messages[i].msg_hdr.msg_name = static_cast<sockaddr *>(addresses[i]);
+        messages[i].msg_hdr.msg_namelen = sizeof(addresses[i].storage);
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        if (_gro) {
+            messages[i].msg_hdr.msg_control = controls[i].buffer;
+            messages[i].msg_hdr.msg_controllen = sizeof(controls[i].buffer);
+        }
+    }
+
+    const auto received = static_cast<size_t>(SystemCall(
+        "recvmmsg", ::recvmmsg(fd_num(), messages.data(), count, MSG_WAITFORONE | MSG_TRUNC, nullptr)));
+    register_read();
+
+    size_t out = 0;
+    for (size_t i = 0; i < received; i++) {
+        msghdr &message = messages[i].msg_hdr;
+        const size_t length = messages[i].msg_len;
+        if (length > mtu or (message.msg_flags & MSG_TRUNC)) {
+            throw runtime_error("recvmmsg (oversized datagram)");
+        }
+
+        // with GRO, this may be several datagrams of `segment` bytes (the last maybe shorter)
+        size_t segment = length;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP and cmsg->cmsg_type == UDP_GRO) {
+                int gso_size = 0;
+                memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+                segment = gso_size > 0 ? static_cast<size_t>(gso_size) : length;
+            }
+        }
+
+        const Address source{addresses[i], message.msg_namelen};
+        size_t offset = 0;
+        do {
+            if (datagrams.size() <= out) {
+                datagrams.push_back({{nullptr, 0}, ""});
+            }
+            datagrams[out].source_address = source;
+            datagrams[out].payload.assign(_batch_buffer.data() + i * mtu + offset, min(segment, length - offset));
+            out++;
+            offset += segment;
+        } while (offset < length);
+    }
+    return out;
+}
+
+//! \param[in] destination the Address to send every datagram to
+//! \param[in] payloads the datagrams' payloads
+size_t UDPSocket::send_many(const Address &destination, const vector<BufferViewList> &payloads) {
+    size_t syscalls = 0;
+    for (size_t first = 0; first < payloads.size();) {
+        const size_t count = min(payloads.size() - first, MAX_BATCH);
+
+        vector<vector<iovec>> iovecs;
+        iovecs.reserve(count);
+        vector<mmsghdr> messages(count);
+        for (size_t i = 0; i < count; i++) {
+            iovecs.push_back(payloads[first + i].as_iovecs());
+            messages[i].msg_hdr.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(destination));
+            messages[i].msg_hdr.msg_namelen = destination.size();
+            messages[i].msg_hdr.msg_iov = iovecs.back().data();
+            messages[i].msg_hdr.msg_iovlen = iovecs.back().size();
+        }
+
+        // sendmmsg may stop early (e.g. when the send buffer fills up); go on from where it stopped
+        for (size_t sent = 0; sent < count;) {
+            const auto batch = static_cast<size_t>(
+                SystemCall("sendmmsg", ::sendmmsg(fd_num(), messages.data() + sent, count - sent, 0)));
+            syscalls++;
+            for (size_t i = sent; i < sent + batch; i++) {
+                if (messages[i].msg_len != payloads[first + i].size()) {
+                    throw runtime_error("datagram payload too big for sendmmsg()");
+                }
+            }
+            sent += batch;
+        }
+        first += count;
+    }
+    register_write();
+    return syscalls;
+}
+
+//! \details If the kernel doesn't know UDP_GRO (before Linux 5.0), nothing changes.
+bool UDPSocket::enable_gro() {
+    const int on = 1;
+    if (::setsockopt(fd_num(), SOL_UDP, UDP_GRO, &on, sizeof(on)) < 0) {
+        SystemCall("setsockopt", -1, ENOPROTOOPT);
+        return false;
+    }
+    _gro = true;
+    return true;
+}
+
+//! \details Linux has had UDP_SEGMENT since 4.18; asking for its value tells whether it's there.
+bool UDPSocket::gso_supported() const {
+    int segment = 0;
+    socklen_t len = sizeof(segment);
+    if (::getsockopt(fd_num(), SOL_UDP, UDP_SEGMENT, &segment, &len) < 0) {
+        SystemCall("getsockopt", -1, ENOPROTOOPT);
+        return false;
+    }
+    return true;
+}
+
+//! \param[in] destination the Address to send every datagram to
+//! \param[in] payloads the datagrams' payloads, in the order they are to be sent
+size_t UDPSocket::send_segmented(const Address &destination, const vector<BufferViewList> &payloads) {
+    // IPv4's largest UDP payload, which is as much as one sendmsg can carry
+    constexpr size_t max_gso_bytes = 65507;
+
+    size_t syscalls = 0;
+    for (size_t first = 0; first < payloads.size();) {
+        // the train: payloads the size of the first, and perhaps one shorter one to end it
+        const size_t segment = payloads[first].size();
+        size_t end = first + 1;
+        size_t total = segment;
+        while (segment > 0 and end < payloads.size() and end - first < MAX_GSO_SEGMENTS and
+               payloads[end].size() <= segment and total + payloads[end].size() <= max_gso_bytes) {
+            total += payloads[end].size();
+            end++;
+            if (payloads[end - 1].size() < segment) {
+                break;
+            }
+        }
+
+        if (end - first == 1) {
+            sendmsg_helper(fd_num(), destination, destination.size(), payloads[first]);
+        } else {
+            vector<iovec> iovecs;
+            for (size_t i = first; i < end; i++) {
+                const auto pieces = payloads[i].as_iovecs();
+                iovecs.insert(iovecs.end(), pieces.begin(), pieces.end());
+            }
+
+            GSOControl control{};
+            msghdr message{};
+            message.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(destination));
+            message.msg_namelen = destination.size();
+            message.msg_iov = iovecs.data();
+            message.msg_iovlen = iovecs.size();
+            message.msg_control = control.buffer;
+            message.msg_controllen = sizeof(control.buffer);
+
+            cmsghdr *const cmsg = CMSG_FIRSTHDR(&message);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const auto gso_size = static_cast<uint16_t>(segment);
+            memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+
+            const ssize_t bytes_sent = SystemCall("sendmsg", ::sendmsg(fd_num(), &message, 0));
+            if (static_cast<size_t>(bytes_sent) != total) {
+                throw runtime_error("short sendmsg() with UDP_SEGMENT");
+            }
+        }
+        syscalls++;
+        first = end;
+    }
+    register_write();
+    return syscalls;
+}
+
 // mark the socket as listening for incoming connections
 //! \param[in] backlog is the number of waiting connections to queue (see [listen(2)](\ref man2::listen))
 void TCPSocket::listen(const int backlog) { SystemCall("listen", ::listen(fd_num(), backlog)); }
@@ -166,3 +362,9 @@ void Socket::setsockopt(const int level, const int option, const option_type &op
 // allow local address to be reused sooner, at the cost of some robustness
 //! \note Using `SO_REUSEADDR` may reduce the robustness of your application
 void Socket::set_reuseaddr() { setsockopt(SOL_SOCKET, SO_REUSEADDR, int(true)); }
+
+//! \note The kernel caps the size at `net.core.rmem_max`.
+void Socket::set_receive_buffer_size(const int bytes) { setsockopt(SOL_SOCKET, SO_RCVBUF, bytes); }
+
+//! \note The kernel caps the size at `net.core.wmem_max`.
+void Socket::set_send_buffer_size(const int bytes) { setsockopt(SOL_SOCKET, SO_SNDBUF, bytes); }
@@ -8,6 +8,7 @@
 #include <functional>
 #include <string>
 #include <sys/socket.h>
+#include <vector>
 
 //! \brief Base class for network sockets (TCP, UDP, etc.)
 //! \details Socket is generally used via a subclass. See TCPSocket and UDPSocket for usage examples.
@@ -45,10 +46,21 @@ class Socket : public FileDescriptor {
 
     //! Allow local address to be reused sooner via [SO_REUSEADDR](\ref man7::socket)
     void set_reuseaddr();
+
+    //! Ask for a larger (or smaller) kernel receive buffer via [SO_RCVBUF](\ref man7::socket)
+    void set_receive_buffer_size(const int bytes);
+
+    //! Ask for a larger (or smaller) kernel send buffer via [SO_SNDBUF](\ref man7::socket)
+    void set_send_buffer_size(const int bytes);
 };
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
 class UDPSocket : public Socket {
+  private:
+    std::vector<char> _batch_buffer{};  //!< what recv_many() receives into, before copying out each payload
+
+    bool _gro{false};  //!< has enable_gro() succeeded?
+
   protected:
     //! \brief Construct from FileDescriptor (used by TCPOverUDPSocketAdapter)
     //! \param[in] fd is the FileDescriptor from which to construct
@@ -75,6 +87,37 @@ class UDPSocket : public Socket {
 
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
+
+    //! Most datagrams moved by one recv_many() or send_many() call
+    static constexpr size_t MAX_BATCH = 1024;
+
+    //! \brief Receive up to `max_datagrams` datagrams with one [recvmmsg(2)](\ref man2::recvmmsg)
+    //! \details Blocks until one datagram is available, then takes whatever else is already waiting.
+    //! \returns the number received, which are the first elements of `datagrams` (grown if needed); with GRO
+    //! enabled, each coalesced datagram counts as the datagrams it is split into, so this can exceed `max_datagrams`
+    size_t recv_many(std::vector<received_datagram> &datagrams, const size_t max_datagrams, const size_t mtu = 65536);
+
+    //! \brief Send every payload in `payloads` to `destination`, as many per [sendmmsg(2)](\ref man2::sendmmsg)
+    //! as it takes
+    //! \returns the number of system calls made
+    size_t send_many(const Address &destination, const std::vector<BufferViewList> &payloads);
+
+    //! \brief Have runs of equal-sized datagrams from one sender coalesced on receipt ([UDP_GRO](\ref man7::udp))
+    //! \returns `false` if the kernel doesn't support it
+    //! \note recv_many() splits what was coalesced back into datagrams; recv() can't, so it throws from now on.
+    bool enable_gro();
+
+    //! \brief Can the kernel split one send into equal-sized datagrams ([UDP_SEGMENT](\ref man7::udp))?
+    bool gso_supported() const;
+
+    //! Most datagrams one send_segmented() system call carries (the kernel's UDP_MAX_SEGMENTS)
+    static constexpr size_t MAX_GSO_SEGMENTS = 64;
+
+    //! \brief Send every payload in `payloads` to `destination` using UDP generic segmentation offload
+    //! \details Each run of equal-sized payloads (and a shorter one that ends it) goes in one sendmsg,
+    //! which the kernel splits into datagrams; any other payload is sent on its own.
+    //! \returns the number of system calls made
+    size_t send_segmented(const Address &destination, const std::vector<BufferViewList> &payloads);
 };
 
 //! \class UDPSocket
@@ -0,0 +1,152 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+#define SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+//! \brief An unbounded FIFO queue for one producer thread and one consumer thread, without locks
+//! \details It has the parts of the std::queue interface that a producer (push()) and a consumer
+//! (empty(), size(), front(), pop()) need; the two may run at the same time in different threads,
+//! but each of them in only one thread at a time.
+//!
+//! Elements live in a chain of segments of #SEGMENT_SIZE slots. The producer fills the last segment
+//! and chains on another when it is full; the consumer empties the first and hands it back for reuse
+//! when it is done with it, so a queue that is kept drained allocates nothing. A push() is published
+//! to the consumer by one release-store of the count of elements pushed, and a pop() to the producer
+//! by one of the count popped.
+//!
+//! Moving a queue is not thread-safe, and leaves the queue moved from empty.
+template <typename T>
+class SpscQueue {
+  public:
+    //! Slots per segment
+    static constexpr size_t SEGMENT_SIZE = 64;
+
+  private:
+    struct Segment {
+        std::array<T, SEGMENT_SIZE> slots{};
+        Segment *next{nullptr};
+    };
+
+    //! \name The consumer's end
+    //!@{
+    alignas(64) Segment *_head;
+    size_t _head_index{0};
+    std::atomic<uint64_t> _popped{0};
+    //!@}
+
+    //! \name The producer's end
+    //!@{
+    alignas(64) Segment *_tail;
+    size_t _tail_index{0};
+    std::atomic<uint64_t> _pushed{0};
+    //!@}
+
+    //! a segment the consumer is done with, for the producer to reuse
+    alignas(64) std::atomic<Segment *> _spare{nullptr};
+
+    //! Consumer: move past a segment emptied by pop()
+    void _next_head() {
+        Segment *const done = _head;
+        _head = done->next;
+        _head_index = 0;
+        Segment *no_spare = nullptr;
+        if (not _spare.compare_exchange_strong(no_spare, done, std::memory_order_release)) {
+            delete done;
+        }
+    }
+
+    //! Free every segment
+    void _release() {
+        while (_head != nullptr) {
+            delete std::exchange(_head, _head->next);
+        }
+        delete _spare.exchange(nullptr);
+    }
+
+  public:
+    //! An empty queue
+    SpscQueue() : _head(new Segment), _tail(_head) {}
+
+    ~SpscQueue() { _release(); }
+
+    //! \brief Producer: append an element
+    void push(T &&value) {
+        if (_tail_index == SEGMENT_SIZE) {
+            Segment *segment = _spare.exchange(nullptr, std::memory_order_acquire);
+            if (segment == nullptr) {
+                segment = new Segment;
+            }
+            segment->next = nullptr;
+            _tail->next = segment;
+            _tail = segment;
+            _tail_index = 0;
+        }
+        _tail->slots[_tail_index++] = std::move(value);
+        _pushed.store(_pushed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //! \brief Producer: append a copy of an element
+    void push(const T &value) { push(T{value}); }
+
+    //! \brief Consumer: is the queue empty? (The producer may add to it at any time.)
+    bool empty() const {
+        return _popped.load(std::memory_order_relaxed) == _pushed.load(std::memory_order_acquire);
+    }
+
+    //! \brief Number of elements (a snapshot, if the other thread is busy)
+    size_t size() const {
+        return _pushed.load(std::memory_order_acquire) - _popped.load(std::memory_order_acquire);
+    }
+
+    //! \brief Consumer: the first element, which may be moved from
+    //! \note As with std::queue, the queue must not be empty.
+    T &front() {
+        if (_head_index == SEGMENT_SIZE) {
+            _next_head();
+        }
+        return _head->slots[_head_index];
+    }
+
+    //! \brief Consumer: remove the first element
+    //! \note As with std::queue, the queue must not be empty.
+    void pop() {
+        front() = T{};  // release what it holds now, not when the slot is reused
+        _head_index++;
+        _popped.store(_popped.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //! \name
+    //! A queue can be moved (when no other thread is using it), but not copied
+    //!@{
+    SpscQueue(SpscQueue &&other) : SpscQueue() { swap(other); }
+
+    SpscQueue &operator=(SpscQueue &&other) {
+        SpscQueue taken{std::move(other)};
+        swap(taken);
+        return *this;
+    }
+
+    SpscQueue(const SpscQueue &other) = delete;
+    SpscQueue &operator=(const SpscQueue &other) = delete;
+    //!@}
+
+    //! \brief Exchange contents with another queue (when no other thread is using either)
+    void swap(SpscQueue &other) {
+        std::swap(_head, other._head);
+        std::swap(_head_index, other._head_index);
+        std::swap(_tail, other._tail);
+        std::swap(_tail_index, other._tail_index);
+        const uint64_t popped = _popped.exchange(other._popped.load());
+        other._popped.store(popped);
+        const uint64_t pushed = _pushed.exchange(other._pushed.load());
+        other._pushed.store(pushed);
+        Segment *const spare = _spare.exchange(other._spare.load());
+        other._spare.store(spare);
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_QUEUE_HH
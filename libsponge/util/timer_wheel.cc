@@ -0,0 +1,130 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+//! \param[in] entry the timer to file; its deadline must not be before the wheel's clock
+void TimerWheel::place(const Entry &entry) {
+    const uint64_t delta = entry.deadline - _now;
+    for (unsigned level = 0; level < LEVELS; level++) {
+        if (delta < (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            _levels[level][(entry.deadline >> (SLOT_BITS * level)) % SLOTS].push_back(entry);
+            _filed[level]++;
+            return;
+        }
+    }
+
+    // beyond the reach of the wheel: park it in the farthest slot of the top level, to be re-filed from there
+    constexpr unsigned top = LEVELS - 1;
+    const uint64_t farthest = _now + (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+    _levels[top][(farthest >> (SLOT_BITS * top)) % SLOTS].push_back(entry);
+    _filed[top]++;
+}
+
+//! \param[in] level the level of the slot (at least 1)
+//! \param[in] slot the index of the slot within its level
+void TimerWheel::cascade(const unsigned level, const size_t slot) {
+    Slot entries{};
+    swap(entries, _levels[level][slot]);
+    _filed[level] -= entries.size();
+    for (const auto &entry : entries) {
+        if (_callbacks.count(entry.id)) {
+            place(entry);
+        }
+    }
+}
+
+//! \param[in] slot the slot to search
+optional<uint64_t> TimerWheel::earliest_in(const Slot &slot) const {
+    optional<uint64_t> earliest{};
+    for (const auto &entry : slot) {
+        if (_callbacks.count(entry.id) and (not earliest.has_value() or entry.deadline < earliest.value())) {
+            earliest = entry.deadline;
+        }
+    }
+    return earliest;
+}
+
+//! \param[in] deadline when the timer should fire
+//! \param[in] callback what to do when it fires
+//! \returns a handle that can be passed to cancel()
+TimerWheel::TimerId TimerWheel::arm(const uint64_t deadline, CallbackT callback) {
+    const TimerId id = _next_id++;
+    _callbacks.emplace(id, move(callback));
+    place({id, max(deadline, _now + 1)});
+    return id;
+}
+
+//! \param[in] now the new time; advancing backwards does nothing
+void TimerWheel::advance(const uint64_t now) {
+    while (_now < now) {
+        if (_callbacks.empty()) {
+            // nothing can fire, so skip ahead and drop whatever cancelled entries are left
+            if (any_of(_filed.begin(), _filed.end(), [](const size_t filed) { return filed > 0; })) {
+                for (auto &level : _levels) {
+                    for (auto &slot : level) {
+                        slot.clear();
+                    }
+                }
+                _filed.fill(0);
+            }
+            _now = now;
+            return;
+        }
+
+        // with the lower levels empty, nothing happens until the lowest occupied level turns to its next slot
+        unsigned lowest = 0;
+        while (_filed[lowest] == 0) {
+            lowest++;
+        }
+        if (lowest > 0) {
+            const uint64_t last_quiet_ms = _now | ((uint64_t{1} << (SLOT_BITS * lowest)) - 1);
+            if (last_quiet_ms >= now) {
+                _now = now;
+                return;
+            }
+            _now = last_quiet_ms;
+        }
+
+        _now++;
+
+        // bring down the timers that are now in range of a lower level, from the top down
+        for (unsigned level = LEVELS - 1; level > 0; level--) {
+            if ((_now & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) == 0) {
+                cascade(level, (_now >> (SLOT_BITS * level)) % SLOTS);
+            }
+        }
+
+        Slot due{};
+        swap(due, _levels[0][_now % SLOTS]);
+        _filed[0] -= due.size();
+        for (const auto &entry : due) {
+            const auto it = _callbacks.find(entry.id);
+            if (it == _callbacks.end()) {
+                continue;
+            }
+            const CallbackT callback = move(it->second);
+            _callbacks.erase(it);
+            callback();
+        }
+    }
+}
+
+optional<uint64_t> TimerWheel::next_deadline() const {
+    optional<uint64_t> next{};
+    for (unsigned level = 0; level < LEVELS; level++) {
+        // the slots of a level hold consecutive spans of time, starting just after the current one
+        const uint64_t current = _now >> (SLOT_BITS * level);
+        for (size_t i = 1; i <= SLOTS; i++) {
+            const auto earliest = earliest_in(_levels[level][(current + i) % SLOTS]);
+            if (earliest.has_value()) {
+                if (not next.has_value() or earliest.value() < next.value()) {
+                    next = earliest;
+                }
+                break;
+            }
+        }
+    }
+    return next;
+}
@@ -0,0 +1,91 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: many one-shot timers, with O(1) arm and cancel
+//! \details Time is in milliseconds on a clock the owner chooses (e.g. timestamp_ms()).
+//! Level 0 has one slot per millisecond for the next #SLOTS ms; each level above covers
+//! #SLOTS times the span of the one below. A timer lives in the lowest level whose span covers
+//! its deadline, and moves down a level each time the wheel turns into its slot, so every timer
+//! is touched at most #LEVELS times before it fires. Deadlines further out than the top level
+//! reaches are parked in the top level and re-filed until they come into range.
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;                 //!< Handle for cancelling a timer
+    using CallbackT = std::function<void()>;  //!< Called when a timer fires
+
+    static constexpr unsigned SLOT_BITS = 6;                 //!< log2 of the slots per level
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;  //!< slots per level
+    static constexpr unsigned LEVELS = 4;                    //!< levels (together they span 2^24 ms, about 4.6 hours)
+
+  private:
+    struct Entry {
+        TimerId id;
+        uint64_t deadline;
+    };
+
+    using Slot = std::vector<Entry>;
+
+    //! the time up to which the wheel has been advanced
+    uint64_t _now;
+
+    //! id for the next timer to be armed
+    TimerId _next_id{1};
+
+    std::array<std::array<Slot, SLOTS>, LEVELS> _levels{};
+
+    //! entries (including cancelled ones) filed in each level, so advance() can skip over empty stretches
+    std::array<size_t, LEVELS> _filed{};
+
+    //! callbacks of armed timers; cancelling a timer only removes it from here, and the
+    //! stale Entry is dropped when the wheel reaches it
+    std::unordered_map<TimerId, CallbackT> _callbacks{};
+
+    //! File an entry under the level and slot for its deadline, relative to _now
+    void place(const Entry &entry);
+
+    //! Move the entries of one slot of an upper level down to where they now belong
+    void cascade(const unsigned level, const size_t slot);
+
+    //! Earliest deadline of an armed timer in `slot`, if it holds any
+    std::optional<uint64_t> earliest_in(const Slot &slot) const;
+
+  public:
+    //! Construct a wheel whose clock starts at `now`
+    explicit TimerWheel(const uint64_t now = 0) : _now(now) {}
+
+    //! \brief Arm a timer to fire at `deadline` (or at the next advance(), if that has already passed)
+    TimerId arm(const uint64_t deadline, CallbackT callback);
+
+    //! \brief Arm a timer to fire `delay` ms from now
+    TimerId arm_after(const uint64_t delay, CallbackT callback) { return arm(_now + delay, std::move(callback)); }
+
+    //! \brief Cancel an armed timer
+    //! \returns `false` if the timer has already fired or been cancelled
+    bool cancel(const TimerId id) { return _callbacks.erase(id) > 0; }
+
+    //! \brief Move the clock forward to `now`, firing every timer due by then in deadline order
+    //! \note Callbacks may arm and cancel timers.
+    void advance(const uint64_t now);
+
+    //! \brief When the earliest armed timer is due, or nothing if no timer is armed
+    std::optional<uint64_t> next_deadline() const;
+
+    //! \brief The time up to which the wheel has been advanced
+    uint64_t now() const { return _now; }
+
+    //! \brief Number of armed timers
+    size_t size() const { return _callbacks.size(); }
+
+    //! \brief Are no timers armed?
+    bool empty() const { return _callbacks.empty(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
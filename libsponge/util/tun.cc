@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
 #include <linux/if.h>
@@ -14,18 +15,27 @@ using namespace std;
 
 //! \param[in] devname is the name of the TUN or TAP device, specified at its creation.
 //! \param[in] is_tun is `true` for a TUN device (expects IP datagrams), or `false` for a TAP device (expects Ethernet frames)
+//! \param[in] multi_queue attaches a new queue of a multi-queue device (opening a device created without
+//!                        multiple queues this way fails with EINVAL)
+//! \param[in] vnet_hdr puts a VnetHeader before every packet
 //!
 //! To create a TUN device, you should already have run
 //!
 //!     ip tuntap add mode tun user `username` name `devname`
 //!
-//! as root before calling this function.
+//! as root before calling this function (adding `multi_queue` for a multi-queue device).
 
-TunTapFD::TunTapFD(const string &devname, const bool is_tun)
-    : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))) {
+TunTapFD::TunTapFD(const string &devname, const bool is_tun, const bool multi_queue, const bool vnet_hdr)
+    : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))), _vnet_hdr(vnet_hdr) {
     struct ifreq tun_req {};
 
     tun_req.ifr_flags = (is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI;  // tun device with no packetinfo
+    if (multi_queue) {
+        tun_req.ifr_flags |= IFF_MULTI_QUEUE;
+    }
+    if (vnet_hdr) {
+        tun_req.ifr_flags |= IFF_VNET_HDR;
+    }
 
     // copy devname to ifr_name, making sure to null terminate
 
@@ -33,4 +43,31 @@ TunTapFD::TunTapFD(const string &devname, const bool is_tun)
     tun_req.ifr_name[IFNAMSIZ - 1] = '\0';
 
     SystemCall("ioctl", ioctl(fd_num(), TUNSETIFF, static_cast<void *>(&tun_req)));
+
+    if (vnet_hdr) {
+        // the header is in the host's byte order unless asked otherwise (which little-endian hosts needn't)
+        int little_endian = 1;
+        SystemCall("ioctl", ioctl(fd_num(), TUNSETVNETLE, &little_endian), EINVAL);
+    }
+}
+
+//! \details With offload, the kernel may pass on TCP segments of up to 64 kB whose checksum it hasn't
+//! filled in (VnetHeader::FLAG_NEEDS_CSUM), or has checked already (VnetHeader::FLAG_DATA_VALID).
+//! A device opened with `vnet_hdr` accepts such packets from us either way.
+//!
+//! The setting belongs to the device, so it outlives this TunTapFD on a persistent device; a reader
+//! without `vnet_hdr` should turn it off.
+bool TunTapFD::set_offload(const bool enabled) {
+    if (enabled and not _vnet_hdr) {
+        return false;
+    }
+    const unsigned long offloads = enabled ? TUN_F_CSUM | TUN_F_TSO4 : 0;
+    return SystemCall("ioctl", ioctl(fd_num(), TUNSETOFFLOAD, offloads), EINVAL) == 0;
+}
+
+//! \param[in] enabled `false` detaches the queue, so the kernel sends its packets to the other queues
+void TunTapFD::set_queue_enabled(const bool enabled) {
+    struct ifreq queue_req {};
+    queue_req.ifr_flags = enabled ? IFF_ATTACH_QUEUE : IFF_DETACH_QUEUE;
+    SystemCall("ioctl", ioctl(fd_num(), TUNSETQUEUE, static_cast<void *>(&queue_req)));
 }
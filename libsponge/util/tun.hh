@@ -6,24 +6,48 @@
 #include <string>
 
 //! A FileDescriptor to a [Linux TUN/TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
+//! \details A device created with `multi_queue` has one queue per open TunTapFD. The kernel spreads the
+//! packets it sends to the device over the queues by flow, preferring the queue that last wrote a packet of
+//! the same flow, and any queue may write.
+//!
+//! Opened with `vnet_hdr`, every packet read or written starts with a (little-endian) VnetHeader, which
+//! lets packets carry partial checksums and large TCP segments in both directions (see set_offload()).
 class TunTapFD : public FileDescriptor {
+  private:
+    bool _vnet_hdr;
+
   public:
     //! Open an existing persistent [TUN or TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunTapFD(const std::string &devname, const bool is_tun);
+    explicit TunTapFD(const std::string &devname,
+                      const bool is_tun,
+                      const bool multi_queue = false,
+                      const bool vnet_hdr = false);
+
+    //! \brief Does every packet start with a VnetHeader?
+    bool vnet_hdr() const { return _vnet_hdr; }
+
+    //! \brief Ask for (or stop asking for) packets with partial checksums and large TCP segments
+    //! \returns `false` if offload was asked for on a device not opened with `vnet_hdr`, or the kernel refuses
+    bool set_offload(const bool enabled);
+
+    //! \brief Stop (or resume) receiving packets on this queue of a multi-queue device
+    void set_queue_enabled(const bool enabled);
 };
 
 //! A FileDescriptor to a [Linux TUN](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunFD : public TunTapFD {
   public:
     //! Open an existing persistent [TUN device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunFD(const std::string &devname) : TunTapFD(devname, true) {}
+    explicit TunFD(const std::string &devname, const bool multi_queue = false, const bool vnet_hdr = false)
+        : TunTapFD(devname, true, multi_queue, vnet_hdr) {}
 };
 
 //! A FileDescriptor to a [Linux TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TapFD : public TunTapFD {
   public:
     //! Open an existing persistent [TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TapFD(const std::string &devname) : TunTapFD(devname, false) {}
+    explicit TapFD(const std::string &devname, const bool multi_queue = false, const bool vnet_hdr = false)
+        : TunTapFD(devname, false, multi_queue, vnet_hdr) {}
 };
 
 #endif  // SPONGE_LIBSPONGE_TUN_HH
@@ -9,6 +9,7 @@ start_tap () {
     local TAPNUM="$1" TAPDEV="tap$1" LLADDR="02:B0:1D:FA:CE:"`printf "%02x" $1`
     ip tuntap add mode tap user "${SUDO_USER}" name "${TAPDEV}"
     ip link set "${TAPDEV}" address "${LLADDR}"
+    ip link set "${TAPDEV}" mtu "${TAP_MTU}"
 
     ip addr add "${TUN_IP_PREFIX}.${TAPNUM}.1/24" dev "${TAPDEV}"
     ip link set dev "${TAPDEV}" up
@@ -58,7 +59,7 @@ check_sudo () {
 
     if [ -z "$SUDO_USER" ]; then
         # if the user didn't call us with sudo, re-execute
-        exec sudo $0 "$MODE" "$@"
+        exec sudo TAP_MTU="${TAP_MTU}" $0 "$MODE" "$@"
     fi
 }
 
@@ -103,8 +104,10 @@ fi
 # sudo if necessary
 check_sudo "$@"
 
-# get configuration
+# get configuration (TAP_MTU may be set in the environment, e.g. to 9000 for jumbo frames)
+TAP_MTU_ENV="${TAP_MTU}"
 . "$(dirname "$0")"/etc/tunconfig
+TAP_MTU="${TAP_MTU_ENV:-${TAP_MTU}}"
 
 # start, stop, or restart all intfs
 eval "${MODE}_all" "$@"
@@ -0,0 +1,55 @@
+#ifndef SPONGE_TESTS_ALLOCATION_COUNTER_HH
+#define SPONGE_TESTS_ALLOCATION_COUNTER_HH
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+//! \brief Counts the allocations made from its construction until stop()
+//! \note This header replaces the global operator new, so a test program may include it from one file only.
+class AllocationCounter {
+    inline static bool _counting = false;
+    inline static size_t _allocations = 0;
+    inline static size_t _largest = 0;
+
+  public:
+    AllocationCounter() {
+        _allocations = 0;
+        _largest = 0;
+        _counting = true;
+    }
+
+    ~AllocationCounter() { stop(); }
+
+    //! Stop counting
+    void stop() { _counting = false; }
+
+    //! Number of allocations counted
+    size_t allocations() const { return _allocations; }
+
+    //! Size of the largest allocation counted
+    size_t largest() const { return _largest; }
+
+    //! Called by operator new with the size of each allocation
+    static void count(const size_t size) {
+        if (_counting) {
+            _allocations++;
+            _largest = std::max(_largest, size);
+        }
+    }
+};
+
+void *operator new(size_t size) {
+    AllocationCounter::count(size);
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+#endif  // SPONGE_TESTS_ALLOCATION_COUNTER_HH
@@ -0,0 +1,127 @@
+#include "datagram_ring.hh"
+#include "eventloop.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t depth = 8;
+static constexpr size_t mtu = 512;
+static constexpr size_t datagrams = 5 * depth;  // more than are ever posted, or in flight
+
+static string datagram_for(const size_t i) { return "datagram " + to_string(i) + string(i % 37, '.'); }
+
+//! Wait for the ring's completions and drain them with `take` until it returns false
+template <typename Take>
+static void receive_all(DatagramRing &ring, const Take &take) {
+    bool more = true;
+    EventLoop loop;
+    loop.add_rule(ring.fd(), Direction::In, [&] { more = take(); });
+    while (more) {
+        ring.flush();
+        if (loop.wait_next_event(1000) != EventLoop::Result::Success) {
+            throw runtime_error("timed out waiting for datagrams");
+        }
+    }
+}
+
+static void test_socket() {
+    UDPSocket ring_socket, peer;
+    ring_socket.bind(Address{"127.0.0.1", 0});
+    peer.bind(Address{"127.0.0.1", 0});
+    DatagramRing ring{ring_socket, DatagramRing::Kind::Socket, depth, mtu};
+
+    // one too big for the ring's buffers is dropped
+    peer.sendto(ring_socket.local_address(), string(mtu + 1, 'x'));
+    for (size_t i = 0; i < datagrams; i++) {
+        peer.sendto(ring_socket.local_address(), datagram_for(i));
+    }
+
+    size_t received = 0;
+    receive_all(ring, [&] {
+        while (auto datagram = ring.recv_datagram()) {
+            if (datagram->payload != datagram_for(received)) {
+                throw runtime_error("datagram " + to_string(received) + " was \"" + datagram->payload + "\"");
+            }
+            if (datagram->source_address != peer.local_address()) {
+                throw runtime_error("datagram from " + datagram->source_address.to_string());
+            }
+            received++;
+        }
+        return received < datagrams;
+    });
+
+    for (size_t i = 0; i < datagrams; i++) {
+        ring.sendto(peer.local_address(), datagram_for(i));
+    }
+    ring.flush();
+    for (size_t i = 0; i < datagrams; i++) {
+        const auto datagram = peer.recv();
+        if (datagram.payload != datagram_for(i) or datagram.source_address != ring_socket.local_address()) {
+            throw runtime_error("peer got \"" + datagram.payload + "\" from " + datagram.source_address.to_string());
+        }
+    }
+    if (ring.send_errors() != 0) {
+        throw runtime_error("sends failed");
+    }
+}
+
+//! A datagram socketpair keeps packet boundaries on read and write, like a TUN device
+static void test_device() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, static_cast<int *>(fds)));
+    FileDescriptor device{fds[0]}, other_end{fds[1]};
+    DatagramRing ring{device, DatagramRing::Kind::Device, depth, mtu};
+    if (not ring.fixed_buffers()) {
+        cerr << "the packet pool couldn't be registered; testing plain reads and writes\n";
+    }
+
+    for (size_t i = 0; i < datagrams; i++) {
+        ring.send(datagram_for(i));
+    }
+    ring.flush();
+    for (size_t i = 0; i < datagrams; i++) {
+        const string packet = other_end.read(mtu);
+        if (packet != datagram_for(i)) {
+            throw runtime_error("other end read \"" + packet + "\"");
+        }
+    }
+
+    for (size_t i = 0; i < datagrams; i++) {
+        other_end.write(datagram_for(i));
+    }
+    size_t received = 0;
+    receive_all(ring, [&] {
+        while (auto packet = ring.recv_packet()) {
+            if (packet.value() != datagram_for(received)) {
+                throw runtime_error("packet " + to_string(received) + " was \"" + packet.value() + "\"");
+            }
+            received++;
+        }
+        return received < datagrams;
+    });
+}
+
+int main() {
+    try {
+        if (not DatagramRing::available()) {
+            cerr << "io_uring is not available; skipping\n";
+            return EXIT_SUCCESS;
+        }
+        test_socket();
+        test_device();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
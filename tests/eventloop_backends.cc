@@ -0,0 +1,145 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+static string name_of(const EventLoop::Backend backend) {
+    switch (backend) {
+        case EventLoop::Backend::Poll:
+            return "poll";
+        case EventLoop::Backend::Epoll:
+            return "epoll";
+        case EventLoop::Backend::IoUring:
+            return "io_uring";
+    }
+    return "?";
+}
+
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(fds)));
+    return {FileDescriptor{fds[0]}, FileDescriptor{fds[1]}};
+}
+
+static void expect(const EventLoop::Result result, const EventLoop::Result expected, const string &what) {
+    if (result != expected) {
+        throw runtime_error(what + ": unexpected result from wait_next_event");
+    }
+}
+
+// every backend keeps the contract of Backend::Poll
+static void test_backend(const EventLoop::Backend backend) {
+    auto [read_end, write_end] = make_pipe();
+
+    // rules are level triggered: a byte that isn't read yet keeps its rule ready
+    {
+        EventLoop loop{backend};
+        string received;
+        size_t bytes_per_callback = 1;
+        bool reading = true;
+        bool cancelled = false;
+        loop.add_rule(
+            read_end,
+            Direction::In,
+            [&] { received += read_end.read(bytes_per_callback); },
+            [&] { return reading; },
+            [&] { cancelled = true; });
+
+        expect(loop.wait_next_event(10), EventLoop::Result::Timeout, "nothing to read");
+        write_end.write("ab");
+        expect(loop.wait_next_event(1000), EventLoop::Result::Success, "two bytes");
+        expect(loop.wait_next_event(1000), EventLoop::Result::Success, "one byte left");
+        if (received != "ab") {
+            throw runtime_error("read \"" + received + "\"");
+        }
+
+        // with no interested rule, there is nothing to wait for
+        reading = false;
+        write_end.write("c");
+        expect(loop.wait_next_event(1000), EventLoop::Result::Exit, "not interested");
+        reading = true;
+        expect(loop.wait_next_event(1000), EventLoop::Result::Success, "interested again");
+
+        // reading the end of the stream cancels the rule
+        write_end.close();
+        bytes_per_callback = 10;
+        expect(loop.wait_next_event(1000), EventLoop::Result::Success, "end of stream");
+        expect(loop.wait_next_event(1000), EventLoop::Result::Exit, "after end of stream");
+        if (received != "abc" or not cancelled) {
+            throw runtime_error("rule should have been cancelled at the end of the stream");
+        }
+    }
+
+    // a rule for writing is called when there is room
+    {
+        auto [other_read_end, other_write_end] = make_pipe();
+        EventLoop loop{backend};
+        loop.add_rule(other_write_end, Direction::Out, [&] { other_write_end.write("x"); });
+        expect(loop.wait_next_event(1000), EventLoop::Result::Success, "writable");
+        if (other_read_end.read(1) != "x") {
+            throw runtime_error("write rule didn't write");
+        }
+    }
+
+    // a hangup with nothing to read cancels a rule for reading
+    {
+        auto [other_read_end, other_write_end] = make_pipe();
+        EventLoop loop{backend};
+        bool cancelled = false;
+        loop.add_rule(
+            other_read_end,
+            Direction::In,
+            [&] { other_read_end.read(); },
+            [] { return true; },
+            [&] { cancelled = true; });
+        other_write_end.close();
+        expect(loop.wait_next_event(1000), EventLoop::Result::Success, "hangup");
+        expect(loop.wait_next_event(1000), EventLoop::Result::Exit, "after hangup");
+        if (not cancelled) {
+            throw runtime_error("rule should have been cancelled on hangup");
+        }
+    }
+
+    // a callback that doesn't read its ready fd would spin
+    {
+        auto [idle_read_end, idle_write_end] = make_pipe();
+        EventLoop loop{backend};
+        loop.add_rule(idle_read_end, Direction::In, [] {});
+        idle_write_end.write("x");
+        bool threw = false;
+        try {
+            loop.wait_next_event(1000);
+        } catch (const runtime_error &) {
+            threw = true;
+        }
+        if (not threw) {
+            throw runtime_error("busy wait should have been detected");
+        }
+    }
+}
+
+int main() {
+    try {
+        for (const auto backend : {EventLoop::Backend::Poll, EventLoop::Backend::Epoll, EventLoop::Backend::IoUring}) {
+            try {
+                test_backend(backend);
+            } catch (const exception &e) {
+                throw runtime_error(name_of(backend) + ": " + e.what());
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        cfg.ack_delay = 40;
+        auto rd = get_random_generator();
+
+        // test #1: every second full-sized in-order segment is ACKed right away
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string d1(TCPConfig::MAX_PAYLOAD_SIZE, 'a');
+            const string d2(TCPConfig::MAX_PAYLOAD_SIZE, 'b');
+            test_1.send_data(rx_isn + 1, tx_isn + 1, d1.begin(), d1.end());
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACKed the first segment immediately");
+
+            test_1.send_data(rx_isn + 1 + d1.size(), tx_isn + 1, d2.begin(), d2.end());
+            test_1.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 1 + d1.size() + d2.size()),
+                           "test 1 failed: no ACK after the second segment");
+            test_1.execute(ExpectData{}.with_data(d1 + d2));
+
+            if (test_1._fsm.acks_saved() != 1) {
+                throw runtime_error("test 1: expected one ACK saved, got " + to_string(test_1._fsm.acks_saved()));
+            }
+        }
+
+        // test #2: a lone segment is ACKed when the timer runs out
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string d1 = "lonely";
+            test_2.send_data(rx_isn + 1, tx_isn + 1, d1.begin(), d1.end());
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(Tick(cfg.ack_delay - 1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ACK sent before the delay ran out");
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 1 + d1.size()),
+                           "test 2 failed: no ACK after the delay ran out");
+
+            if (test_2._fsm.acks_saved() != 0) {
+                throw runtime_error("test 2: no ACK should have been saved");
+            }
+        }
+
+        // test #3: out-of-order data, and the data that fills the hole, are ACKed immediately
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string d1 = "abcd";
+            const string d2 = "efgh";
+            test_3.send_data(rx_isn + 1 + d1.size(), tx_isn + 1, d2.begin(), d2.end());
+            test_3.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 1),
+                           "test 3 failed: no duplicate ACK for out-of-order data");
+
+            test_3.send_data(rx_isn + 1, tx_isn + 1, d1.begin(), d1.end());
+            test_3.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 1 + d1.size() + d2.size()),
+                           "test 3 failed: no immediate ACK when the hole was filled");
+        }
+
+        // test #4: a pending ACK rides on outgoing data
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string d1 = "ping";
+            test_4.send_data(rx_isn + 1, tx_isn + 1, d1.begin(), d1.end());
+            test_4.execute(ExpectNoSegment{});
+            test_4.execute(Write{"pong"});
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + d1.size()).with_data("pong"),
+                           "test 4 failed: reply did not carry the ACK");
+            test_4.execute(Tick(cfg.ack_delay));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: ACK sent again after it was piggybacked");
+
+            if (test_4._fsm.acks_saved() != 1) {
+                throw runtime_error("test 4: expected one ACK saved, got " + to_string(test_4._fsm.acks_saved()));
+            }
+        }
+
+        // test #5: short segments wait for the timer, until they add up to two full-sized ones
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_5 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string d1 = "a";
+            for (size_t i = 0; i < 3; i++) {
+                test_5.send_data(rx_isn + 1 + i, tx_isn + 1, d1.begin(), d1.end());
+                test_5.execute(ExpectNoSegment{}, "test 5 failed: a 1-byte segment was ACKed right away");
+                test_5.execute(Tick(cfg.ack_delay / 4));
+            }
+            test_5.execute(Tick(cfg.ack_delay - 3 * (cfg.ack_delay / 4)));
+            test_5.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 4),
+                           "test 5 failed: no ACK when the delay of the first segment ran out");
+            test_5.execute(ExpectData{}.with_data("aaa"));
+
+            const string d2(2 * TCPConfig::MAX_PAYLOAD_SIZE - 2, 'b');
+            test_5.send_data(rx_isn + 4, tx_isn + 1, d1.begin(), d1.end());
+            test_5.execute(ExpectNoSegment{});
+            test_5.send_data(rx_isn + 5, tx_isn + 1, d2.begin(), d2.end());
+            test_5.execute(ExpectNoSegment{}, "test 5 failed: ACKed less than two full-sized segments");
+            test_5.send_data(rx_isn + 5 + d2.size(), tx_isn + 1, d1.begin(), d1.end());
+            test_5.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 6 + d2.size()),
+                           "test 5 failed: no ACK once two full-sized segments' worth had arrived");
+        }
+
+        // test #6: segments received together are all acknowledged by the ACK the first ones left queued
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_6 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            vector<SendSegment> batch;
+            string all_data;
+            for (const char c : {'a', 'b', 'c'}) {
+                string d(TCPConfig::MAX_PAYLOAD_SIZE, c);
+                batch.push_back(SendSegment{}
+                                    .with_ack(true)
+                                    .with_ackno(tx_isn + 1)
+                                    .with_seqno(rx_isn + 1 + all_data.size())
+                                    .with_win(TCPConfig::DEFAULT_CAPACITY)
+                                    .with_data(string(d)));
+                all_data += d;
+            }
+            test_6.execute(SendSegments{batch});
+            test_6.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 1 + all_data.size()),
+                           "test 6 failed: the ACK sent doesn't cover the whole batch");
+            test_6.execute(ExpectData{}.with_data(all_data));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
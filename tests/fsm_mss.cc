@@ -0,0 +1,114 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Connect with `cfg`, answer the SYN with a SYN/ACK advertising `peer_mss`, write a lot of data,
+//! and return the payload size of the first data segment
+static size_t first_segment_size(TCPConfig cfg, const optional<uint16_t> peer_mss, const bool peer_timestamps) {
+    auto rd = get_random_generator();
+    const WrappingInt32 tx_isn(rd());
+    const WrappingInt32 rx_isn(rd());
+    cfg.fixed_isn = tx_isn;
+
+    TCPTestHarness test(cfg);
+    test.execute(Connect{});
+    TCPSegment syn = test.expect_seg(ExpectOneSegment{}.with_syn(true), "no SYN after connect");
+    if (syn.header().mss != cfg.mss) {
+        throw runtime_error("SYN did not advertise the configured MSS");
+    }
+
+    SendSegment synack{};
+    synack.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1).with_win(60000);
+    if (peer_mss.has_value()) {
+        synack.with_mss(peer_mss.value());
+    }
+    if (peer_timestamps) {
+        synack.with_timestamps(1, syn.header().timestamps.value_or(TCPTimestamps{}).tsval);
+    }
+    test.execute(synack);
+    TCPSegment ack = test.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1), "no ACK for SYN/ACK");
+    if (ack.header().mss.has_value()) {
+        throw runtime_error("MSS option sent outside a SYN");
+    }
+
+    test.execute(Write{string(4 * TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+    return test.expect_seg(ExpectSegment{}.with_seqno(tx_isn + 1), "no data segment").payload().size();
+}
+
+static void expect_size(const string &what, const size_t expected, const size_t actual) {
+    if (expected != actual) {
+        throw runtime_error(what + ": expected " + to_string(expected) + "-byte segments, got " + to_string(actual));
+    }
+}
+
+int main() {
+    try {
+        // test #1: a SYN/ACK without the option leaves the segment size alone
+        expect_size("test 1", TCPConfig::MAX_PAYLOAD_SIZE, first_segment_size(TCPConfig{}, {}, false));
+
+        // test #2: the peer's smaller MSS wins
+        expect_size("test 2", 536, first_segment_size(TCPConfig{}, 536, false));
+
+        // test #3: our smaller MSS wins
+        {
+            TCPConfig cfg{};
+            cfg.mss = 1000;
+            expect_size("test 3", 1000, first_segment_size(cfg, 1452, false));
+        }
+
+        // test #4: a jumbo MSS is only used if the peer advertises one too
+        {
+            TCPConfig cfg{};
+            cfg.mss = TCPConfig::mss_for_mtu(TCPConfig::JUMBO_MTU);
+            expect_size("test 4a", TCPConfig::MAX_PAYLOAD_SIZE, first_segment_size(cfg, {}, false));
+            expect_size("test 4b", 1200, first_segment_size(cfg, 1200, false));
+        }
+
+        // test #5: the timestamps option comes out of the MSS
+        {
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            expect_size("test 5", 1200 - TCPHeader::TIMESTAMPS_LENGTH, first_segment_size(cfg, 1200, true));
+        }
+
+        // test #6: an MSS too small for any payload is raised to the smallest there can be, options and all
+        {
+            expect_size("test 6a", TCPConfig::MIN_MSS, first_segment_size(TCPConfig{}, 0, false));
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            expect_size(
+                "test 6b", TCPConfig::MIN_MSS - TCPHeader::TIMESTAMPS_LENGTH, first_segment_size(cfg, 10, true));
+        }
+
+        // test #7: no MSS fits an MTU too small for an IPv4 link
+        {
+            bool threw = false;
+            try {
+                TCPConfig::mss_for_mtu(TCPConfig::MIN_MTU - 1);
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            if (not threw) {
+                throw runtime_error("test 7: an MTU below 68 should have been refused");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
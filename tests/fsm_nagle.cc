@@ -0,0 +1,90 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test #1: with Nagle, a short segment waits while another short segment is in flight
+        {
+            TCPConfig cfg{};
+            cfg.nagle = true;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_1.execute(Write{"a"});
+            test_1.execute(ExpectOneSegment{}.with_seqno(tx_isn + 1).with_data("a"),
+                           "test 1 failed: first short write was held back");
+            test_1.execute(Write{"b"});
+            test_1.execute(Write{"c"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: short segment sent while data was in flight");
+
+            test_1.send_ack(rx_isn + 1, tx_isn + 2);
+            test_1.execute(ExpectOneSegment{}.with_seqno(tx_isn + 2).with_data("bc"),
+                           "test 1 failed: held data not sent when the ACK arrived");
+
+            // a full segment goes out regardless
+            test_1.send_ack(rx_isn + 1, tx_isn + 3, 60000);
+            test_1.execute(Write{string(TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            test_1.execute(ExpectOneSegment{}.with_seqno(tx_isn + 4).with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE),
+                           "test 1 failed: full segment was held back");
+        }
+
+        // test #2: while corked, only full segments go out; uncork() sends the rest
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            test_2.send_ack(rx_isn + 1, tx_isn + 1, 60000);
+
+            test_2.execute(Cork{});
+            test_2.execute(Write{"hello"});
+            test_2.execute(Write{" world"});
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: short segment sent while corked");
+
+            test_2.execute(Write{string(TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            test_2.execute(ExpectOneSegment{}.with_seqno(tx_isn + 1).with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE),
+                           "test 2 failed: full segment held back while corked");
+
+            test_2.execute(Uncork{});
+            test_2.execute(
+                ExpectOneSegment{}.with_seqno(tx_isn + 1 + TCPConfig::MAX_PAYLOAD_SIZE).with_payload_size(11),
+                           "test 2 failed: uncork did not flush");
+        }
+
+        // test #3: the end of the stream is never held back
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_3.execute(Cork{});
+            test_3.execute(Write{"bye"});
+            test_3.execute(ExpectNoSegment{});
+            test_3.execute(Close{});
+            test_3.execute(ExpectOneSegment{}.with_fin(true).with_data("bye"),
+                           "test 3 failed: corked data not sent on close");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static void check_timestamps(const TCPSegment &seg, const uint32_t tsecr, const string &what) {
+    if (not seg.header().timestamps.has_value()) {
+        throw runtime_error(what + ": segment is missing the timestamps option");
+    }
+    if (seg.header().timestamps->tsecr != tsecr) {
+        throw runtime_error(what + ": expected tsecr " + to_string(tsecr) + ", got " +
+                            to_string(seg.header().timestamps->tsecr));
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test #1: timestamps are negotiated on the SYNs and echoed from then on
+        {
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Connect{});
+            TCPSegment syn = test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false),
+                                               "test 1 failed: no SYN after connect");
+            check_timestamps(syn, 0, "test 1 SYN");
+
+            test_1.execute(Tick(5));
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(65000)
+                               .with_timestamps(1000, 0));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            TCPSegment ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1),
+                                               "test 1 failed: no ACK for SYN/ACK");
+            check_timestamps(ack, 1000, "test 1 ACK");
+
+            // outgoing data carries the option and leaves room for it in the segment
+            test_1.execute(Write{string(2 * TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            TCPSegment data = test_1.expect_seg(ExpectSegment{}.with_seqno(tx_isn + 1),
+                                                "test 1 failed: no data segment");
+            check_timestamps(data, 1000, "test 1 data");
+            if (data.payload().size() != TCPConfig::MAX_PAYLOAD_SIZE - TCPHeader::TIMESTAMPS_LENGTH) {
+                throw runtime_error("test 1: payload size did not account for the timestamps option");
+            }
+        }
+
+        // test #2: PAWS rejects a segment with an older TSval and re-ACKs
+        {
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Connect{});
+            test_2.execute(ExpectOneSegment{}.with_syn(true));
+            test_2.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_timestamps(2000, 0));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1));
+
+            test_2.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 1)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_data("abc")
+                               .with_timestamps(2010, 0));
+            TCPSegment ack = test_2.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4),
+                                               "test 2 failed: no ACK for in-order data");
+            check_timestamps(ack, 2010, "test 2 ACK");
+            test_2.execute(ExpectData{}.with_data("abc"));
+
+            // an old duplicate from an earlier incarnation of the sequence space
+            test_2.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 4)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_data("def")
+                               .with_timestamps(1500, 0));
+            ack = test_2.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4),
+                                    "test 2 failed: PAWS-rejected segment was not re-ACKed");
+            check_timestamps(ack, 2010, "test 2 re-ACK");
+            test_2.execute(ExpectNoData{}, "test 2 failed: PAWS-rejected data was delivered");
+        }
+
+        // test #3: a peer that offers timestamps does not get them unless configured
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 rx_isn(rd());
+
+            TCPTestHarness test_3 = TCPTestHarness::in_listen(cfg);
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_timestamps(77, 0));
+            TCPSegment synack = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                  "test 3 failed: no SYN/ACK");
+            if (synack.header().timestamps.has_value()) {
+                throw runtime_error("test 3: timestamps sent without being configured");
+            }
+        }
+
+        // test #4: without timestamps negotiated, the option is ignored: no PAWS, and nothing echoed
+        // (a: not configured; b: configured, but the peer's SYN/ACK didn't carry the option)
+        for (const bool configured : {false, true}) {
+            TCPConfig cfg{};
+            cfg.timestamps = configured;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_4(cfg);
+            test_4.execute(Connect{});
+            test_4.execute(ExpectOneSegment{}.with_syn(true));
+            SendSegment synack{};
+            synack.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1).with_win(1000);
+            if (not configured) {
+                synack.with_timestamps(2000, 0);
+            }
+            test_4.execute(synack);
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1));
+
+            for (const auto &[offset, data, tsval] : {make_tuple(1, "abc", 2010), make_tuple(4, "def", 1500)}) {
+                test_4.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_seqno(rx_isn + offset)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_win(1000)
+                                   .with_data(data)
+                                   .with_timestamps(tsval, 0));
+                TCPSegment ack = test_4.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + offset + 3),
+                                                   "test 4 failed: data with an older TSval was not ACKed");
+                if (ack.header().timestamps.has_value()) {
+                    throw runtime_error("test 4: timestamps sent without being negotiated");
+                }
+                test_4.execute(ExpectData{}.with_data(data));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test #1: a reader that reopens a closed window tells the sender at once, rather than leaving it to
+        // probe, but not while the window is still too small for a full segment
+        {
+            TCPConfig cfg{};
+            cfg.recv_capacity = 3000;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string d(1000, 'x');
+            for (size_t i = 0; i < 3; i++) {
+                test_1.send_data(rx_isn + 1 + i * d.size(), tx_isn + 1, d.begin(), d.end());
+                test_1.execute(ExpectOneSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(rx_isn + 1 + (i + 1) * d.size())
+                                   .with_win(cfg.recv_capacity - (i + 1) * d.size()),
+                               "test 1 failed: bad ACK of the data");
+            }
+
+            test_1.execute(Read{100});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: a window of 100 bytes is too small to update");
+
+            test_1.execute(Read{1400});
+            test_1.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 3001).with_win(1500),
+                           "test 1 failed: expected one window update, of 1500 bytes");
+
+            test_1.execute(Read{0});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: the window was updated already");
+        }
+
+        // test #2: the window update lets a sender that filled the window send again
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_2.send_ack(rx_isn + 1, tx_isn + 1, 3);
+            test_2.execute(Write{"hello"});
+            test_2.execute(ExpectOneSegment{}.with_seqno(tx_isn + 1).with_data("hel"),
+                           "test 2 failed: expected the window to be filled");
+            test_2.send_ack(rx_isn + 1, tx_isn + 4, 0);
+            test_2.execute(ExpectOneSegment{}.with_seqno(tx_isn + 4).with_data("l"),
+                           "test 2 failed: expected a one-byte probe of the closed window");
+
+            test_2.send_ack(rx_isn + 1, tx_isn + 5, 1500);
+            test_2.execute(ExpectOneSegment{}.with_seqno(tx_isn + 5).with_data("o"),
+                           "test 2 failed: the window update should have let the sender send again");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        using Layout = HeaderLayout<uint8_t, uint16_t, uint32_t, EthernetAddress, uint8_t>;
+        static_assert(Layout::SIZE == 14);
+        static_assert(Layout::OFFSETS[1] == 1 and Layout::OFFSETS[2] == 3 and Layout::OFFSETS[3] == 7 and
+                      Layout::OFFSETS[4] == 13);
+
+        // fields needn't be aligned, and are in network byte order
+        NetParser p{string{"\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f", 15}};
+        const auto [a, b, c, d, e] = p.fields<Layout>();
+        test_should_be(a, uint8_t{1});
+        test_should_be(b, uint16_t{0x0203});
+        test_should_be(c, uint32_t{0x04050607});
+        test_should_be((d == EthernetAddress{8, 9, 10, 11, 12, 13}), true);
+        test_should_be(e, uint8_t{14});
+        test_should_be(p.u8(), uint8_t{15});
+        test_should_be(p.error(), false);
+
+        // a header that isn't all there is an error, and is left for what follows
+        NetParser short_parser{string(13, 'x')};
+        short_parser.fields<Layout>();
+        test_should_be(short_parser.get_error() == ParseResult::PacketTooShort, true);
+        test_should_be(short_parser.buffer().size(), size_t{13});
+
+        // the headers read as they are written
+        EthernetHeader ethernet;
+        ethernet.dst = {1, 2, 3, 4, 5, 6};
+        ethernet.src = {7, 8, 9, 10, 11, 12};
+        ethernet.type = EthernetHeader::TYPE_ARP;
+        EthernetHeader ethernet_parsed;
+        NetParser ethernet_parser{ethernet.serialize()};
+        test_should_be(ethernet_parsed.parse(ethernet_parser) == ParseResult::NoError, true);
+        test_should_be(ethernet_parsed.to_string() == ethernet.to_string(), true);
+
+        ARPMessage arp;
+        arp.opcode = ARPMessage::OPCODE_REPLY;
+        arp.sender_ethernet_address = ethernet.src;
+        arp.sender_ip_address = 0x0a000002;
+        arp.target_ethernet_address = ethernet.dst;
+        arp.target_ip_address = 0x0a000001;
+        ARPMessage arp_parsed;
+        test_should_be(arp_parsed.parse(arp.serialize()) == ParseResult::NoError, true);
+        test_should_be(arp_parsed.to_string() == arp.to_string(), true);
+        string unsupported = arp.serialize();
+        unsupported[7] = 9;  // opcode
+        test_should_be(arp_parsed.parse(move(unsupported)) == ParseResult::Unsupported, true);
+
+        TCPHeader tcp;
+        tcp.sport = 1234;
+        tcp.dport = 80;
+        tcp.seqno = WrappingInt32{0x89abcdef};
+        tcp.ackno = WrappingInt32{0x01234567};
+        tcp.ack = tcp.psh = true;
+        tcp.win = 0xfedc;
+        tcp.uptr = 7;
+        TCPHeader tcp_parsed;
+        NetParser tcp_parser{tcp.serialize()};
+        test_should_be(tcp_parsed.parse(tcp_parser) == ParseResult::NoError, true);
+        test_should_be(tcp_parsed.to_string() == tcp.to_string(), true);
+
+        // headers written in place, with the checksums computed as they are written
+        tcp.mss = 1460;
+        tcp.timestamps = TCPTimestamps{0x01020304, 0x05060708};
+        tcp.doff = (TCPHeader::LENGTH + tcp.options_length()) / 4 + 1;  // and some padding
+        IPv4Datagram dgram;
+        dgram.header().src = 0x0a000001;
+        dgram.header().dst = 0x0a000002;
+        dgram.header().hlen = 6;  // with room for options
+        dgram.header().len = 4 * dgram.header().hlen + 4 * tcp.doff + 3;
+        TCPSegment seg;
+        seg.header() = tcp;
+        seg.payload() = string{"odd"};
+        dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+
+        const string serialized = dgram.serialize().concatenate();
+        InternetChecksum ip_check;
+        ip_check.add(string_view{serialized}.substr(0, 4 * dgram.header().hlen));
+        test_should_be(ip_check.value(), uint16_t{0});
+        InternetDatagram dgram_parsed;
+        test_should_be(dgram_parsed.parse(string{serialized}) == ParseResult::NoError, true);
+        TCPSegment seg_parsed;
+        test_should_be(seg_parsed.parse(dgram_parsed.payload().concatenate(), dgram.header().pseudo_cksum()) ==
+                           ParseResult::NoError,
+                       true);
+        test_should_be(seg_parsed.header().mss.value(), uint16_t{1460});
+        test_should_be(seg_parsed.header().timestamps->tsecr, uint32_t{0x05060708});
+        test_should_be(seg_parsed.payload().copy() == "odd", true);
+
+        string too_small(TCPHeader::LENGTH, 0);
+        bool threw = false;
+        try {
+            tcp.serialize_into(too_small.data(), too_small.size(), 0);
+        } catch (const runtime_error &) {
+            threw = true;
+        }
+        test_should_be(threw, true);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
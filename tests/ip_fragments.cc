@@ -0,0 +1,189 @@
+#include "fragment_reassembler.hh"
+#include "network_interface_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static const EthernetAddress sender_eth{0x02, 0, 0, 0, 0, 1};
+static const EthernetAddress receiver_eth{0x02, 0, 0, 0, 0, 2};
+static const Address sender_ip{"10.0.0.1", 0};
+static const Address receiver_ip{"10.0.0.2", 0};
+
+//! A datagram from the sender to the receiver, with a payload of `size` bytes that differ from their neighbors
+static InternetDatagram patterned_datagram(const uint16_t id, const size_t size) {
+    InternetDatagram dgram = make_datagram(sender_ip.ip(), receiver_ip.ip());
+    dgram.header().proto = IPv4Header::PROTO_TCP;
+    dgram.header().id = id;
+    dgram.header().df = false;
+    string payload(size, 0);
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = char(i * 7 + i / 251);
+    }
+    dgram.payload() = move(payload);
+    dgram.header().len = dgram.header().hlen * 4 + size;
+    return dgram;
+}
+
+//! The sender, with MTU `mtu`, which knows the receiver's Ethernet address
+static NetworkInterfaceTestHarness make_sender(const size_t mtu) {
+    NetworkInterfaceTestHarness sender{"sender with MTU " + to_string(mtu), sender_eth, sender_ip, mtu};
+    sender.execute(ReceiveFrame{
+        make_frame(receiver_eth,
+                   sender_eth,
+                   EthernetHeader::TYPE_ARP,
+                   make_arp(ARPMessage::OPCODE_REPLY, receiver_eth, receiver_ip.ip(), sender_eth, sender_ip.ip())
+                       .serialize()),
+        {}});
+    return sender;
+}
+
+//! Send `dgram` from a sender with MTU `mtu`, and take the frames it sends
+static vector<EthernetFrame> send(const InternetDatagram &dgram, const size_t mtu) {
+    NetworkInterfaceTestHarness sender = make_sender(mtu);
+    sender.execute(SendDatagram{dgram, receiver_ip});
+    vector<EthernetFrame> frames;
+    for (auto &frames_out = sender.interface().frames_out(); not frames_out.empty(); frames_out.pop()) {
+        frames.push_back(wire(frames_out.front()));
+    }
+    return frames;
+}
+
+//! The datagram in a frame
+static InternetDatagram datagram_of(const EthernetFrame &frame) {
+    InternetDatagram dgram;
+    if (dgram.parse(Buffer(frame.payload())) != ParseResult::NoError) {
+        throw runtime_error("datagram did not parse");
+    }
+    return dgram;
+}
+
+int main() {
+    try {
+        // a datagram sized for a jumbo MTU is sent in fragments that fit a standard one
+        {
+            const InternetDatagram original = patterned_datagram(1, 8980);
+            const vector<EthernetFrame> frames = send(original, 1500);
+            test_should_be(frames.size(), size_t{7});
+            for (size_t i = 0; i < frames.size(); i++) {
+                const IPv4Header header = datagram_of(frames[i]).header();
+                test_should_be(size_t{header.offset}, i * 1480 / 8);
+                test_should_be(header.mf, i + 1 < frames.size());
+                test_should_be(size_t{header.len}, i + 1 < frames.size() ? 1500 : 20 + 8980 - 6 * size_t{1480});
+                test_should_be(header.id, uint16_t{1});
+            }
+
+            // ... and put back together by the receiver, in whatever order they arrive
+            NetworkInterfaceTestHarness receiver{"receiver putting fragments together", receiver_eth, receiver_ip};
+            for (size_t i = frames.size(); i-- > 1;) {
+                receiver.execute(ReceiveFrame{frames[i], {}});
+                test_should_be(receiver.interface().fragments().pending(), size_t{1});
+            }
+            receiver.execute(ReceiveFrame{frames[0], original});
+            test_should_be(receiver.interface().fragments().pending(), size_t{0});
+            test_should_be(receiver.interface().fragments().bytes(), size_t{0});
+            test_should_be(receiver.interface().time_until_next_event().has_value(), false);
+
+            // a fragment that fits is sent as it is, and one that doesn't is cut up again, keeping its place
+            const InternetDatagram fragment = datagram_of(frames[1]);
+            test_should_be(send(fragment, 1500).size(), size_t{1});
+            const vector<EthernetFrame> refragmented = send(fragment, 576);
+            test_should_be(refragmented.size(), size_t{3});
+            test_should_be(datagram_of(refragmented[0]).header().offset, uint16_t{1480 / 8});
+            test_should_be(datagram_of(refragmented[2]).header().offset, uint16_t{(1480 + 2 * 552) / 8});
+            test_should_be(datagram_of(refragmented[2]).header().mf, true);
+        }
+
+        // a datagram marked "don't fragment" that doesn't fit is dropped
+        {
+            NetworkInterfaceTestHarness sender = make_sender(1500);
+            InternetDatagram dgram = patterned_datagram(2, 2000);
+            dgram.header().df = true;
+            sender.execute(SendDatagram{dgram, receiver_ip});
+            sender.execute(ExpectNoFrame{});
+            test_should_be(sender.interface().too_big(), uint64_t{1});
+        }
+
+        // fragments of a datagram for another address are left for a router to forward
+        {
+            const vector<EthernetFrame> frames = send(patterned_datagram(3, 3000), 1500);
+            NetworkInterfaceTestHarness router{"router forwarding fragments", receiver_eth, Address{"10.0.0.254", 0}};
+            router.execute(ReceiveFrame{frames[0], datagram_of(frames[0])});
+            test_should_be(router.interface().fragments().pending(), size_t{0});
+        }
+
+        // a datagram still missing a fragment is given up on
+        {
+            const vector<EthernetFrame> frames = send(patterned_datagram(4, 3000), 1500);
+            NetworkInterfaceTestHarness receiver{"receiver missing a fragment", receiver_eth, receiver_ip};
+            receiver.execute(ReceiveFrame{frames[0], {}});
+            receiver.execute(ReceiveFrame{frames[2], {}});
+            test_should_be(receiver.interface().time_until_next_event().value(),
+                           size_t{FragmentReassembler::TIMEOUT});
+            receiver.execute(Tick{FragmentReassembler::TIMEOUT - 1});
+            test_should_be(receiver.interface().fragments().pending(), size_t{1});
+            receiver.execute(Tick{1});
+            test_should_be(receiver.interface().fragments().pending(), size_t{0});
+            test_should_be(receiver.interface().fragments().drops().timed_out, uint64_t{1});
+            receiver.execute(ReceiveFrame{frames[1], {}});
+        }
+
+        // the oldest incomplete datagram makes room for a newer one
+        {
+            FragmentReassembler reassembler;
+            for (size_t id = 0; id <= FragmentReassembler::MAX_DATAGRAMS; id++) {
+                InternetDatagram first = patterned_datagram(id, 8);
+                first.header().mf = true;
+                test_should_be(reassembler.add(first, id).has_value(), false);
+            }
+            test_should_be(reassembler.pending(), FragmentReassembler::MAX_DATAGRAMS);
+            test_should_be(reassembler.drops().evicted, uint64_t{1});
+            test_should_be(reassembler.next_expiry().value(), 1 + FragmentReassembler::TIMEOUT);
+
+            // fragments that can't be part of a datagram are dropped
+            InternetDatagram odd = patterned_datagram(1000, 9);
+            odd.header().mf = true;
+            test_should_be(reassembler.add(odd, 0).has_value(), false);
+            InternetDatagram past_the_end = patterned_datagram(1000, 8);
+            past_the_end.header().offset = 8189;
+            test_should_be(reassembler.add(past_the_end, 0).has_value(), false);
+            test_should_be(reassembler.drops().malformed, uint64_t{2});
+
+            // as is the rest of a datagram whose last fragments disagree
+            InternetDatagram last = patterned_datagram(1, 8);
+            last.header().offset = 2;
+            test_should_be(reassembler.add(last, 0).has_value(), false);
+            last.header().offset = 3;
+            test_should_be(reassembler.add(last, 0).has_value(), false);
+            test_should_be(reassembler.drops().malformed, uint64_t{3});
+            test_should_be(reassembler.pending(), FragmentReassembler::MAX_DATAGRAMS - 1);
+        }
+
+        // a short datagram parses without the padding of its frame, up to the minimum of 46 bytes of payload
+        {
+            const InternetDatagram short_datagram = patterned_datagram(5, 6);
+            const vector<EthernetFrame> frames = send(short_datagram, 1500);
+            test_should_be(frames.size(), size_t{1});
+            EthernetFrame padded;
+            test_should_be(padded.parse(Buffer{frames[0].serialize().concatenate() + string(20, 0)}) ==
+                               ParseResult::NoError,
+                           true);
+            test_should_be(padded.payload().size(), size_t{46});
+            NetworkInterfaceTestHarness receiver{"receiver of a padded frame", receiver_eth, receiver_ip};
+            receiver.execute(ReceiveFrame{padded, short_datagram});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
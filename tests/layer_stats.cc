@@ -0,0 +1,212 @@
+#include "network_interface_test_harness.hh"
+#include "router.hh"
+#include "tcp_connection.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static const EthernetAddress local_eth{0x02, 0, 0, 0, 0, 1};
+static const EthernetAddress remote_eth{0x02, 0, 0, 0, 0, 2};
+static const Address local_ip{"10.0.0.1", 0};
+static const Address remote_ip{"10.0.0.2", 0};
+
+static TCPSegment make_segment(const uint32_t seqno, const string &payload) {
+    TCPSegment seg;
+    seg.header().seqno = WrappingInt32{seqno};
+    seg.payload() = string{payload};
+    return seg;
+}
+
+//! A datagram from the local host, with 100 bytes of payload
+static InternetDatagram outgoing_datagram(const Address &dst, const uint8_t ttl) {
+    InternetDatagram dgram = make_datagram(local_ip.ip(), dst.ip());
+    dgram.header().ttl = ttl;
+    dgram.payload() = string(100, 'x');
+    dgram.header().len = dgram.header().hlen * 4 + 100;
+    return dgram;
+}
+
+//! The remote host's ARP reply to the local one
+static EthernetFrame arp_reply() {
+    return make_frame(
+        remote_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        make_arp(ARPMessage::OPCODE_REPLY, remote_eth, remote_ip.ip(), local_eth, local_ip.ip()).serialize());
+}
+
+//! A frame carrying `dgram` from the remote host to `dst`
+static EthernetFrame from_remote(const EthernetAddress &dst, const InternetDatagram &dgram) {
+    return make_frame(remote_eth, dst, EthernetHeader::TYPE_IPv4, dgram.serialize());
+}
+
+int main() {
+    try {
+        // the sender counts what it sends, what it sends again, and the ACKs that tell it nothing
+        {
+            TCPSender sender{4000, 1000, WrappingInt32{0}};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 1000);
+            sender.stream_in().write("hello");
+            sender.fill_window();
+            test_should_be(sender.stats().segments_sent, uint64_t{2});
+            test_should_be(sender.stats().bytes_sent, uint64_t{5});
+
+            sender.ack_received(WrappingInt32{1}, 1000);
+            test_should_be(sender.stats().dup_acks, uint64_t{1});
+            sender.ack_received(WrappingInt32{1}, 2000);  // a window update isn't a duplicate
+            test_should_be(sender.stats().dup_acks, uint64_t{1});
+            sender.ack_received(WrappingInt32{100}, 1000);
+            test_should_be(sender.stats().invalid_acks, uint64_t{1});
+
+            sender.tick(1000);
+            test_should_be(sender.stats().retransmissions, uint64_t{1});
+            test_should_be(sender.stats().bytes_retransmitted, uint64_t{5});
+            sender.send_empty_segment();
+            test_should_be(sender.stats().segments_sent, uint64_t{4});
+        }
+
+        // the receiver counts the bytes that fall in its window, and the segments it refuses
+        {
+            TCPReceiver receiver{10};
+            TCPSegment syn = make_segment(0, "");
+            syn.header().syn = true;
+            receiver.segment_received(syn);
+            receiver.segment_received(make_segment(3, "cd"));
+            receiver.segment_received(make_segment(1, "ab"));
+            receiver.segment_received(make_segment(50, "zz"));
+            test_should_be(receiver.stats().segments_received, uint64_t{4});
+            test_should_be(receiver.stats().bytes_received, uint64_t{4});
+            test_should_be(receiver.stats().unacceptable, uint64_t{1});
+        }
+
+        // the connection's snapshot holds its sender's and receiver's counts, and its own
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPConnection conn{cfg};
+            const auto drain = [&conn] {
+                for (auto &segments = conn.segments_out(); not segments.empty(); segments.pop()) {
+                }
+            };
+            conn.connect();
+            drain();
+
+            TCPSegment syn_ack = make_segment(100, "");
+            syn_ack.header().syn = true;
+            syn_ack.header().ack = true;
+            syn_ack.header().ackno = WrappingInt32{1};
+            syn_ack.header().win = 1000;
+            conn.segment_received(syn_ack);
+            drain();
+            conn.write("hello");
+            drain();
+            test_should_be(conn.unassembled_bytes(), size_t{0});
+
+            TCPConnection::Stats stats = conn.stats();
+            test_should_be(stats.segments_received, uint64_t{1});
+            test_should_be(stats.segments_sent, uint64_t{3});  // SYN, ACK and data
+            test_should_be(stats.bytes_in_flight, size_t{5});
+            test_should_be(stats.sender.bytes_sent, uint64_t{5});
+            test_should_be(stats.receiver.segments_received, uint64_t{1});
+
+            TCPSegment rst = make_segment(101, "");
+            rst.header().rst = true;
+            conn.segment_received(rst);
+            stats = conn.stats();
+            test_should_be(stats.resets_received, uint64_t{1});
+            test_should_be(stats.resets_sent, uint64_t{0});
+            test_should_be(conn.active(), false);
+        }
+
+        // the interface counts frames, bytes, and ARP hits and misses
+        {
+            NetworkInterfaceTestHarness test{"interface counters", local_eth, local_ip};
+            const InternetDatagram outgoing = outgoing_datagram(remote_ip, 64);
+            test.execute(SendDatagram{outgoing, remote_ip});
+            test.execute(ExpectFrame{make_frame(
+                local_eth,
+                ETHERNET_BROADCAST,
+                EthernetHeader::TYPE_ARP,
+                make_arp(ARPMessage::OPCODE_REQUEST, local_eth, local_ip.ip(), {}, remote_ip.ip()).serialize())});
+            NetworkInterface::Stats stats = test.interface().stats();
+            test_should_be(stats.datagrams_sent, uint64_t{1});
+            test_should_be(stats.arp_misses, uint64_t{1});
+            test_should_be(stats.arp_requests_sent, uint64_t{1});
+            test_should_be(stats.frames_sent, uint64_t{1});
+            test_should_be(stats.pending, size_t{1});
+
+            const EthernetFrame to_remote =
+                make_frame(local_eth, remote_eth, EthernetHeader::TYPE_IPv4, outgoing.serialize());
+            test.execute(ReceiveFrame{arp_reply(), {}});
+            test.execute(ExpectFrame{to_remote});
+            test.execute(SendDatagram{outgoing, remote_ip});
+            test.execute(ExpectFrame{to_remote});
+            const InternetDatagram incoming = outgoing_datagram(local_ip, 64);
+            test.execute(ReceiveFrame{from_remote(local_eth, incoming), incoming});
+            test.execute(ReceiveFrame{from_remote({0x02, 0, 0, 0, 0, 9}, incoming), {}});
+            stats = test.interface().stats();
+            test_should_be(stats.arp_hits, uint64_t{1});
+            test_should_be(stats.frames_sent, uint64_t{3});
+            test_should_be(stats.bytes_sent, uint64_t{28 + 2 * 120});
+            test_should_be(stats.frames_received, uint64_t{2});
+            test_should_be(stats.frames_ignored, uint64_t{1});
+            test_should_be(stats.datagrams_received, uint64_t{1});
+            test_should_be(stats.pending, size_t{0});
+        }
+
+        // the router counts what it routes and drops, with route() or with workers
+        {
+            Router router;
+            router.add_interface({local_eth, local_ip});
+            router.add_interface({local_eth, Address{"10.0.1.1", 0}});
+            router.add_route(0x0a000000, 24, {}, 0);
+            router.add_route(0x0a000100, 24, {}, 1);
+            router.interface(0).recv_frame(arp_reply());
+
+            const InternetDatagram routed = outgoing_datagram(remote_ip, 64);
+            const InternetDatagram expiring = outgoing_datagram(remote_ip, 1);
+            const InternetDatagram unroutable = outgoing_datagram(Address{"192.168.0.1", 0}, 64);
+            for (const auto *dgram : {&routed, &expiring, &unroutable}) {
+                router.interface(1).recv_frame(from_remote(local_eth, *dgram));
+            }
+            router.route();
+            Router::Stats stats = router.stats();
+            test_should_be(stats.routed, uint64_t{1});
+            test_should_be(stats.ttl_expired, uint64_t{1});
+            test_should_be(stats.no_route, uint64_t{1});
+            test_should_be(stats.route_lookups, uint64_t{2});
+            test_should_be(stats.interfaces.frames_received, uint64_t{4});
+            test_should_be(stats.interfaces.arp_hits, uint64_t{1});
+
+            router.start(2);
+            router.deliver_frame(1, from_remote(local_eth, routed));
+            bool threw = false;
+            try {
+                router.stats();
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_should_be(threw, true);
+            router.stop();
+            stats = router.stats();
+            test_should_be(stats.routed, uint64_t{2});
+            test_should_be(stats.handoffs, uint64_t{1});
+            test_should_be(stats.interfaces.frames_sent, uint64_t{2});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "neighbor_table.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+
+using namespace std;
+
+static EthernetAddress ethernet_for(const uint32_t ip) {
+    return {0x02, 0, uint8_t(ip >> 24), uint8_t(ip >> 16), uint8_t(ip >> 8), uint8_t(ip)};
+}
+
+int main() {
+    try {
+        // entries last until their expiry time, which renewing them moves
+        {
+            NeighborTable table;
+            table.insert(1, ethernet_for(1), 100);
+            table.insert(2, ethernet_for(2), 200);
+            test_should_be(table.size(), size_t{2});
+            test_should_be(table.next_expiry().value(), uint64_t{100});
+            test_should_be(table.lookup(1, 99).value() == ethernet_for(1), true);
+            test_should_be(table.lookup(3, 99).has_value(), false);
+
+            table.insert(1, ethernet_for(7), 300);
+            test_should_be(table.size(), size_t{2});
+            test_should_be(table.expire(150), size_t{0});  // the old expiry time is stale
+            test_should_be(table.lookup(1, 150).value() == ethernet_for(7), true);
+
+            test_should_be(table.expire(200), size_t{1});
+            test_should_be(table.lookup(2, 200).has_value(), false);
+            test_should_be(table.next_expiry().value(), uint64_t{300});
+
+            // lookup() doesn't return an entry past its expiry time, even before expire() removes it
+            test_should_be(table.lookup(1, 300).has_value(), false);
+            test_should_be(table.empty(), true);
+            test_should_be(table.next_expiry().has_value(), false);
+            test_should_be(table.expire(1000), size_t{0});
+        }
+
+        // against std::map, with enough entries to grow and deletions all over the probe sequences
+        {
+            NeighborTable table;
+            map<uint32_t, pair<EthernetAddress, uint64_t>> reference;
+            mt19937 rd{1};
+            uint64_t now = 0;
+            for (size_t i = 0; i < 200000; i++) {
+                const uint32_t ip = 0x0a000000 + rd() % 5000;
+                switch (rd() % 4) {
+                    case 0:
+                    case 1: {
+                        const uint64_t expiry = now + 1 + rd() % 1000;
+                        table.insert(ip, ethernet_for(ip + i), expiry);
+                        reference[ip] = {ethernet_for(ip + i), expiry};
+                        break;
+                    }
+                    case 2: {
+                        test_should_be(table.erase(ip), reference.erase(ip) > 0);
+                        break;
+                    }
+                    case 3: {
+                        now += rd() % 3;
+                        table.expire(now);
+                        for (auto it = reference.begin(); it != reference.end();) {
+                            it = it->second.second <= now ? reference.erase(it) : next(it);
+                        }
+                        test_should_be(table.size(), reference.size());
+                        break;
+                    }
+                }
+                const auto found = table.lookup(ip, now);
+                const auto expected = reference.find(ip);
+                test_should_be(found.has_value(), expected != reference.end() and expected->second.second > now);
+                if (found.has_value()) {
+                    test_should_be(found.value() == expected->second.first, true);
+                }
+            }
+            test_should_be(table.capacity() >= 2 * table.size(), true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+#include "allocation_counter.hh"
+#include "network_interface_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+//! Most allocations to forward a datagram (each frame's headers and Buffer list, and the like); copying
+//! the datagram would also need one at least as large as its payload
+static constexpr size_t MAX_ALLOCATIONS = 10;
+
+static const EthernetAddress local_eth{0x02, 0, 0, 0, 0, 1};
+static const EthernetAddress remote_eth{0x02, 0, 0, 0, 0, 2};
+static constexpr size_t payload_size = 20000;
+
+static EthernetFrame arp_reply(const string &sender_ip) {
+    return make_frame(remote_eth,
+                      local_eth,
+                      EthernetHeader::TYPE_ARP,
+                      make_arp(ARPMessage::OPCODE_REPLY, remote_eth, sender_ip, local_eth, "10.0.0.1").serialize());
+}
+
+static EthernetFrame large_datagram_frame() {
+    InternetDatagram dgram = make_datagram("1.2.3.4", "5.6.7.8");
+    dgram.payload() = string(payload_size, 'x');
+    dgram.header().len = dgram.header().hlen * 4 + payload_size;
+    return make_frame(remote_eth, local_eth, EthernetHeader::TYPE_IPv4, dgram.serialize());
+}
+
+//! The payload of a frame sent out should be the bytes of the frame received, not a copy of them
+static void expect_shared(const EthernetFrame &in, const EthernetFrame &out) {
+    const string_view received = in.payload().buffers().front().str();
+    const string_view sent = out.payload().buffers().back().str();
+    test_should_be(sent.size(), payload_size);
+    test_should_be(sent.data() == received.data() + received.size() - payload_size, true);
+}
+
+int main() {
+    try {
+        NetworkInterfaceTestHarness test{"forwarding without copies", local_eth, Address("10.0.0.1", 0)};
+        test.execute(ReceiveFrame{arp_reply("10.0.0.2"), {}});
+        NetworkInterface &iface = test.interface();
+
+        // forwarding to a known neighbor (steps allocate for their descriptions, so this calls the interface)
+        {
+            const EthernetFrame in = large_datagram_frame();
+            AllocationCounter counter;
+            auto dgram = iface.recv_frame(in);
+            dgram.value().header().ttl--;
+            iface.send_datagram(move(dgram.value()), Address("10.0.0.2", 0));
+            EthernetFrame out = move(iface.frames_out().front());
+            iface.frames_out().pop();
+            counter.stop();
+
+            expect_shared(in, out);
+            test_should_be(counter.largest() < payload_size / 10, true);
+            test_should_be(counter.allocations() <= MAX_ALLOCATIONS, true);
+        }
+
+        // forwarding to a neighbor that has to be looked up first
+        {
+            const EthernetFrame in = large_datagram_frame();
+            test.execute(SendDatagram{iface.recv_frame(in).value(), Address("10.0.0.3", 0)});
+            test.execute(ExpectFrame{make_frame(
+                local_eth,
+                ETHERNET_BROADCAST,
+                EthernetHeader::TYPE_ARP,
+                make_arp(ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.3").serialize())});
+
+            const EthernetFrame reply = arp_reply("10.0.0.3");
+            AllocationCounter counter;
+            iface.recv_frame(reply);
+            EthernetFrame out = move(iface.frames_out().front());
+            iface.frames_out().pop();
+            counter.stop();
+
+            expect_shared(in, out);
+            test_should_be(counter.largest() < payload_size / 10, true);
+            test_should_be(counter.allocations() <= MAX_ALLOCATIONS, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+#include "network_interface_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const EthernetAddress local_eth{0x02, 0, 0, 0, 0, 1};
+static const EthernetAddress remote_eth{0x02, 0, 0, 0, 0, 2};
+static const Address local_ip{"10.0.0.1", 0};
+static const Address neighbor{"10.0.0.9", 0};
+
+static InternetDatagram numbered_datagram(const uint16_t id) {
+    InternetDatagram dgram = make_datagram(local_ip.ip(), "1.2.3.4");
+    dgram.header().id = id;
+    return dgram;
+}
+
+static EthernetFrame arp_request(const Address &target) {
+    return make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        make_arp(ARPMessage::OPCODE_REQUEST, local_eth, local_ip.ip(), {}, target.ip()).serialize());
+}
+
+static EthernetFrame arp_reply() {
+    return make_frame(
+        remote_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        make_arp(ARPMessage::OPCODE_REPLY, remote_eth, neighbor.ip(), local_eth, local_ip.ip()).serialize());
+}
+
+static EthernetFrame to_neighbor(const uint16_t id) {
+    return make_frame(local_eth, remote_eth, EthernetHeader::TYPE_IPv4, numbered_datagram(id).serialize());
+}
+
+int main() {
+    try {
+        {
+            NetworkInterfaceTestHarness test{"ARP requests back off, then the neighbor is given up on for a while",
+                                             local_eth,
+                                             local_ip};
+            NetworkInterface &iface = test.interface();
+            test.execute(SendDatagram{numbered_datagram(1), neighbor});
+            test.execute(ExpectFrame{arp_request(neighbor)});
+            test.execute(ExpectNoFrame{});
+            test_should_be(iface.time_until_next_event().value(), NetworkInterface::MAX_RETX_WAITING_TIME);
+
+            test.execute(Tick{4999});
+            test.execute(ExpectNoFrame{});
+            test.execute(Tick{1});
+            test.execute(ExpectFrame{arp_request(neighbor)});
+            test.execute(SendDatagram{numbered_datagram(2), neighbor});  // doesn't hurry the next request
+            test.execute(Tick{9999});
+            test.execute(ExpectNoFrame{});
+            test.execute(Tick{1});
+            test.execute(ExpectFrame{arp_request(neighbor)});
+            test_should_be(iface.pending(), size_t{2});
+
+            test.execute(Tick{20000});
+            test.execute(ExpectNoFrame{});
+            test_should_be(iface.pending(), size_t{0});
+            test_should_be(iface.unreachable(), size_t{1});
+            test_should_be(iface.pending_drops().unreachable, uint64_t{2});
+
+            test.execute(SendDatagram{numbered_datagram(3), neighbor});
+            test.execute(ExpectNoFrame{});
+            test_should_be(iface.pending_drops().unreachable, uint64_t{3});
+
+            test.execute(Tick{NetworkInterface::UNREACHABLE_TIME});
+            test_should_be(iface.unreachable(), size_t{0});
+            test.execute(SendDatagram{numbered_datagram(4), neighbor});
+            test.execute(ExpectFrame{arp_request(neighbor)});
+        }
+
+        {
+            NetworkInterfaceTestHarness test{
+                "an unreachable neighbor that speaks up is reachable again", local_eth, local_ip};
+            test.execute(SendDatagram{numbered_datagram(1), neighbor});
+            for (size_t ms = 0; ms < 35000; ms += 1000) {
+                test.execute(Tick{1000});
+            }
+            for (size_t i = 0; i < 3; i++) {
+                test.execute(ExpectFrame{arp_request(neighbor)});
+            }
+            test.execute(ExpectNoFrame{});
+            test_should_be(test.interface().unreachable(), size_t{1});
+
+            test.execute(ReceiveFrame{arp_reply(), {}});
+            test_should_be(test.interface().unreachable(), size_t{0});
+            test.execute(SendDatagram{numbered_datagram(2), neighbor});
+            test.execute(ExpectFrame{to_neighbor(2)});
+        }
+
+        {
+            NetworkInterfaceTestHarness test{"a neighbor keeps only its newest datagrams", local_eth, local_ip};
+            NetworkInterface &iface = test.interface();
+            const size_t sent = NetworkInterface::MAX_PENDING_PER_NEIGHBOR + 5;
+            for (size_t i = 0; i < sent; i++) {
+                test.execute(SendDatagram{numbered_datagram(i), neighbor});
+            }
+            test_should_be(iface.pending(), NetworkInterface::MAX_PENDING_PER_NEIGHBOR);
+            test_should_be(iface.pending_drops().neighbor_full, uint64_t{5});
+            test.execute(ExpectFrame{arp_request(neighbor)});
+
+            test.execute(ReceiveFrame{arp_reply(), {}});
+            test_should_be(iface.pending(), size_t{0});
+            for (size_t i = 5; i < sent; i++) {
+                test.execute(ExpectFrame{to_neighbor(i)});
+            }
+            test.execute(ExpectNoFrame{});
+        }
+
+        {
+            NetworkInterfaceTestHarness test{
+                "a sweep of a dead subnet stays within the limits, and sends an ARP request only for what it keeps",
+                local_eth,
+                local_ip};
+            NetworkInterface &iface = test.interface();
+            const uint32_t sweep = 100000;
+            const auto swept = [](const uint32_t i) { return Address::from_ipv4_numeric(0x0b000000 + i); };
+            for (uint32_t i = 0; i < sweep; i++) {
+                test.execute(SendDatagram{numbered_datagram(0), swept(i)});
+            }
+            test_should_be(iface.pending(), NetworkInterface::MAX_PENDING);
+            for (uint32_t i = 0; i < NetworkInterface::MAX_PENDING; i++) {
+                test.execute(ExpectFrame{arp_request(swept(i))});
+            }
+            test.execute(ExpectNoFrame{});
+            test_should_be(iface.pending_drops().all_full, uint64_t{sweep - NetworkInterface::MAX_PENDING});
+
+            for (size_t ms = 0; ms < 35000; ms += 1000) {
+                test.execute(Tick{1000});
+            }
+            for (size_t retry = 0; retry < 2; retry++) {
+                for (uint32_t i = 0; i < NetworkInterface::MAX_PENDING; i++) {
+                    test.execute(ExpectFrame{arp_request(swept(i))});
+                }
+            }
+            test.execute(ExpectNoFrame{});
+            test_should_be(iface.pending(), size_t{0});
+            test_should_be(iface.unreachable(), NetworkInterface::MAX_PENDING);
+
+            test.execute(Tick{NetworkInterface::UNREACHABLE_TIME});
+            test_should_be(iface.unreachable(), size_t{0});
+            test_should_be(iface.time_until_next_event().has_value(), false);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,9 +1,31 @@
 #ifndef SPONGE_NETWORK_INTERFACE_HARNESS_HH
 #define SPONGE_NETWORK_INTERFACE_HARNESS_HH
 
+#include "arp_message.hh"
 #include "network_interface.hh"
 
 #include <exception>
+#include <string>
+
+EthernetAddress random_private_ethernet_address();
+
+//! A datagram from `src_ip` to `dst_ip` carrying "hello"
+InternetDatagram make_datagram(const std::string &src_ip, const std::string &dst_ip);
+
+ARPMessage make_arp(const uint16_t opcode,
+                    const EthernetAddress sender_ethernet_address,
+                    const std::string sender_ip_address,
+                    const EthernetAddress target_ethernet_address,
+                    const std::string target_ip_address);
+
+//! A frame as it comes off the wire: one Buffer holding the Ethernet payload
+EthernetFrame make_frame(const EthernetAddress &src,
+                         const EthernetAddress &dst,
+                         const uint16_t type,
+                         const BufferList payload);
+
+//! A frame that was sent, as it would come off the wire (see make_frame())
+EthernetFrame wire(const EthernetFrame &frame);
 
 struct NetworkInterfaceTestStep {
     virtual operator std::string() const;
@@ -86,9 +108,13 @@ class NetworkInterfaceTestHarness {
   public:
     NetworkInterfaceTestHarness(const std::string &test_name,
                                 const EthernetAddress &ethernet_address,
-                                const Address &ip_address);
+                                const Address &ip_address,
+                                const size_t mtu = NetworkInterface::NO_FRAGMENTS);
 
     void execute(const NetworkInterfaceTestStep &step);
+
+    //! The interface under test, for checking what the steps don't (its counters, say)
+    NetworkInterface &interface() { return _interface; }
 };
 
 #endif  // SPONGE_NETWORK_INTERFACE_HARNESS_HH
@@ -0,0 +1,115 @@
+#include "ipv4_header.hh"
+#include "queue_workers.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t queues = 3;
+static constexpr uint16_t flows = 60;
+static constexpr size_t frames_per_flow = 5;
+
+//! An IPv4 datagram with the start of a UDP header from port `sport` to port `dport`
+static string udp_datagram(const uint32_t src, const uint16_t sport, const uint32_t dst, const uint16_t dport) {
+    IPv4Header header;
+    header.proto = 17;
+    header.src = src;
+    header.dst = dst;
+    header.len = IPv4Header::LENGTH + 4;
+    const string ports{char(sport >> 8), char(sport & 0xff), char(dport >> 8), char(dport & 0xff)};
+    return header.serialize() + ports;
+}
+
+int main() {
+    try {
+        const string there = udp_datagram(0x0a000001, 1000, 0x0a000002, 80);
+        const string back = udp_datagram(0x0a000002, 80, 0x0a000001, 1000);
+        if (not QueueWorkers::tun_flow(there).has_value() or
+            QueueWorkers::tun_flow(there) != QueueWorkers::tun_flow(back)) {
+            throw runtime_error("both directions of a flow should hash the same");
+        }
+        if (QueueWorkers::tun_flow(there) == QueueWorkers::tun_flow(udp_datagram(0x0a000001, 1001, 0x0a000002, 80))) {
+            throw runtime_error("different ports should (here) hash differently");
+        }
+        if (QueueWorkers::tun_flow("not a datagram").has_value() or QueueWorkers::tap_flow(there).has_value()) {
+            throw runtime_error("only IPv4 datagrams should have a flow");
+        }
+
+        // each "queue" is a socket pair: the workers have one end, and the test plays the kernel at the other
+        vector<FileDescriptor> worker_ends, kernel_ends;
+        for (size_t i = 0; i < queues; i++) {
+            int fds[2];
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, static_cast<int *>(fds)));
+            worker_ends.emplace_back(fds[0]);
+            kernel_ends.emplace_back(fds[1]);
+        }
+
+        // each shard's state is only touched by its own thread, so it needs no lock
+        vector<map<uint16_t, size_t>> seen(queues);
+        vector<thread::id> threads(queues);
+        QueueWorkers workers{move(worker_ends), [&](const size_t shard, FileDescriptor &queue, string &&frame) {
+                                 if (threads[shard] == thread::id{}) {
+                                     threads[shard] = this_thread::get_id();
+                                 } else if (threads[shard] != this_thread::get_id()) {
+                                     throw runtime_error("shard handled on two threads");
+                                 }
+                                 seen[shard][uint16_t(uint8_t(frame[20]) << 8 | uint8_t(frame[21]))]++;
+                                 queue.write(frame);
+                             }};
+        workers.start();
+
+        // the kernel's choice of queue isn't ours, so send each frame to whichever queue
+        vector<size_t> expected(queues);
+        for (size_t round = 0; round < frames_per_flow; round++) {
+            for (uint16_t port = 0; port < flows; port++) {
+                const string frame = udp_datagram(0x0a000001, 2000 + port, 0x0a000002, 80);
+                kernel_ends[(port + round) % queues].write(frame);
+                expected[workers.shard_of(QueueWorkers::tun_flow(frame))]++;
+            }
+        }
+        kernel_ends[1].write("ARP?");
+        expected[0]++;
+
+        // every frame is echoed on the queue of the shard that owns its flow
+        for (size_t i = 0; i < queues; i++) {
+            for (size_t n = 0; n < expected[i]; n++) {
+                const string frame = kernel_ends[i].read();
+                if (workers.shard_of(QueueWorkers::tun_flow(frame)) != i) {
+                    throw runtime_error("frame echoed on queue " + to_string(i) + " of the wrong shard");
+                }
+            }
+        }
+        workers.stop();
+
+        size_t total = 0;
+        for (size_t i = 0; i < queues; i++) {
+            for (const auto &[port, count] : seen[i]) {
+                if (port >= 2000 and count != frames_per_flow) {
+                    throw runtime_error("flow from port " + to_string(port) + " handled " + to_string(count) +
+                                        " times by shard " + to_string(i));
+                }
+                total += count;
+            }
+        }
+        if (total != flows * frames_per_flow + 1 or workers.frames() != total) {
+            throw runtime_error("expected every frame to be handled once");
+        }
+        if (workers.handoffs() == 0) {
+            throw runtime_error("frames on another shard's queue should have been handed over");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
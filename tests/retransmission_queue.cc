@@ -0,0 +1,68 @@
+#include "retransmission_queue.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static TCPSegment make_segment(const bool syn, const string &payload, const bool fin) {
+    TCPSegment seg;
+    seg.header().syn = syn;
+    seg.header().fin = fin;
+    seg.payload() = Buffer(string(payload));
+    return seg;
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{1000};
+        RetransmissionQueue q;
+
+        // SYN at 0, "abcd" at 1..4, "efgh"+FIN at 5..9
+        q.push(0, make_segment(true, "", false));
+        q.push(1, make_segment(false, "abcd", false));
+        q.push(5, make_segment(false, "efgh", true));
+        test_should_be(q.size(), size_t{3});
+
+        // lookup by sequence number
+        test_should_be(q.find(0)->syn, true);
+        test_should_be(q.find(3)->seqno, uint64_t{1});
+        test_should_be(q.find(9)->fin, true);
+        test_should_be(q.find(10) == nullptr, true);
+
+        // an ACK for the SYN and half of "abcd"
+        q.ack(3);
+        test_should_be(q.size(), size_t{2});
+        test_should_be(q.front().seqno, uint64_t{3});
+        test_should_be(q.front().payload.copy() == "cd", true);
+        test_should_be(q.find(2) == nullptr, true);
+
+        // only the unacknowledged tail is retransmitted
+        const TCPSegment retx = RetransmissionQueue::segment(q.front(), isn);
+        test_should_be(retx.header().seqno, isn + 3);
+        test_should_be(retx.payload().copy() == "cd", true);
+
+        // an old ACK changes nothing
+        q.ack(1);
+        test_should_be(q.front().seqno, uint64_t{3});
+
+        // all but the FIN
+        q.ack(9);
+        test_should_be(q.size(), size_t{1});
+        test_should_be(q.front().payload.size(), size_t{0});
+        test_should_be(q.front().end(), uint64_t{10});
+        test_should_be(RetransmissionQueue::segment(q.front(), isn).length_in_sequence_space(), size_t{1});
+
+        q.ack(10);
+        test_should_be(q.empty(), true);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
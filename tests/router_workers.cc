@@ -0,0 +1,133 @@
+#include "network_interface_test_harness.hh"
+#include "router.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t interfaces = 4;
+
+static uint32_t router_ip(const size_t i) { return 0x0a000001 + (i << 8); }
+static uint32_t host_ip(const size_t i) { return 0x0a000002 + (i << 8); }
+static EthernetAddress router_ethernet(const size_t i) { return {0x02, 0, 0, 0, 1, uint8_t(i)}; }
+static EthernetAddress host_ethernet(const size_t i) { return {0x02, 0, 0, 0, 2, uint8_t(i)}; }
+
+static string ip_string(const uint32_t ip) { return Address::from_ipv4_numeric(ip).ip(); }
+
+static EthernetFrame arp_reply(const size_t i) {
+    return make_frame(host_ethernet(i),
+                      router_ethernet(i),
+                      EthernetHeader::TYPE_ARP,
+                      make_arp(ARPMessage::OPCODE_REPLY,
+                               host_ethernet(i),
+                               ip_string(host_ip(i)),
+                               router_ethernet(i),
+                               ip_string(router_ip(i)))
+                          .serialize());
+}
+
+//! Datagram `id` from the host on network `from` to the one on network `to`
+static EthernetFrame datagram_frame(const size_t from, const size_t to, const uint16_t id) {
+    InternetDatagram dgram = make_datagram(ip_string(host_ip(from)), ip_string(host_ip(to)));
+    dgram.header().id = id;
+    dgram.payload() = "datagram " + to_string(id);
+    dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+    return make_frame(host_ethernet(from), router_ethernet(from), EthernetHeader::TYPE_IPv4, dgram.serialize());
+}
+
+int main() {
+    try {
+        Router router;
+        for (size_t i = 0; i < interfaces; i++) {
+            router.add_interface({router_ethernet(i), Address::from_ipv4_numeric(router_ip(i))});
+            router.add_route(router_ip(i) & 0xffffff00, 24, {}, i);
+        }
+        for (size_t i = 0; i < interfaces; i++) {
+            router.interface(i).recv_frame(arp_reply(i));
+        }
+
+        // each host sends to the next, so every datagram goes from one worker to the other
+        constexpr uint16_t count = 20000;
+        router.start(2);
+        for (uint16_t id = 0; id < count; id++) {
+            for (size_t i = 0; i < interfaces; i++) {
+                router.deliver_frame(i, datagram_frame(i, (i + 1) % interfaces, id));
+            }
+        }
+
+        vector<uint16_t> next_id(interfaces, 0);
+        const auto receive = [&](const size_t i) {
+            for (auto &frames = router.interface(i).frames_out(); not frames.empty(); frames.pop()) {
+                const EthernetFrame &frame = frames.front();
+                InternetDatagram dgram;
+                if (dgram.parse(frame.payload().concatenate()) != ParseResult::NoError) {
+                    throw runtime_error("bad datagram out of interface " + to_string(i));
+                }
+                if (frame.header().dst != host_ethernet(i) or dgram.header().dst != host_ip(i) or
+                    dgram.header().ttl != IPv4Header::DEFAULT_TTL - 1 or dgram.header().id != next_id[i]) {
+                    throw runtime_error("interface " + to_string(i) + " sent datagram " +
+                                        to_string(dgram.header().id) + " instead of " + to_string(next_id[i]));
+                }
+                next_id[i]++;
+            }
+        };
+
+        size_t received = 0;
+        while (received < count * interfaces) {
+            received = 0;
+            for (size_t i = 0; i < interfaces; i++) {
+                receive(i);
+                received += next_id[i];
+            }
+        }
+
+        // a worker asks for an address it doesn't know, and learns the answer
+        EthernetFrame to_stranger = datagram_frame(0, 1, 0);
+        InternetDatagram dgram;
+        test_should_be(dgram.parse(to_stranger.payload().concatenate()) == ParseResult::NoError, true);
+        dgram.header().dst = host_ip(3) + 1;
+        to_stranger.payload() = BufferList{Buffer{dgram.serialize().concatenate()}};
+        router.deliver_frame(0, move(to_stranger));
+        auto &frames_out = router.interface(3).frames_out();
+        while (frames_out.empty()) {
+        }
+        ARPMessage request;
+        test_should_be(request.parse(frames_out.front().payload()) == ParseResult::NoError, true);
+        test_should_be(request.opcode, ARPMessage::OPCODE_REQUEST);
+        test_should_be(request.target_ip_address, host_ip(3) + 1);
+        frames_out.pop();
+        EthernetFrame reply = arp_reply(3);
+        ARPMessage answer;
+        test_should_be(answer.parse(reply.payload()) == ParseResult::NoError, true);
+        answer.sender_ip_address++;
+        reply.payload() = BufferList{answer.serialize()};
+        router.deliver_frame(3, move(reply));
+        while (frames_out.empty()) {
+        }
+        test_should_be(frames_out.front().header().type, EthernetHeader::TYPE_IPv4);
+        frames_out.pop();
+
+        // what is delivered before stop() is still forwarded
+        for (size_t i = 0; i < interfaces; i++) {
+            router.deliver_frame(i, datagram_frame(i, (i + 1) % interfaces, count));
+        }
+        router.stop();
+        for (size_t i = 0; i < interfaces; i++) {
+            receive(i);
+        }
+        test_should_be(next_id[0], uint16_t(count + 1));
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include "arp_message.hh"
+#include "network_interface.hh"
+#include "spsc_queue.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+int main() {
+    try {
+        // FIFO across segments, reusing them as they empty
+        {
+            SpscQueue<string> queue;
+            test_should_be(queue.empty(), true);
+            for (size_t round = 0; round < 3; round++) {
+                for (size_t i = 0; i < 3 * SpscQueue<string>::SEGMENT_SIZE + 5; i++) {
+                    queue.push(to_string(i));
+                }
+                test_should_be(queue.size(), 3 * SpscQueue<string>::SEGMENT_SIZE + 5);
+                for (size_t i = 0; i < 3 * SpscQueue<string>::SEGMENT_SIZE + 5; i++) {
+                    test_should_be(queue.front() == to_string(i), true);
+                    queue.pop();
+                }
+                test_should_be(queue.empty(), true);
+            }
+
+            queue.push("moved");
+            SpscQueue<string> moved{move(queue)};
+            test_should_be(queue.empty(), true);
+            test_should_be(moved.front() == "moved", true);
+        }
+
+        // a producer and a consumer thread at once
+        {
+            SpscQueue<uint64_t> queue;
+            constexpr uint64_t count = 2000000;
+            thread producer{[&] {
+                for (uint64_t i = 1; i <= count; i++) {
+                    queue.push(i);
+                }
+            }};
+            uint64_t expected = 1;
+            while (expected <= count) {
+                if (not queue.empty()) {
+                    if (queue.front() != expected) {
+                        throw runtime_error("element " + to_string(expected) + " arrived as " +
+                                            to_string(queue.front()));
+                    }
+                    queue.pop();
+                    expected++;
+                }
+            }
+            producer.join();
+            test_should_be(queue.empty(), true);
+        }
+
+        // a NetworkInterface's frames drained by another thread while it sends
+        {
+            const EthernetAddress local_eth{0x02, 0, 0, 0, 0, 1};
+            NetworkInterface iface{local_eth, Address("10.0.0.1", 0)};
+            ARPMessage arp;
+            arp.opcode = ARPMessage::OPCODE_REPLY;
+            arp.sender_ethernet_address = {0x02, 0, 0, 0, 0, 2};
+            arp.sender_ip_address = Address("10.0.0.2", 0).ipv4_numeric();
+            arp.target_ethernet_address = local_eth;
+            arp.target_ip_address = Address("10.0.0.1", 0).ipv4_numeric();
+            EthernetFrame reply;
+            reply.header().src = arp.sender_ethernet_address;
+            reply.header().dst = local_eth;
+            reply.header().type = EthernetHeader::TYPE_ARP;
+            reply.payload() = arp.serialize();
+            iface.recv_frame(reply);
+
+            constexpr uint16_t count = 50000;
+            thread sender{[&] {
+                for (uint16_t i = 0; i < count; i++) {
+                    InternetDatagram dgram;
+                    dgram.header().id = i;
+                    dgram.header().len = dgram.header().hlen * 4;
+                    iface.send_datagram(move(dgram), Address("10.0.0.2", 0));
+                }
+            }};
+            uint16_t expected = 0;
+            while (expected < count) {
+                auto &frames = iface.frames_out();
+                if (frames.empty()) {
+                    continue;
+                }
+                InternetDatagram dgram;
+                if (dgram.parse(frames.front().payload().concatenate()) != ParseResult::NoError or
+                    dgram.header().id != expected) {
+                    throw runtime_error("frame " + to_string(expected) + " is missing or out of order");
+                }
+                frames.pop();
+                expected++;
+            }
+            sender.join();
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
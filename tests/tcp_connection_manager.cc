@@ -0,0 +1,237 @@
+#include "tcp_connection_manager.hh"
+#include "util.hh"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+static constexpr size_t connections = 50;
+static constexpr uint16_t server_port = 1234;
+static constexpr uint16_t unaccepted_port = 4321;
+static constexpr size_t backlog = 2;
+
+static string message_for(const uint16_t port) {
+    return "message from port " + to_string(port) + string(port % 97, '.');
+}
+
+static void test_manager(const TCPConnectionManager::IO io) {
+    TCPConfig config;
+    config.rt_timeout = 100;
+    TCPConnectionManager server{config, Address{"127.0.0.1", 0}, io};
+    TCPConnectionManager client{config, Address{"127.0.0.1", 0}, io};
+    if (server.io() != io or client.io() != io) {
+        throw runtime_error("managers should use the I/O they were asked for");
+    }
+    server.listen(server_port);
+    server.listen(unaccepted_port, backlog);
+    server.set_accept_handler([&](const uint16_t port) {
+        if (port == server_port) {
+            while (server.accept(port)) {
+            }
+        }
+    });
+
+    // the server echoes each connection's stream back and closes when the client does
+    atomic<size_t> server_done{0};
+    map<uint16_t, string> server_received;
+    server.set_handler([&](const TCPConnectionManager::FourTuple &key, TCPConnection &tcp) {
+        if (key.local_port != server_port) {
+            throw runtime_error("server connection on port " + to_string(key.local_port));
+        }
+        auto &inbound = tcp.inbound_stream();
+        const string data = inbound.read(inbound.buffer_size());
+        server_received[key.peer_port] += data;
+        tcp.write(data);
+        if (inbound.eof() and tcp.state() == TCPState::State::CLOSE_WAIT) {
+            tcp.end_input_stream();
+        }
+        if (not tcp.active()) {
+            server_done++;
+        }
+    });
+
+    size_t client_done = 0;
+    map<uint16_t, string> client_received;
+    client.set_handler([&](const TCPConnectionManager::FourTuple &key, TCPConnection &tcp) {
+        if (key.peer_port != server_port) {
+            return;  // the connections below that don't get anywhere, whose retransmissions call the handler
+        }
+        auto &inbound = tcp.inbound_stream();
+        client_received[key.local_port] += inbound.read(inbound.buffer_size());
+        if (not tcp.active()) {
+            client_done++;
+        }
+    });
+
+    thread server_thread([&] { server.run([&] { return server_done < connections; }, 10); });
+
+    // a SYN to a port nobody listens on goes nowhere
+    const auto stray = client.connect(server.local_address(), server_port + 1);
+
+    // nobody accepts on this port, so only `backlog` connections get through the handshake
+    for (size_t i = 0; i < 2 * backlog + 1; i++) {
+        client.connect(server.local_address(), unaccepted_port);
+    }
+
+    for (size_t i = 0; i < connections; i++) {
+        const auto key = client.connect(server.local_address(), server_port);
+        TCPConnection &tcp = *client.connection(key);
+        tcp.write(message_for(key.local_port));
+        tcp.end_input_stream();
+        client.flush(key);
+    }
+
+    client.run([&] { return client_done < connections; }, 10);
+    server_thread.join();
+
+    if (client.connection(stray) == nullptr or client.connection(stray)->state() != TCPState::State::SYN_SENT) {
+        throw runtime_error("connection to a port without a listener should still be waiting for a SYN/ACK");
+    }
+    if (server_received.size() != connections or client_received.size() != connections) {
+        throw runtime_error("expected " + to_string(connections) + " connections at each end");
+    }
+    for (const auto &[port, data] : server_received) {
+        if (data != message_for(port)) {
+            throw runtime_error("server got \"" + data + "\" on the connection from port " + to_string(port));
+        }
+        if (client_received.at(port) != data) {
+            throw runtime_error("client port " + to_string(port) + " got back \"" + client_received.at(port) +
+                                "\"");
+        }
+    }
+    if (server.size() != backlog) {
+        throw runtime_error("server should only have the unaccepted connections left, but has " +
+                            to_string(server.size()));
+    }
+    if (server.syns_dropped() < backlog + 1) {
+        throw runtime_error("expected SYNs beyond the backlog to be dropped");
+    }
+    for (size_t i = 0; i < backlog; i++) {
+        const auto key = server.accept(unaccepted_port);
+        if (not key.has_value() or server.connection(key.value())->state() != TCPState::State::ESTABLISHED) {
+            throw runtime_error("an established connection should have been waiting to be accepted");
+        }
+    }
+    if (server.accept(unaccepted_port).has_value() or server.accept(server_port).has_value()) {
+        throw runtime_error("accept queues should be empty");
+    }
+}
+
+//! Take turns running `a` and `b`, one short wait each, until `done` (or a second has gone by)
+static void pump(TCPConnectionManager &a, TCPConnectionManager &b, const function<bool()> &done) {
+    for (size_t i = 0; i < 100 and not done(); i++) {
+        for (auto *manager : {&a, &b}) {
+            bool waited = false;
+            manager->run([&] { return not exchange(waited, true); }, 5);
+        }
+    }
+}
+
+// the backlog counts half-open and queued connections together, so the accept queue never outgrows it
+static void test_backlog(const TCPConnectionManager::IO io) {
+    TCPConfig config;
+    config.rt_timeout = 50;
+    TCPConnectionManager server{config, Address{"127.0.0.1", 0}, io};
+    TCPConnectionManager client{config, Address{"127.0.0.1", 0}, io};
+    server.listen(unaccepted_port, backlog);
+    size_t ready = 0;
+    server.set_accept_handler([&](const uint16_t) { ready++; });
+
+    // one connection waits in the accept queue...
+    client.connect(server.local_address(), unaccepted_port);
+    pump(server, client, [&] { return ready == 1; });
+    if (ready != 1) {
+        throw runtime_error("first connection should have been ready to accept");
+    }
+
+    // ...so of the SYNs that arrive together now, only one more fits
+    for (size_t i = 0; i < backlog + 1; i++) {
+        client.connect(server.local_address(), unaccepted_port);
+    }
+    const uint64_t until = timestamp_ms() + 4 * config.rt_timeout;
+    pump(server, client, [&] { return ready > backlog or timestamp_ms() > until; });
+    if (ready != backlog or server.size() != backlog) {
+        throw runtime_error("expected " + to_string(backlog) + " connections to get through, but " +
+                            to_string(ready) + " did");
+    }
+    if (server.syns_dropped() < backlog) {
+        throw runtime_error("expected SYNs beyond the backlog to be dropped");
+    }
+    for (size_t i = 0; i < backlog; i++) {
+        if (not server.accept(unaccepted_port).has_value()) {
+            throw runtime_error("an established connection should have been waiting to be accepted");
+        }
+    }
+    if (server.accept(unaccepted_port).has_value()) {
+        throw runtime_error("accept queue should be empty");
+    }
+}
+
+// a signal ends run(), whatever the manager is waiting on
+static void test_interrupt(const TCPConnectionManager::IO io) {
+    TCPConnectionManager server{TCPConfig{}, Address{"127.0.0.1", 0}, io};
+    TCPConnectionManager client{TCPConfig{}, Address{"127.0.0.1", 0}, io};
+    server.listen(server_port);
+
+    const uint64_t start = timestamp_ms();
+    atomic<bool> running{false}, returned{false};
+    thread server_thread([&] {
+        running = true;
+        server.run([&] { return timestamp_ms() < start + 5000; }, 1000);
+        returned = true;
+    });
+    while (not running) {
+        this_thread::yield();
+    }
+
+    // datagrams for the server don't end its run()...
+    const auto key = client.connect(server.local_address(), server_port);
+    client.run([&] { return client.connection(key)->state() != TCPState::State::ESTABLISHED; }, 10);
+    if (returned) {
+        throw runtime_error("run() returned before it was interrupted");
+    }
+
+    // ...but a signal does (sent until one arrives while it waits, rather than while it handles a datagram)
+    while (not returned and timestamp_ms() < start + 2000) {
+        ::pthread_kill(server_thread.native_handle(), SIGUSR1);
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    server_thread.join();
+    if (timestamp_ms() - start > 2000) {
+        throw runtime_error("run() wasn't interrupted by a signal");
+    }
+}
+
+int main() {
+    // the handler does nothing, but without SA_RESTART the signal interrupts the wait
+    struct sigaction action {};
+    action.sa_handler = [](int) {};
+    sigaction(SIGUSR1, &action, nullptr);
+
+    try {
+        test_manager(TCPConnectionManager::IO::Syscalls);
+        test_backlog(TCPConnectionManager::IO::Syscalls);
+        test_interrupt(TCPConnectionManager::IO::Syscalls);
+        if (DatagramRing::available()) {
+            test_manager(TCPConnectionManager::IO::IoUring);
+            test_backlog(TCPConnectionManager::IO::IoUring);
+            test_interrupt(TCPConnectionManager::IO::IoUring);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
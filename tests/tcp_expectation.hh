@@ -11,6 +11,9 @@
 #include <exception>
 #include <optional>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 struct TCPExpectation : public TCPTestStep {
     virtual ~TCPExpectation() {}
@@ -392,6 +395,8 @@ struct SendSegment : public TCPAction {
     uint16_t win{0};
     size_t payload_size{0};
     std::string data{};
+    std::optional<uint16_t> mss{};
+    std::optional<TCPTimestamps> timestamps{};
 
     SendSegment() {}
 
@@ -404,6 +409,8 @@ struct SendSegment : public TCPAction {
         ackno = seg.header().ackno;
         win = seg.header().win;
         data = seg.payload();
+        mss = seg.header().mss;
+        timestamps = seg.header().timestamps;
     }
 
     SendSegment &with_ack(bool ack_) {
@@ -455,6 +462,16 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_mss(uint16_t mss_) {
+        mss = mss_;
+        return *this;
+    }
+
+    SendSegment &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        timestamps = TCPTimestamps{tsval, tsecr};
+        return *this;
+    }
+
     TCPSegment get_segment() const {
         TCPSegment data_seg;
         data_seg.payload() = std::string(data);
@@ -466,6 +483,9 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.mss = mss;
+        data_hdr.timestamps = timestamps;
+        data_hdr.doff = (TCPHeader::LENGTH + data_hdr.options_length()) / 4;
         return data_seg;
     }
 
@@ -489,6 +509,29 @@ struct SendSegment : public TCPAction {
     }
 };
 
+//! Segments that arrive together, all received before the TCPConnection sends anything (as with a batch
+//! read by TCPSpongeSocket)
+struct SendSegments : public TCPAction {
+    std::vector<SendSegment> segments;
+
+    explicit SendSegments(std::vector<SendSegment> segments_) : segments(std::move(segments_)) {}
+
+    std::string description() const {
+        std::ostringstream o;
+        o << segments.size() << " packets arrive together:";
+        for (const auto &segment : segments) {
+            o << "\n\t\t" << segment.description();
+        }
+        return o.str();
+    }
+
+    void execute(TCPTestHarness &harness) const {
+        for (const auto &segment : segments) {
+            harness._fsm.segment_received(segment.get_segment());
+        }
+    }
+};
+
 struct Write : public TCPAction {
     std::string data;
     std::optional<size_t> _bytes_written{};
@@ -564,4 +607,31 @@ struct Close : public TCPAction {
     void execute(TCPTestHarness &harness) const { harness._fsm.end_input_stream(); }
 };
 
+struct Cork : public TCPAction {
+    std::string description() const { return "cork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.cork(); }
+};
+
+struct Uncork : public TCPAction {
+    std::string description() const { return "uncork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.uncork(); }
+};
+
+struct Read : public TCPAction {
+    size_t len;
+
+    Read(size_t len_) : len(len_) {}
+
+    std::string description() const { return "read " + std::to_string(len) + " bytes"; }
+
+    void execute(TCPTestHarness &harness) const {
+        const std::string data = harness._fsm.inbound_stream().read(len);
+        if (data.size() != len) {
+            throw TCPExpectationViolation("only " + std::to_string(data.size()) + " of " + std::to_string(len) +
+                                          " bytes could be read");
+        }
+        harness._fsm.inbound_stream_read();
+    }
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_EXPECTATION_HH
@@ -37,6 +37,9 @@ struct Tick;
 struct Connect;
 struct Listen;
 struct Close;
+struct Cork;
+struct Uncork;
+struct Read;
 
 class TCPExpectationViolation : public std::runtime_error {
   public:
@@ -0,0 +1,103 @@
+#include "tcp_over_ip.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! A datagram from 10.0.0.2:80 to 10.0.0.1:1000 (the adapter's peer and itself), with a segment from `seg`
+static InternetDatagram datagram_for(TCPSegment seg) {
+    TCPOverIPv4Adapter peer;
+    peer.config_mut().source = {"10.0.0.2", 80};
+    peer.config_mut().destination = {"10.0.0.1", 1000};
+    InternetDatagram dgram = peer.wrap_tcp_in_ip(seg);
+    InternetDatagram parsed;
+    parsed.parse(dgram.serialize().concatenate());
+    return parsed;
+}
+
+//! The same datagram with one byte of its segment changed
+static InternetDatagram damaged(const InternetDatagram &dgram, const size_t offset) {
+    string segment = dgram.payload().concatenate();
+    segment.at(offset) ^= 1;
+    InternetDatagram ret = dgram;
+    ret.payload() = move(segment);
+    return ret;
+}
+
+int main() {
+    try {
+        TCPOverIPv4Adapter adapter;
+        adapter.config_mut().source = {"10.0.0.1", 1000};
+        adapter.config_mut().destination = {"10.0.0.2", 80};
+
+        TCPSegment seg;
+        seg.header().ack = true;
+        seg.payload() = string{"hello"};
+        const InternetDatagram good = datagram_for(seg);
+
+        // peek at the ports and flags without parsing
+        const auto fields = TCPHeader::peek(good.payload().concatenate());
+        test_should_be(fields.has_value(), true);
+        test_should_be(fields->sport, uint16_t{80});
+        test_should_be(fields->dport, uint16_t{1000});
+        test_should_be(fields->ack, true);
+        test_should_be(fields->syn, false);
+        test_should_be(TCPHeader::peek(string(13, 0)).has_value(), false);
+
+        test_should_be(adapter.unwrap_tcp_in_ip(good).has_value(), true);
+
+        // each stage turns away what it can see is not for us, before anything costlier is done
+        InternetDatagram elsewhere = good;
+        elsewhere.header().dst++;
+        test_should_be(adapter.unwrap_tcp_in_ip(elsewhere).has_value(), false);
+        test_should_be(adapter.unwrap_drops().wrong_address, uint64_t{1});
+
+        InternetDatagram udp = good;
+        udp.header().proto = 17;
+        test_should_be(adapter.unwrap_tcp_in_ip(udp).has_value(), false);
+        test_should_be(adapter.unwrap_drops().not_tcp, uint64_t{1});
+
+        // a damaged segment for another port counts as for another port: it was never checksummed
+        test_should_be(adapter.unwrap_tcp_in_ip(damaged(good, 1)).has_value(), false);
+        test_should_be(adapter.unwrap_drops().wrong_port, uint64_t{1});
+        test_should_be(adapter.unwrap_drops().bad_checksum, uint64_t{0});
+
+        test_should_be(adapter.unwrap_tcp_in_ip(damaged(good, 24)).has_value(), false);
+        test_should_be(adapter.unwrap_drops().bad_checksum, uint64_t{1});
+        test_should_be(adapter.unwrap_tcp_in_ip(damaged(good, 24), false).has_value(), true);
+
+        InternetDatagram too_short = good;
+        too_short.payload() = string(10, 0);
+        test_should_be(adapter.unwrap_tcp_in_ip(too_short).has_value(), false);
+        test_should_be(adapter.unwrap_drops().bad_header, uint64_t{1});
+
+        // while listening, only an undamaged SYN is taken (and decides the peer)
+        TCPOverIPv4Adapter listener;
+        listener.config_mut().source = {"0", 1000};
+        listener.set_listening(true);
+        test_should_be(listener.unwrap_tcp_in_ip(good).has_value(), false);
+        test_should_be(listener.unwrap_drops().wrong_port, uint64_t{1});
+
+        TCPSegment syn;
+        syn.header().syn = true;
+        syn.header().mss = 1000;
+        syn.header().doff = (TCPHeader::LENGTH + TCPHeader::MSS_LENGTH) / 4;
+        const InternetDatagram syn_dgram = datagram_for(syn);
+        test_should_be(listener.unwrap_tcp_in_ip(damaged(syn_dgram, 21)).has_value(), false);
+        test_should_be(listener.unwrap_drops().bad_checksum, uint64_t{1});
+        test_should_be(listener.listening(), true);
+        test_should_be(listener.unwrap_tcp_in_ip(syn_dgram).has_value(), true);
+        test_should_be(listener.listening(), false);
+        test_should_be(listener.config().destination.port(), uint16_t{80});
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#include "ethernet_header.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_over_ip.hh"
+#include "util.hh"
+#include "vnet_header.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Deliver every segment `from` has queued to `to`
+static void deliver(TCPConnection &from, TCPConnection &to) {
+    for (; not from.segments_out().empty(); from.segments_out().pop()) {
+        to.segment_received(from.segments_out().front());
+    }
+}
+
+int main() {
+    try {
+        VnetHeader vnet;
+        vnet.flags = VnetHeader::FLAG_NEEDS_CSUM;
+        vnet.gso_type = VnetHeader::GSO_TCPV4;
+        vnet.hdr_len = 0x1234;
+        vnet.gso_size = 1448;
+        vnet.csum_start = 20;
+        vnet.csum_offset = 16;
+        const string serialized = vnet.serialize();
+        if (serialized.size() != VnetHeader::LENGTH or serialized[2] != 0x34 or serialized[3] != 0x12) {
+            throw runtime_error("VnetHeader should serialize to 10 little-endian bytes");
+        }
+        VnetHeader parsed;
+        NetParser p{Buffer{string(serialized)}};
+        if (parsed.parse(p) != ParseResult::NoError or parsed.gso_size != 1448 or parsed.hdr_len != 0x1234 or
+            parsed.csum_offset != 16 or parsed.flags != VnetHeader::FLAG_NEEDS_CSUM) {
+            throw runtime_error("VnetHeader didn't survive parse(serialize())");
+        }
+
+        // a device finishes a partial checksum by summing the segment, partial checksum and all
+        TCPOverIPv4Adapter adapter;
+        adapter.config_mut().source = {"10.0.0.1", 1000};
+        adapter.config_mut().destination = {"10.0.0.2", 80};
+        TCPSegment seg;
+        seg.header().seqno = WrappingInt32{12345};
+        seg.payload() = Buffer{string(10000, 'x') + "y"};
+        const InternetDatagram full = adapter.wrap_tcp_in_ip(seg);
+        const InternetDatagram partial = adapter.wrap_tcp_in_ip(seg, true);
+        InternetChecksum finished;
+        finished.add(partial.payload().concatenate());
+        TCPSegment full_parsed;
+        if (full_parsed.parse(Buffer{full.payload().concatenate()}, full.header().pseudo_cksum()) !=
+                ParseResult::NoError or
+            finished.value() != full_parsed.header().cksum) {
+            throw runtime_error("finishing the partial checksum should give the full checksum");
+        }
+        TCPSegment partial_parsed;
+        if (partial_parsed.parse(Buffer{partial.payload().concatenate()}, partial.header().pseudo_cksum()) ==
+                ParseResult::NoError or
+            partial_parsed.parse(Buffer{partial.payload().concatenate()}, partial.header().pseudo_cksum(), false) !=
+                ParseResult::NoError) {
+            throw runtime_error("a partial checksum should only parse without checking it");
+        }
+
+        // a segment larger than the MTU is for the device to cut up
+        const VnetHeader large = adapter.vnet_header_for(partial.serialize(), 0, TCPConfig::ETHERNET_MTU);
+        if (large.gso_type != VnetHeader::GSO_TCPV4 or large.gso_size != TCPConfig::MAX_PAYLOAD_SIZE or
+            large.hdr_len != 40 or large.csum_start != 20 or large.csum_offset != 16 or
+            large.flags != VnetHeader::FLAG_NEEDS_CSUM) {
+            throw runtime_error("unexpected VnetHeader for a large segment");
+        }
+        seg.payload() = Buffer{string(100, 'x')};
+        const VnetHeader small = adapter.vnet_header_for(
+            adapter.wrap_tcp_in_ip(seg, true).serialize(), EthernetHeader::LENGTH, TCPConfig::ETHERNET_MTU);
+        if (small.gso_type != VnetHeader::GSO_NONE or small.csum_start != 34) {
+            throw runtime_error("unexpected VnetHeader for a small segment");
+        }
+
+        // a peer that advertises an MSS too small for any payload is held to the smallest there can be
+        TCPOverIPv4Adapter peer;
+        peer.config_mut().source = adapter.config().destination;
+        peer.config_mut().destination = adapter.config().source;
+        TCPSegment syn;
+        syn.header().syn = true;
+        syn.header().mss = 0;
+        syn.header().doff += TCPHeader::MSS_LENGTH / 4;
+        InternetDatagram syn_dgram;
+        if (syn_dgram.parse(Buffer{peer.wrap_tcp_in_ip(syn).serialize().concatenate()}) != ParseResult::NoError or
+            not adapter.unwrap_tcp_in_ip(syn_dgram).has_value()) {
+            throw runtime_error("a SYN with an MSS of 0 should still unwrap");
+        }
+        seg.payload() = Buffer{string(1000, 'x')};
+        const VnetHeader tiny =
+            adapter.vnet_header_for(adapter.wrap_tcp_in_ip(seg, true).serialize(), 0, TCPConfig::ETHERNET_MTU);
+        if (tiny.gso_type != VnetHeader::GSO_TCPV4 or tiny.gso_size != TCPConfig::MIN_MSS) {
+            throw runtime_error("expected segments of TCPConfig::MIN_MSS, not " + to_string(tiny.gso_size));
+        }
+
+        // with TSO, the sender fills segments with whole multiples of the MSS
+        TCPConfig tso_config;
+        tso_config.tso_size = 10000;
+        TCPConnection sender{tso_config}, receiver{TCPConfig{}};
+        sender.connect();
+        deliver(sender, receiver);
+        deliver(receiver, sender);
+        sender.write(string(20000, 'x'));
+        while (sender.segments_out().front().payload().size() == 0) {
+            sender.segments_out().pop();  // the ACK of the SYN/ACK
+        }
+        const size_t first = sender.segments_out().front().payload().size();
+        if (first != 6 * TCPConfig::MAX_PAYLOAD_SIZE) {
+            throw runtime_error("expected a TSO segment of 6 MSS, not " + to_string(first) + " bytes");
+        }
+
+        // ... even of an MSS too small for any payload, which is raised to the smallest there can be
+        TCPConfig tiny_config;
+        tiny_config.mss = 0;
+        TCPConnection tso_sender{tso_config}, tiny_receiver{tiny_config};
+        tso_sender.connect();
+        deliver(tso_sender, tiny_receiver);
+        deliver(tiny_receiver, tso_sender);
+        tso_sender.write(string(20000, 'x'));
+        while (tso_sender.segments_out().front().payload().size() == 0) {
+            tso_sender.segments_out().pop();
+        }
+        const size_t tiny_first = tso_sender.segments_out().front().payload().size();
+        if (tiny_first != 10000 / TCPConfig::MIN_MSS * TCPConfig::MIN_MSS) {
+            throw runtime_error("expected a TSO segment of whole minimum MSSes, not " + to_string(tiny_first));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
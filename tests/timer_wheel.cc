@@ -0,0 +1,125 @@
+#include "test_should_be.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // timers fire in deadline order, each at its deadline, whichever level it started in
+        {
+            TimerWheel wheel{1000};
+            vector<uint64_t> fired;
+            const vector<uint64_t> delays{5, 63, 64, 65, 4095, 4096, 300000, 20000000};
+            for (const auto delay : delays) {
+                wheel.arm_after(delay, [&] { fired.push_back(wheel.now()); });
+            }
+            test_should_be(wheel.size(), delays.size());
+            test_should_be(wheel.next_deadline().value(), uint64_t{1005});
+
+            wheel.advance(1004);
+            test_should_be(fired.empty(), true);
+            wheel.advance(1005);
+            test_should_be(fired.size(), size_t{1});
+
+            wheel.advance(1000 + 4096);
+            test_should_be(fired.size(), size_t{6});
+            test_should_be(wheel.next_deadline().value(), uint64_t{1000 + 300000});
+
+            wheel.advance(1000 + 30000000);
+            test_should_be(wheel.empty(), true);
+            test_should_be(wheel.next_deadline().has_value(), false);
+            test_should_be(fired.size(), delays.size());
+            for (size_t i = 0; i < delays.size(); i++) {
+                test_should_be(fired.at(i), 1000 + delays.at(i));
+            }
+        }
+
+        // cancelled timers don't fire, and don't count towards the next deadline
+        {
+            TimerWheel wheel;
+            bool fired = false;
+            const auto id = wheel.arm(10, [&] { fired = true; });
+            wheel.arm(20, [] {});
+            test_should_be(wheel.cancel(id), true);
+            test_should_be(wheel.cancel(id), false);
+            test_should_be(wheel.next_deadline().value(), uint64_t{20});
+            wheel.advance(100);
+            test_should_be(fired, false);
+            test_should_be(wheel.empty(), true);
+        }
+
+        // a timer armed in the past fires at the next advance; callbacks can re-arm
+        {
+            TimerWheel wheel{500};
+            unsigned fired = 0;
+            function<void()> periodic = [&] {
+                if (++fired < 3) {
+                    wheel.arm_after(200, periodic);
+                }
+            };
+            wheel.arm(100, periodic);
+            test_should_be(wheel.next_deadline().value(), uint64_t{501});
+            wheel.advance(501);
+            test_should_be(fired, 1u);
+            wheel.advance(1000);
+            test_should_be(fired, 3u);
+            test_should_be(wheel.empty(), true);
+        }
+
+        // against a reference, with random arms, cancels and advances
+        {
+            auto rd = get_random_generator();
+            TimerWheel wheel;
+            multimap<uint64_t, TimerWheel::TimerId> expected;
+            uint64_t now = 0;
+            for (unsigned round = 0; round < 2000; round++) {
+                for (unsigned i = 0; i < 4; i++) {
+                    const uint64_t deadline = now + 1 + (rd() % (uint64_t{1} << (rd() % 20)));
+                    const auto id = wheel.arm(deadline, [&, deadline] {
+                        if (wheel.now() != deadline) {
+                            throw runtime_error("timer for " + to_string(deadline) + " fired at " +
+                                                to_string(wheel.now()));
+                        }
+                        expected.erase(expected.begin());
+                    });
+                    expected.emplace(deadline, id);
+                }
+                if (rd() % 4 == 0 and not expected.empty()) {
+                    auto it = expected.upper_bound(now + rd() % 10000);
+                    if (it != expected.begin()) {
+                        --it;
+                        test_should_be(wheel.cancel(it->second), true);
+                        expected.erase(it);
+                    }
+                }
+                test_should_be(wheel.size(), expected.size());
+                if (not expected.empty()) {
+                    test_should_be(wheel.next_deadline().value(), expected.begin()->first);
+                }
+                now += rd() % 5000;
+                wheel.advance(now);
+                if (not expected.empty() and expected.begin()->first <= now) {
+                    throw runtime_error("a timer due at " + to_string(expected.begin()->first) + " didn't fire by " +
+                                        to_string(now));
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
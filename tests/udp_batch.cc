@@ -0,0 +1,94 @@
+#include "socket.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t datagrams = 100;
+static constexpr size_t batch = 16;
+
+static string datagram_for(const size_t i) { return "datagram " + to_string(i) + string(i % 37, '.'); }
+
+int main() {
+    try {
+        UDPSocket receiver, sender;
+        receiver.bind(Address{"127.0.0.1", 0});
+        sender.bind(Address{"127.0.0.1", 0});
+
+        vector<string> payloads;
+        for (size_t i = 0; i < datagrams; i++) {
+            payloads.push_back(datagram_for(i));
+        }
+        const size_t syscalls = sender.send_many(receiver.local_address(), {payloads.begin(), payloads.end()});
+        if (syscalls == 0 or syscalls >= datagrams) {
+            throw runtime_error("send_many made " + to_string(syscalls) + " system calls");
+        }
+
+        // loopback delivers synchronously, so everything is waiting to be received
+        vector<UDPSocket::received_datagram> received;
+        for (size_t next = 0; next < datagrams;) {
+            const size_t count = receiver.recv_many(received, batch);
+            if (count == 0 or count > batch) {
+                throw runtime_error("recv_many received " + to_string(count));
+            }
+            for (size_t i = 0; i < count; i++, next++) {
+                if (received[i].payload != datagram_for(next) or
+                    received[i].source_address != sender.local_address()) {
+                    throw runtime_error("datagram " + to_string(next) + " was \"" + received[i].payload + "\" from " +
+                                        received[i].source_address.to_string());
+                }
+            }
+        }
+
+        // a datagram bigger than the mtu is an error, as with recv()
+        sender.sendto(receiver.local_address(), string(100, 'x'));
+        try {
+            receiver.recv_many(received, batch, 50);
+            throw logic_error("recv_many accepted an oversized datagram");
+        } catch (const runtime_error &) {
+        }
+
+        // with GSO and GRO, a train of equal-sized datagrams (and a shorter one ending it) is one send,
+        // and may be received as one datagram, but comes out as the same datagrams
+        UDPSocket gro_receiver;
+        gro_receiver.bind(Address{"127.0.0.1", 0});
+        if (sender.gso_supported() and gro_receiver.enable_gro()) {
+            vector<string> train(datagrams, string(500, 'a'));
+            for (size_t i = 0; i < datagrams; i++) {
+                train[i][0] = static_cast<char>(i);
+            }
+            train.back().resize(100);
+            train.push_back("after the train");
+            const size_t gso_syscalls =
+                sender.send_segmented(gro_receiver.local_address(), {train.begin(), train.end()});
+            if (gso_syscalls != 3) {
+                throw runtime_error("send_segmented made " + to_string(gso_syscalls) + " system calls");
+            }
+
+            for (size_t next = 0; next < train.size();) {
+                const size_t count = gro_receiver.recv_many(received, batch);
+                for (size_t i = 0; i < count; i++, next++) {
+                    if (next >= train.size() or received[i].payload != train[next]) {
+                        throw runtime_error("GRO datagram " + to_string(next) + " was " +
+                                            to_string(received[i].payload.size()) + " bytes");
+                    }
+                }
+            }
+            try {
+                gro_receiver.recv();
+                throw logic_error("recv() with GRO enabled should throw");
+            } catch (const runtime_error &) {
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}